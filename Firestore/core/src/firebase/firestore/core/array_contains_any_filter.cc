@@ -19,14 +19,13 @@
 #include <memory>
 #include <utility>
 
-#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "absl/algorithm/container.h"
 
 namespace firebase {
 namespace firestore {
 namespace core {
 
-using model::Document;
 using model::FieldPath;
 using model::FieldValue;
 
@@ -43,7 +42,7 @@ class ArrayContainsAnyFilter::Rep : public FieldFilter::Rep {
     return Type::kArrayContainsAnyFilter;
   }
 
-  bool Matches(const model::Document& doc) const override;
+  bool MatchesValue(const FieldValue& lhs) const override;
 };
 
 ArrayContainsAnyFilter::ArrayContainsAnyFilter(FieldPath field,
@@ -51,14 +50,10 @@ ArrayContainsAnyFilter::ArrayContainsAnyFilter(FieldPath field,
     : FieldFilter(std::make_shared<Rep>(std::move(field), std::move(value))) {
 }
 
-bool ArrayContainsAnyFilter::Rep::Matches(const Document& doc) const {
-  const FieldValue::Array& array_value = value().array_value();
-  absl::optional<FieldValue> maybe_lhs = doc.field(field());
-  if (!maybe_lhs) return false;
-
-  const FieldValue& lhs = *maybe_lhs;
+bool ArrayContainsAnyFilter::Rep::MatchesValue(const FieldValue& lhs) const {
   if (lhs.type() != FieldValue::Type::Array) return false;
 
+  const FieldValue::Array& array_value = value().array_value();
   for (const auto& val : lhs.array_value()) {
     if (absl::c_linear_search(array_value, val)) {
       return true;
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/core/bound.h"
 
 #include <ostream>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/order_by.h"
 #include "Firestore/core/src/firebase/firestore/immutable/append_only_list.h"
@@ -28,18 +29,27 @@ namespace firebase {
 namespace firestore {
 namespace core {
 
+using model::DocumentKey;
 using model::FieldPath;
 using model::FieldValue;
 using util::ComparisonResult;
 
-bool Bound::SortsBeforeDocument(const OrderByList& order_by,
-                                const model::Document& document) const {
-  HARD_ASSERT(position_.size() <= order_by.size(),
+namespace {
+
+/**
+ * Compares `position` against a document, using `value_at(i)` to obtain the
+ * document's value for the `i`th order by component other than the key.
+ */
+template <typename ValueAt>
+ComparisonResult CompareToDocument(const std::vector<FieldValue>& position,
+                                   const OrderByList& order_by,
+                                   const DocumentKey& key,
+                                   const ValueAt& value_at) {
+  HARD_ASSERT(position.size() <= order_by.size(),
               "Bound has more components than the provided order by.");
 
-  ComparisonResult result = ComparisonResult::Same;
-  for (size_t idx = 0; idx < position_.size(); ++idx) {
-    const FieldValue& field_value = position_[idx];
+  for (size_t idx = 0; idx < position.size(); ++idx) {
+    const FieldValue& field_value = position[idx];
     const OrderBy& ordering_component = order_by[idx];
 
     ComparisonResult comparison;
@@ -49,24 +59,44 @@ bool Bound::SortsBeforeDocument(const OrderByList& order_by,
           "Bound has a non-key value where the key path is being used %s",
           field_value.ToString());
       const auto& ref = field_value.reference_value();
-      comparison = ref.key().CompareTo(document.key());
+      comparison = ref.key().CompareTo(key);
 
     } else {
-      absl::optional<FieldValue> doc_value =
-          document.field(ordering_component.field());
+      const FieldValue* doc_value = value_at(idx);
       HARD_ASSERT(
-          doc_value.has_value(),
+          doc_value != nullptr,
           "Field should exist since document matched the orderBy already.");
       comparison = field_value.CompareTo(*doc_value);
     }
 
     comparison = ordering_component.direction().ApplyTo(comparison);
     if (!util::Same(comparison)) {
-      result = comparison;
-      break;
+      return comparison;
     }
   }
 
+  return ComparisonResult::Same;
+}
+
+}  // namespace
+
+bool Bound::SortsBeforeDocument(const OrderByList& order_by,
+                                const model::Document& document) const {
+  ComparisonResult result = CompareToDocument(
+      position_, order_by, document.key(), [&](size_t idx) {
+        return document.data().Find(order_by[idx].field());
+      });
+
+  return before_ ? result <= ComparisonResult::Same
+                 : result < ComparisonResult::Same;
+}
+
+bool Bound::SortsBeforeDocument(const OrderByList& order_by,
+                                const DocumentKey& key,
+                                const FieldValue* const* values) const {
+  ComparisonResult result = CompareToDocument(
+      position_, order_by, key, [&](size_t idx) { return values[idx]; });
+
   return before_ ? result <= ComparisonResult::Same
                  : result < ComparisonResult::Same;
 }
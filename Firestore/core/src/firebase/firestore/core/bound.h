@@ -76,6 +76,17 @@ class Bound {
   bool SortsBeforeDocument(const OrderByList& order_by,
                            const model::Document& document) const;
 
+  /**
+   * Returns true if the document with the given key comes before this bound,
+   * like `SortsBeforeDocument` above, for callers that have already looked up
+   * the document's order by fields. `values` holds the document's value for
+   * each of the first `position().size()` components of `order_by`; the
+   * entry for the key ordering is ignored.
+   */
+  bool SortsBeforeDocument(const OrderByList& order_by,
+                           const model::DocumentKey& key,
+                           const model::FieldValue* const* values) const;
+
   std::string CanonicalId() const;
 
   std::string ToString() const;
@@ -52,6 +52,7 @@ class ParsedSetData;
 class ParsedUpdateData;
 class Query;
 class QueryListener;
+class QueryMatcher;
 class SyncEngine;
 class SyncEngineCallback;
 class Target;
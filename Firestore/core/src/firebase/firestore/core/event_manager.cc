@@ -122,8 +122,23 @@ void EventManager::OnViewSnapshots(
     auto found_iter = queries_.find(query);
     if (found_iter != queries_.end()) {
       QueryListenersInfo& query_info = found_iter->second;
+      HARD_ASSERT(!snapshot.document_changes().empty() ||
+                      snapshot.sync_state_changed(),
+                  "We got a new snapshot with no changes?");
+
+      // Listeners that exclude metadata-only changes all receive the same
+      // filtered snapshot, so only filter it once.
+      absl::optional<ViewSnapshot> excluding_metadata_changes;
       for (const auto& listener : query_info.listeners) {
-        if (listener->OnViewSnapshot(snapshot)) {
+        const ViewSnapshot* listener_snapshot = &snapshot;
+        if (!listener->options().include_document_metadata_changes()) {
+          if (!excluding_metadata_changes) {
+            excluding_metadata_changes = snapshot.ExcludingMetadataChanges();
+          }
+          listener_snapshot = &excluding_metadata_changes.value();
+        }
+
+        if (listener->OnViewSnapshot(*listener_snapshot)) {
           raised_event = true;
         }
       }
@@ -20,6 +20,7 @@
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/query.h"
@@ -93,8 +94,8 @@ class EventManager : public SyncEngineCallback {
       return snapshot_;
     }
 
-    void set_view_snapshot(const absl::optional<ViewSnapshot>& snapshot) {
-      snapshot_ = snapshot;
+    void set_view_snapshot(absl::optional<ViewSnapshot> snapshot) {
+      snapshot_ = std::move(snapshot);
     }
 
    private:
@@ -30,7 +30,6 @@
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 #include "absl/algorithm/container.h"
 #include "absl/strings/str_cat.h"
-#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -142,11 +141,11 @@ bool FieldFilter::Rep::IsInequality() const {
 }
 
 bool FieldFilter::Rep::Matches(const model::Document& doc) const {
-  absl::optional<FieldValue> maybe_lhs = doc.field(field_);
-  if (!maybe_lhs) return false;
-
-  const FieldValue& lhs = *maybe_lhs;
+  const FieldValue* lhs = doc.data().Find(field_);
+  return lhs && MatchesValue(*lhs);
+}
 
+bool FieldFilter::Rep::MatchesValue(const FieldValue& lhs) const {
   // Only compare types with matching backend order (such as double and int).
   return FieldValue::Comparable(lhs.type(), value_rhs_.type()) &&
          MatchesComparison(lhs.CompareTo(value_rhs_));
@@ -60,6 +60,15 @@ class FieldFilter : public Filter {
     return field_filter_rep().value_rhs_;
   }
 
+  /**
+   * Returns true if a document whose field at `field()` holds `lhs` matches
+   * this filter. Lets callers that have already looked up the field avoid
+   * resolving it again. Not applicable to filters on the document key.
+   */
+  bool MatchesValue(const model::FieldValue& lhs) const {
+    return field_filter_rep().MatchesValue(lhs);
+  }
+
  protected:
   class Rep : public Filter::Rep {
    public:
@@ -106,6 +115,12 @@ class FieldFilter : public Filter {
      */
     Rep(model::FieldPath field, Operator op, model::FieldValue value_rhs);
 
+    /**
+     * Returns true if `lhs`, the value of `field_` in a document, satisfies
+     * this filter. `Matches` resolves the field and delegates here.
+     */
+    virtual bool MatchesValue(const model::FieldValue& lhs) const;
+
     bool MatchesComparison(util::ComparisonResult result) const;
 
    private:
@@ -113,8 +128,6 @@ class FieldFilter : public Filter {
 
     bool Equals(const Filter::Rep& other) const override;
 
-    bool MatchesValue(const model::FieldValue& lhs) const;
-
     /** The left hand side of the relation. A path into a document field. */
     model::FieldPath field_;
 
@@ -72,6 +72,7 @@ using auth::User;
 using firestore::Error;
 using local::IndexFreeQueryEngine;
 using local::LevelDbOpener;
+using local::LevelDbPersistence;
 using local::LocalSerializer;
 using local::LocalStore;
 using local::LruParams;
@@ -100,6 +101,16 @@ using util::StatusOrCallback;
 using util::ThrowIllegalState;
 using util::TimerId;
 
+namespace {
+
+// Operations requested through the public API run ahead of other work on the
+// worker queue. They all share a lane, so they still run in the order in which
+// they were requested.
+constexpr AsyncQueue::Priority kUserPriority =
+    AsyncQueue::Priority::Interactive;
+
+}  // namespace
+
 std::shared_ptr<FirestoreClient> FirestoreClient::Create(
     const DatabaseInfo& database_info,
     const api::Settings& settings,
@@ -123,16 +134,20 @@ std::shared_ptr<FirestoreClient> FirestoreClient::Create(
       // it is invoked synchronously on the calling thread. This ensures that
       // the first item enqueued on the worker queue is
       // `FirestoreClient::Initialize()`.
-      shared_client->worker_queue()->Enqueue([shared_client, user, settings] {
-        shared_client->Initialize(user, settings);
-      });
+      shared_client->worker_queue()->Enqueue(
+          kUserPriority, "firestore_client.initialize",
+          [shared_client, user, settings] {
+            shared_client->Initialize(user, settings);
+          });
     } else {
-      shared_client->worker_queue()->Enqueue([shared_client, user] {
-        shared_client->worker_queue()->VerifyIsCurrentQueue();
+      shared_client->worker_queue()->Enqueue(
+          kUserPriority, "firestore_client.credential_change",
+          [shared_client, user] {
+            shared_client->worker_queue()->VerifyIsCurrentQueue();
 
-        LOG_DEBUG("Credential Changed. Current user: %s", user.uid());
-        shared_client->sync_engine_->HandleCredentialChange(user);
-      });
+            LOG_DEBUG("Credential Changed. Current user: %s", user.uid());
+            shared_client->sync_engine_->HandleCredentialChange(user);
+          });
     }
   };
 
@@ -179,6 +194,9 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
 
     auto ldb = std::move(created).ValueOrDie();
     lru_delegate_ = ldb->reference_delegate();
+    if (ldb->HasDeferredMigrations()) {
+      ScheduleDeferredMigrations(ldb.get());
+    }
 
     persistence_ = std::move(ldb);
     if (settings.gc_enabled()) {
@@ -229,33 +247,68 @@ void FirestoreClient::ScheduleLruGarbageCollection() {
         auto shared_this = weak_this.lock();
         if (!shared_this) return;
 
-        shared_this->local_store_->CollectGarbage(
-            shared_this->lru_delegate_->garbage_collector());
-        shared_this->gc_has_run_ = true;
-        shared_this->ScheduleLruGarbageCollection();
+        // Collecting garbage can take a while, so let any operations the user
+        // is waiting on go first.
+        shared_this->worker_queue()->EnqueueRelaxed(
+            AsyncQueue::Priority::Background,
+            "firestore_client.collect_garbage", [weak_this] {
+              auto strong_this = weak_this.lock();
+              if (!strong_this) return;
+
+              strong_this->local_store_->CollectGarbage(
+                  strong_this->lru_delegate_->garbage_collector());
+              strong_this->gc_has_run_ = true;
+              strong_this->ScheduleLruGarbageCollection();
+            });
+      });
+}
+
+/**
+ * Schedules the next chunk of the schema migrations that were deferred when
+ * persistence started, behind any operations the user is waiting on.
+ * Reschedules itself until none remain.
+ */
+void FirestoreClient::ScheduleDeferredMigrations(
+    LevelDbPersistence* persistence) {
+  std::weak_ptr<FirestoreClient> weak_this = shared_from_this();
+  worker_queue()->EnqueueRelaxed(
+      AsyncQueue::Priority::Background,
+      "firestore_client.run_deferred_migrations", [weak_this, persistence] {
+        auto strong_this = weak_this.lock();
+        if (!strong_this || strong_this->is_terminated()) return;
+
+        if (persistence->RunDeferredMigrations()) {
+          strong_this->ScheduleDeferredMigrations(persistence);
+        }
       });
 }
 
 void FirestoreClient::DisableNetwork(StatusCallback callback) {
   VerifyNotTerminated();
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, callback] {
-    shared_this->remote_store_->DisableNetwork();
-    if (callback) {
-      shared_this->user_executor()->Execute([=] { callback(Status::OK()); });
-    }
-  });
+  worker_queue()->Enqueue(
+      kUserPriority, "firestore_client.disable_network",
+      [shared_this, callback] {
+        shared_this->remote_store_->DisableNetwork();
+        if (callback) {
+          shared_this->user_executor()->Execute(
+              [=] { callback(Status::OK()); });
+        }
+      });
 }
 
 void FirestoreClient::EnableNetwork(StatusCallback callback) {
   VerifyNotTerminated();
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, callback] {
-    shared_this->remote_store_->EnableNetwork();
-    if (callback) {
-      shared_this->user_executor()->Execute([=] { callback(Status::OK()); });
-    }
-  });
+  worker_queue()->Enqueue(
+      kUserPriority, "firestore_client.enable_network",
+      [shared_this, callback] {
+        shared_this->remote_store_->EnableNetwork();
+        if (callback) {
+          shared_this->user_executor()->Execute(
+              [=] { callback(Status::OK()); });
+        }
+      });
 }
 
 void FirestoreClient::TerminateAsync(StatusCallback callback) {
@@ -306,10 +359,12 @@ void FirestoreClient::WaitForPendingWrites(StatusCallback callback) {
     }
   };
 
-  worker_queue()->Enqueue([shared_this, async_callback] {
-    shared_this->sync_engine_->RegisterPendingWritesCallback(
-        std::move(async_callback));
-  });
+  worker_queue()->Enqueue(
+      kUserPriority, "firestore_client.wait_for_pending_writes",
+      [shared_this, async_callback] {
+        shared_this->sync_engine_->RegisterPendingWritesCallback(
+            std::move(async_callback));
+      });
 }
 
 void FirestoreClient::VerifyNotTerminated() {
@@ -333,9 +388,12 @@ std::shared_ptr<QueryListener> FirestoreClient::ListenToQuery(
       std::move(query), std::move(options), std::move(listener));
 
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, query_listener] {
-    shared_this->event_manager_->AddQueryListener(std::move(query_listener));
-  });
+  worker_queue()->Enqueue(
+      kUserPriority, "firestore_client.listen",
+      [shared_this, query_listener] {
+        shared_this->event_manager_->AddQueryListener(
+            std::move(query_listener));
+      });
 
   return query_listener;
 }
@@ -348,9 +406,11 @@ void FirestoreClient::RemoveListener(
     return;
   }
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, listener] {
-    shared_this->event_manager_->RemoveQueryListener(listener);
-  });
+  worker_queue()->Enqueue(kUserPriority, "firestore_client.remove_listener",
+                          [shared_this, listener] {
+                            shared_this->event_manager_->RemoveQueryListener(
+                                listener);
+                          });
 }
 
 void FirestoreClient::GetDocumentFromLocalCache(
@@ -360,36 +420,38 @@ void FirestoreClient::GetDocumentFromLocalCache(
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, doc, shared_callback] {
-    absl::optional<MaybeDocument> maybe_document =
-        shared_this->local_store_->ReadDocument(doc.key());
-    StatusOr<DocumentSnapshot> maybe_snapshot;
-
-    if (maybe_document && maybe_document->is_document()) {
-      Document document(*maybe_document);
-      maybe_snapshot = DocumentSnapshot::FromDocument(
-          doc.firestore(), document,
-          SnapshotMetadata{
-              /*has_pending_writes=*/document.has_local_mutations(),
-              /*from_cache=*/true});
-    } else if (maybe_document && maybe_document->is_no_document()) {
-      maybe_snapshot = DocumentSnapshot::FromNoDocument(
-          doc.firestore(), doc.key(),
-          SnapshotMetadata{/*has_pending_writes=*/false,
-                           /*from_cache=*/true});
-    } else {
-      maybe_snapshot =
-          Status{Error::Unavailable,
-                 "Failed to get document from cache. (However, this document "
-                 "may exist on the server. Run again without setting source to "
-                 "FirestoreSourceCache to attempt to retrieve the document "};
-    }
-
-    if (shared_callback) {
-      shared_this->user_executor()->Execute(
-          [=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
-    }
-  });
+  worker_queue()->Enqueue(
+      kUserPriority, "firestore_client.get_document",
+      [shared_this, doc, shared_callback] {
+        absl::optional<MaybeDocument> maybe_document =
+            shared_this->local_store_->ReadDocument(doc.key());
+        StatusOr<DocumentSnapshot> maybe_snapshot;
+
+        if (maybe_document && maybe_document->is_document()) {
+          Document document(*maybe_document);
+          maybe_snapshot = DocumentSnapshot::FromDocument(
+              doc.firestore(), document,
+              SnapshotMetadata{
+                  /*has_pending_writes=*/document.has_local_mutations(),
+                  /*from_cache=*/true});
+        } else if (maybe_document && maybe_document->is_no_document()) {
+          maybe_snapshot = DocumentSnapshot::FromNoDocument(
+              doc.firestore(), doc.key(),
+              SnapshotMetadata{/*has_pending_writes=*/false,
+                               /*from_cache=*/true});
+        } else {
+          maybe_snapshot = Status{
+              Error::Unavailable,
+              "Failed to get document from cache. (However, this document "
+              "may exist on the server. Run again without setting source to "
+              "FirestoreSourceCache to attempt to retrieve the document "};
+        }
+
+        if (shared_callback) {
+          shared_this->user_executor()->Execute(
+              [=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
+        }
+      });
 }
 
 void FirestoreClient::GetDocumentsFromLocalCache(
@@ -399,32 +461,34 @@ void FirestoreClient::GetDocumentsFromLocalCache(
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, query, shared_callback] {
-    QueryResult query_result = shared_this->local_store_->ExecuteQuery(
-        query.query(), /* use_previous_results= */ true);
-
-    View view(query.query(), query_result.remote_keys());
-    ViewDocumentChanges view_doc_changes =
-        view.ComputeDocumentChanges(query_result.documents().underlying_map());
-    ViewChange view_change = view.ApplyChanges(view_doc_changes);
-    HARD_ASSERT(
-        view_change.limbo_changes().empty(),
-        "View returned limbo documents during local-only query execution.");
-
-    HARD_ASSERT(view_change.snapshot().has_value(), "Expected a snapshot");
-
-    ViewSnapshot snapshot = std::move(view_change.snapshot()).value();
-    SnapshotMetadata metadata(snapshot.has_pending_writes(),
-                              snapshot.from_cache());
-
-    QuerySnapshot result(query.firestore(), query.query(), std::move(snapshot),
-                         std::move(metadata));
-
-    if (shared_callback) {
-      shared_this->user_executor()->Execute(
-          [=] { shared_callback->OnEvent(std::move(result)); });
-    }
-  });
+  worker_queue()->Enqueue(
+      kUserPriority, "firestore_client.get_documents",
+      [shared_this, query, shared_callback] {
+        QueryResult query_result = shared_this->local_store_->ExecuteQuery(
+            query.query(), /* use_previous_results= */ true);
+
+        View view(query.query(), query_result.remote_keys());
+        ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(
+            query_result.documents().underlying_map());
+        ViewChange view_change = view.ApplyChanges(view_doc_changes);
+        HARD_ASSERT(
+            view_change.limbo_changes().empty(),
+            "View returned limbo documents during local-only query execution.");
+
+        HARD_ASSERT(view_change.snapshot().has_value(), "Expected a snapshot");
+
+        ViewSnapshot snapshot = std::move(view_change.snapshot()).value();
+        SnapshotMetadata metadata(snapshot.has_pending_writes(),
+                                  snapshot.from_cache());
+
+        QuerySnapshot result(query.firestore(), query.query(),
+                             std::move(snapshot), std::move(metadata));
+
+        if (shared_callback) {
+          shared_this->user_executor()->Execute(
+              [=] { shared_callback->OnEvent(std::move(result)); });
+        }
+      });
 }
 
 void FirestoreClient::WriteMutations(std::vector<Mutation>&& mutations,
@@ -433,22 +497,25 @@ void FirestoreClient::WriteMutations(std::vector<Mutation>&& mutations,
 
   // TODO(c++14): move `mutations` into lambda (C++14).
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, mutations, callback]() mutable {
-    if (mutations.empty()) {
-      if (callback) {
-        shared_this->user_executor()->Execute([=] { callback(Status::OK()); });
-      }
-    } else {
-      shared_this->sync_engine_->WriteMutations(
-          std::move(mutations), [callback, shared_this](Status error) {
-            // Dispatch the result back onto the user dispatch queue.
-            if (callback) {
-              shared_this->user_executor()->Execute(
-                  [=] { callback(std::move(error)); });
-            }
-          });
-    }
-  });
+  worker_queue()->Enqueue(
+      kUserPriority, "firestore_client.write_mutations",
+      [shared_this, mutations, callback]() mutable {
+        if (mutations.empty()) {
+          if (callback) {
+            shared_this->user_executor()->Execute(
+                [=] { callback(Status::OK()); });
+          }
+        } else {
+          shared_this->sync_engine_->WriteMutations(
+              std::move(mutations), [callback, shared_this](Status error) {
+                // Dispatch the result back onto the user dispatch queue.
+                if (callback) {
+                  shared_this->user_executor()->Execute(
+                      [=] { callback(std::move(error)); });
+                }
+              });
+        }
+      });
 }
 
 void FirestoreClient::Transaction(int retries,
@@ -465,21 +532,24 @@ void FirestoreClient::Transaction(int retries,
     }
   };
 
-  worker_queue()->Enqueue([shared_this, retries, update_callback,
-                           async_callback] {
-    shared_this->sync_engine_->Transaction(retries, shared_this->worker_queue(),
-                                           std::move(update_callback),
-                                           std::move(async_callback));
-  });
+  worker_queue()->Enqueue(
+      kUserPriority, "firestore_client.transaction",
+      [shared_this, retries, update_callback, async_callback] {
+        shared_this->sync_engine_->Transaction(
+            retries, shared_this->worker_queue(), std::move(update_callback),
+            std::move(async_callback));
+      });
 }
 
 void FirestoreClient::AddSnapshotsInSyncListener(
     const std::shared_ptr<EventListener<Empty>>& user_listener) {
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, user_listener] {
-    shared_this->event_manager_->AddSnapshotsInSyncListener(
-        std::move(user_listener));
-  });
+  worker_queue()->Enqueue(
+      kUserPriority, "firestore_client.add_snapshots_in_sync_listener",
+      [shared_this, user_listener] {
+        shared_this->event_manager_->AddSnapshotsInSyncListener(
+            std::move(user_listener));
+      });
 }
 
 void FirestoreClient::RemoveSnapshotsInSyncListener(
@@ -40,6 +40,7 @@ class User;
 }  // namespace auth
 
 namespace local {
+class LevelDbPersistence;
 class LocalStore;
 class LruDelegate;
 class Persistence;
@@ -187,6 +188,8 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
 
   void ScheduleLruGarbageCollection();
 
+  void ScheduleDeferredMigrations(local::LevelDbPersistence* persistence);
+
   DatabaseInfo database_info_;
   std::shared_ptr<auth::CredentialsProvider> credentials_provider_;
   /**
@@ -19,14 +19,13 @@
 #include <memory>
 #include <utility>
 
-#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "absl/algorithm/container.h"
 
 namespace firebase {
 namespace firestore {
 namespace core {
 
-using model::Document;
 using model::FieldPath;
 using model::FieldValue;
 
@@ -42,7 +41,7 @@ class InFilter::Rep : public FieldFilter::Rep {
     return Type::kInFilter;
   }
 
-  bool Matches(const model::Document& doc) const override;
+  bool MatchesValue(const FieldValue& lhs) const override;
 };
 
 InFilter::InFilter(FieldPath field, FieldValue value)
@@ -50,11 +49,9 @@ InFilter::InFilter(FieldPath field, FieldValue value)
           std::make_shared<const Rep>(std::move(field), std::move(value))) {
 }
 
-bool InFilter::Rep::Matches(const Document& doc) const {
+bool InFilter::Rep::MatchesValue(const FieldValue& lhs) const {
   const FieldValue::Array& array_value = value().array_value();
-  absl::optional<FieldValue> maybe_lhs = doc.field(field());
-  if (!maybe_lhs) return false;
-  return absl::c_linear_search(array_value, *maybe_lhs);
+  return absl::c_linear_search(array_value, lhs);
 }
 
 }  // namespace core
@@ -22,6 +22,7 @@
 #include "Firestore/core/src/firebase/firestore/core/bound.h"
 #include "Firestore/core/src/firebase/firestore/core/field_filter.h"
 #include "Firestore/core/src/firebase/firestore/core/operator.h"
+#include "Firestore/core/src/firebase/firestore/core/query_matcher.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
@@ -232,54 +233,18 @@ Query Query::AsCollectionQueryAtPath(ResourcePath path) const {
 // MARK: - Matching
 
 bool Query::Matches(const Document& doc) const {
-  return MatchesPathAndCollectionGroup(doc) && MatchesOrderBy(doc) &&
-         MatchesFilters(doc) && MatchesBounds(doc);
+  return matcher().Matches(doc);
 }
 
-bool Query::MatchesPathAndCollectionGroup(const Document& doc) const {
-  const ResourcePath& doc_path = doc.key().path();
-  if (collection_group_) {
-    // NOTE: path_ is currently always empty since we don't expose Collection
-    // Group queries rooted at a document path yet.
-    return doc.key().HasCollectionId(*collection_group_) &&
-           path_.IsPrefixOf(doc_path);
-  } else if (DocumentKey::IsDocumentKey(path_)) {
-    // Exact match for document queries.
-    return path_ == doc_path;
-  } else {
-    // Shallow ancestor queries by default.
-    return path_.IsImmediateParentOf(doc_path);
-  }
-}
-
-bool Query::MatchesFilters(const Document& doc) const {
-  for (const auto& filter : filters_) {
-    if (!filter.Matches(doc)) return false;
-  }
-  return true;
+std::vector<bool> Query::MatchesBatch(const std::vector<Document>& docs) const {
+  return matcher().MatchesBatch(docs);
 }
 
-bool Query::MatchesOrderBy(const Document& doc) const {
-  for (const OrderBy& order_by : explicit_order_bys_) {
-    const FieldPath& field_path = order_by.field();
-    // order by key always matches
-    if (field_path != FieldPath::KeyFieldPath() &&
-        doc.field(field_path) == absl::nullopt) {
-      return false;
-    }
-  }
-  return true;
-}
-
-bool Query::MatchesBounds(const Document& doc) const {
-  const OrderByList& ordering = order_bys();
-  if (start_at_ && !start_at_->SortsBeforeDocument(ordering, doc)) {
-    return false;
-  }
-  if (end_at_ && end_at_->SortsBeforeDocument(ordering, doc)) {
-    return false;
+const QueryMatcher& Query::matcher() const {
+  if (memoized_matcher_ == nullptr) {
+    memoized_matcher_ = std::make_shared<QueryMatcher>(*this);
   }
-  return true;
+  return *memoized_matcher_;
 }
 
 model::DocumentComparator Query::Comparator() const {
@@ -36,6 +36,7 @@ namespace firestore {
 namespace core {
 
 class Bound;
+class QueryMatcher;
 
 using CollectionGroupId = std::shared_ptr<const std::string>;
 
@@ -226,9 +227,22 @@ class Query {
    */
   Query AsCollectionQueryAtPath(model::ResourcePath path) const;
 
-  /** Returns true if the document matches the constraints of this query. */
+  /**
+   * Returns true if the document matches the constraints of this query.
+   *
+   * The first call prepares a `QueryMatcher`, which later calls on this query
+   * and its copies reuse.
+   */
   bool Matches(const model::Document& doc) const;
 
+  /**
+   * Returns whether each of `docs` matches the constraints of this query.
+   * Faster than calling `Matches` on each for large batches, such as the
+   * documents of a collection scan.
+   */
+  std::vector<bool> MatchesBatch(
+      const std::vector<model::Document>& docs) const;
+
   /**
    * Returns a comparator that will sort documents according to the order by
    * clauses in this query.
@@ -251,10 +265,7 @@ class Query {
   size_t Hash() const;
 
  private:
-  bool MatchesPathAndCollectionGroup(const model::Document& doc) const;
-  bool MatchesFilters(const model::Document& doc) const;
-  bool MatchesOrderBy(const model::Document& doc) const;
-  bool MatchesBounds(const model::Document& doc) const;
+  const QueryMatcher& matcher() const;
 
   model::ResourcePath path_;
   std::shared_ptr<const std::string> collection_group_;
@@ -280,6 +291,9 @@ class Query {
 
   // The corresponding Target of this Query instance.
   mutable std::shared_ptr<const Target> memoized_target;
+
+  // The constraints of this Query, prepared for matching documents.
+  mutable std::shared_ptr<const QueryMatcher> memoized_matcher_;
 };
 
 bool operator==(const Query& lhs, const Query& rhs);
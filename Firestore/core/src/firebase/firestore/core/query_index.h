@@ -0,0 +1,169 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_INDEX_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_INDEX_H_
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * Indexes values associated with queries by the documents those queries could
+ * possibly match, so that document changes can be routed to only the queries
+ * they might affect.
+ *
+ * A document is a candidate for a query if it lives directly in the query's
+ * collection, belongs to the query's collection group, or is the single
+ * document named by a document query. Candidates must still be evaluated
+ * against the query's filters.
+ *
+ * @tparam T The type of value associated with each query. Values must be
+ *     hashable and equality comparable, and are typically pointers.
+ */
+template <typename T>
+class QueryIndex {
+ public:
+  /** Adds `value` to the index under the documents matched by `query`. */
+  void Add(const Query& query, T value) {
+    Bucket(query).push_back(std::move(value));
+  }
+
+  /** Removes a `value` previously added under `query`. */
+  void Remove(const Query& query, const T& value) {
+    if (query.IsDocumentQuery()) {
+      RemoveFromBucket(&by_document_, query.path(), value);
+    } else if (query.IsCollectionGroupQuery()) {
+      RemoveFromBucket(&by_collection_group_, *query.collection_group(),
+                       value);
+    } else {
+      RemoveFromBucket(&by_collection_, query.path(), value);
+    }
+  }
+
+  /**
+   * Calls `callback` with each value whose query could match the document
+   * identified by `key`.
+   */
+  template <typename Callback>
+  void ForEachCandidate(const model::DocumentKey& key,
+                        const Callback& callback) const {
+    const model::ResourcePath& path = key.path();
+    VisitBucket(by_document_, path, callback);
+
+    model::ResourcePath collection = path.PopLast();
+    VisitBucket(by_collection_, collection, callback);
+    VisitBucket(by_collection_group_, collection.last_segment(), callback);
+  }
+
+  /**
+   * Partitions `changes` by the values whose queries could match them. Values
+   * without any candidate changes are omitted from the result.
+   */
+  std::unordered_map<T, model::MaybeDocumentMap> Route(
+      const model::MaybeDocumentMap& changes) const {
+    using Entry = std::pair<model::DocumentKey, model::MaybeDocument>;
+
+    std::unordered_map<T, std::vector<Entry>> entries;
+    for (const auto& kv : changes) {
+      ForEachCandidate(kv.first, [&](const T& value) {
+        entries[value].emplace_back(kv.first, kv.second);
+      });
+    }
+
+    // `changes` is sorted, so each partition is too and can be built in
+    // linear time.
+    std::unordered_map<T, model::MaybeDocumentMap> result;
+    for (const auto& entry : entries) {
+      const std::vector<Entry>& routed = entry.second;
+      if (routed.size() == changes.size()) {
+        result.emplace(entry.first, changes);
+      } else {
+        result.emplace(entry.first, model::MaybeDocumentMap::FromSortedRange(
+                                        routed.begin(), routed.end()));
+      }
+    }
+    return result;
+  }
+
+ private:
+  struct PathHash {
+    size_t operator()(const model::ResourcePath& path) const {
+      return path.Hash();
+    }
+  };
+
+  template <typename K, typename Map, typename Callback>
+  static void VisitBucket(const Map& buckets,
+                          const K& key,
+                          const Callback& callback) {
+    auto found = buckets.find(key);
+    if (found == buckets.end()) return;
+
+    for (const T& value : found->second) {
+      callback(value);
+    }
+  }
+
+  template <typename K, typename Map>
+  static void RemoveFromBucket(Map* buckets, const K& key, const T& value) {
+    auto found = buckets->find(key);
+    if (found == buckets->end()) return;
+
+    std::vector<T>& bucket = found->second;
+    auto pos = std::find(bucket.begin(), bucket.end(), value);
+    if (pos != bucket.end()) {
+      bucket.erase(pos);
+    }
+    if (bucket.empty()) {
+      buckets->erase(found);
+    }
+  }
+
+  std::vector<T>& Bucket(const Query& query) {
+    if (query.IsDocumentQuery()) {
+      return by_document_[query.path()];
+    } else if (query.IsCollectionGroupQuery()) {
+      return by_collection_group_[*query.collection_group()];
+    } else {
+      return by_collection_[query.path()];
+    }
+  }
+
+  std::unordered_map<model::ResourcePath, std::vector<T>, PathHash>
+      by_document_;
+  std::unordered_map<model::ResourcePath, std::vector<T>, PathHash>
+      by_collection_;
+  std::unordered_map<std::string, std::vector<T>> by_collection_group_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_INDEX_H_
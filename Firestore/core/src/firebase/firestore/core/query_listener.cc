@@ -17,7 +17,6 @@
 #include "Firestore/core/src/firebase/firestore/core/query_listener.h"
 
 #include <utility>
-#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -69,27 +68,17 @@ QueryListener::QueryListener(Query query,
 }
 
 bool QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
-  HARD_ASSERT(
-      !snapshot.document_changes().empty() || snapshot.sync_state_changed(),
-      "We got a new snapshot with no changes?");
+  // A snapshot that already excludes metadata changes can be left without any
+  // changes; it's dropped by `ShouldRaiseEvent` below.
+  HARD_ASSERT(snapshot.excludes_metadata_changes() ||
+                  !snapshot.document_changes().empty() ||
+                  snapshot.sync_state_changed(),
+              "We got a new snapshot with no changes?");
   bool raised_event = false;
-  if (!options_.include_document_metadata_changes()) {
+  if (!options_.include_document_metadata_changes() &&
+      !snapshot.excludes_metadata_changes()) {
     // Remove the metadata-only changes.
-    std::vector<DocumentViewChange> changes;
-    for (const DocumentViewChange& change : snapshot.document_changes()) {
-      if (change.type() != DocumentViewChange::Type::Metadata) {
-        changes.push_back(change);
-      }
-    }
-
-    snapshot = ViewSnapshot{snapshot.query(),
-                            snapshot.documents(),
-                            snapshot.old_documents(),
-                            std::move(changes),
-                            snapshot.mutated_keys(),
-                            snapshot.from_cache(),
-                            snapshot.sync_state_changed(),
-                            /*excludes_metadata_changes=*/true};
+    snapshot = snapshot.ExcludingMetadataChanges();
   }
 
   if (!raised_initial_event_) {
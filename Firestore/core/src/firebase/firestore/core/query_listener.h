@@ -63,6 +63,10 @@ class QueryListener {
     return query_;
   }
 
+  const ListenOptions& options() const {
+    return options_;
+  }
+
   /** The last received view snapshot. */
   const absl::optional<ViewSnapshot>& snapshot() const {
     return snapshot_;
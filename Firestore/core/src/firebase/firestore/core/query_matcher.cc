@@ -0,0 +1,409 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_matcher.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/core/bound.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::Document;
+using model::DocumentKey;
+using model::FieldPath;
+using model::FieldValue;
+using model::ObjectValue;
+using model::ResourcePath;
+
+using Operator = Filter::Operator;
+
+namespace {
+
+// Equality rejects the most documents for the least work, followed by
+// membership tests; range checks rarely narrow a scan as much. Fields that
+// are only ordered by just need to exist.
+constexpr int kEqualityRank = 0;
+constexpr int kMembershipRank = 1;
+constexpr int kRangeRank = 2;
+constexpr int kExistenceRank = 3;
+
+constexpr size_t kInlineBoundSize = 4;
+
+// Large enough to amortize setting up each filter, small enough that the
+// columns of a chunk stay in cache.
+constexpr size_t kChunkSize = 256;
+
+/** The type of a value in a `FieldColumn`, as far as comparisons go. */
+enum class ColumnType : uint8_t {
+  kOther,
+  kInteger,
+  /** A double other than NaN, which Firestore orders unlike IEEE 754. */
+  kDouble,
+  kString,
+};
+
+int Rank(const FieldFilter& filter) {
+  switch (filter.op()) {
+    case Operator::Equal:
+      return kEqualityRank;
+    case Operator::In:
+    case Operator::ArrayContains:
+    case Operator::ArrayContainsAny:
+      return kMembershipRank;
+    default:
+      return kRangeRank;
+  }
+}
+
+/**
+ * Returns the column type of values that `filter` can be evaluated against
+ * without going through `FieldValue`, or `kOther` if there's none.
+ */
+ColumnType UnboxedType(const FieldFilter& filter) {
+  if (filter.op() != Operator::Equal && !filter.IsInequality()) {
+    return ColumnType::kOther;
+  }
+
+  const FieldValue& rhs = filter.value();
+  switch (rhs.type()) {
+    case FieldValue::Type::Integer:
+      return ColumnType::kInteger;
+    case FieldValue::Type::Double:
+      return rhs.is_nan() ? ColumnType::kOther : ColumnType::kDouble;
+    case FieldValue::Type::String:
+      return ColumnType::kString;
+    default:
+      return ColumnType::kOther;
+  }
+}
+
+/**
+ * Clears `selected[i]` for each value of `type` that doesn't satisfy
+ * `compare(column[i], rhs)`, leaving values of other types alone. Has no
+ * branches, so that it vectorizes.
+ */
+template <typename T, typename Compare>
+void SelectWhere(ColumnType type,
+                 const std::vector<ColumnType>& types,
+                 const std::vector<T>& column,
+                 const T& rhs,
+                 Compare compare,
+                 size_t size,
+                 uint8_t* selected) {
+  for (size_t i = 0; i < size; ++i) {
+    selected[i] &= static_cast<uint8_t>(types[i] != type) |
+                   static_cast<uint8_t>(compare(column[i], rhs));
+  }
+}
+
+template <typename T>
+void SelectWhere(Operator op,
+                 ColumnType type,
+                 const std::vector<ColumnType>& types,
+                 const std::vector<T>& column,
+                 const T& rhs,
+                 size_t size,
+                 uint8_t* selected) {
+  switch (op) {
+    case Operator::LessThan:
+      return SelectWhere(type, types, column, rhs, std::less<T>(), size,
+                         selected);
+    case Operator::LessThanOrEqual:
+      return SelectWhere(type, types, column, rhs, std::less_equal<T>(), size,
+                         selected);
+    case Operator::Equal:
+      return SelectWhere(type, types, column, rhs, std::equal_to<T>(), size,
+                         selected);
+    case Operator::GreaterThanOrEqual:
+      return SelectWhere(type, types, column, rhs, std::greater_equal<T>(),
+                         size, selected);
+    case Operator::GreaterThan:
+      return SelectWhere(type, types, column, rhs, std::greater<T>(), size,
+                         selected);
+    default:
+      HARD_FAIL("Operator %s unsuitable for comparison", op);
+  }
+}
+
+}  // namespace
+
+/**
+ * The values of one field across a chunk of documents. Integer, double and
+ * string values are also unboxed into arrays of their own.
+ */
+struct QueryMatcher::FieldColumn {
+  /** Loads `field` from the selected documents, deselecting those without. */
+  void Load(const FieldPath& field,
+            const Document* docs,
+            size_t size,
+            uint8_t* selected) {
+    values.assign(size, nullptr);
+    types.assign(size, ColumnType::kOther);
+    integers.resize(size);
+    doubles.resize(size);
+    strings.resize(size);
+
+    for (size_t i = 0; i < size; ++i) {
+      if (!selected[i]) continue;
+
+      const FieldValue* value = docs[i].data().Find(field);
+      if (!value) {
+        selected[i] = 0;
+        continue;
+      }
+
+      values[i] = value;
+      switch (value->type()) {
+        case FieldValue::Type::Integer:
+          types[i] = ColumnType::kInteger;
+          integers[i] = value->integer_value();
+          break;
+        case FieldValue::Type::Double:
+          if (!value->is_nan()) {
+            types[i] = ColumnType::kDouble;
+            doubles[i] = value->double_value();
+          }
+          break;
+        case FieldValue::Type::String:
+          types[i] = ColumnType::kString;
+          strings[i] = value->string_value();
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  std::vector<const FieldValue*> values;
+  std::vector<ColumnType> types;
+  std::vector<int64_t> integers;
+  std::vector<double> doubles;
+  std::vector<absl::string_view> strings;
+};
+
+QueryMatcher::QueryMatcher(const Query& query)
+    : path_(query.path()),
+      collection_group_(query.collection_group()),
+      is_document_query_(DocumentKey::IsDocumentKey(query.path())),
+      order_by_(query.order_bys()),
+      start_at_(query.start_at()),
+      end_at_(query.end_at()) {
+  for (const Filter& filter : query.filters()) {
+    if (!filter.IsAFieldFilter() || filter.field().IsKeyFieldPath()) {
+      document_filters_.push_back(filter);
+      continue;
+    }
+
+    FieldFilter field_filter{filter};
+    FieldCheck& check = FieldCheckFor(field_filter.field());
+    check.rank = std::min(check.rank, Rank(field_filter));
+    check.filters.push_back(std::move(field_filter));
+  }
+
+  if (start_at_) bound_size_ = start_at_->position().size();
+  if (end_at_) bound_size_ = std::max(bound_size_, end_at_->position().size());
+
+  // Every field ordered by must exist, even if no bound refers to it.
+  for (size_t idx = 0; idx < order_by_.size(); ++idx) {
+    const FieldPath& field = order_by_[idx].field();
+    if (field.IsKeyFieldPath()) continue;
+
+    FieldCheck& check = FieldCheckFor(field);
+    if (idx < bound_size_) check.bound_components.push_back(idx);
+  }
+
+  for (FieldCheck& check : field_checks_) {
+    std::stable_sort(check.filters.begin(), check.filters.end(),
+                     [](const FieldFilter& lhs, const FieldFilter& rhs) {
+                       return Rank(lhs) < Rank(rhs);
+                     });
+  }
+  std::stable_sort(field_checks_.begin(), field_checks_.end(),
+                   [](const FieldCheck& lhs, const FieldCheck& rhs) {
+                     return lhs.rank < rhs.rank;
+                   });
+}
+
+QueryMatcher::FieldCheck& QueryMatcher::FieldCheckFor(const FieldPath& field) {
+  for (FieldCheck& check : field_checks_) {
+    if (check.field == field) return check;
+  }
+
+  field_checks_.emplace_back();
+  FieldCheck& check = field_checks_.back();
+  check.field = field;
+  check.rank = kExistenceRank;
+  return check;
+}
+
+bool QueryMatcher::Matches(const Document& doc) const {
+  const DocumentKey& key = doc.key();
+  if (!MatchesPathAndCollectionGroup(key)) return false;
+
+  for (const Filter& filter : document_filters_) {
+    if (!filter.Matches(doc)) return false;
+  }
+
+  // Bounds rarely have more than a few components, so their values usually
+  // fit on the stack.
+  const FieldValue* inline_bound_values[kInlineBoundSize] = {};
+  std::vector<const FieldValue*> heap_bound_values;
+  const FieldValue** bound_values = inline_bound_values;
+  if (bound_size_ > kInlineBoundSize) {
+    heap_bound_values.resize(bound_size_);
+    bound_values = heap_bound_values.data();
+  }
+
+  const ObjectValue& data = doc.data();
+  for (const FieldCheck& check : field_checks_) {
+    const FieldValue* value = data.Find(check.field);
+    if (!value) return false;
+
+    for (const FieldFilter& filter : check.filters) {
+      if (!filter.MatchesValue(*value)) return false;
+    }
+    for (size_t idx : check.bound_components) {
+      bound_values[idx] = value;
+    }
+  }
+
+  return MatchesBounds(key, bound_values);
+}
+
+std::vector<bool> QueryMatcher::MatchesBatch(
+    const std::vector<Document>& docs) const {
+  std::vector<bool> results(docs.size());
+  std::vector<FieldColumn> columns(field_checks_.size());
+  uint8_t selected[kChunkSize];
+
+  for (size_t begin = 0; begin < docs.size(); begin += kChunkSize) {
+    size_t size = std::min(kChunkSize, docs.size() - begin);
+    MatchChunk(&docs[begin], size, &columns, selected);
+    for (size_t i = 0; i < size; ++i) {
+      results[begin + i] = selected[i] != 0;
+    }
+  }
+  return results;
+}
+
+void QueryMatcher::MatchChunk(const Document* docs,
+                              size_t size,
+                              std::vector<FieldColumn>* columns,
+                              uint8_t* selected) const {
+  for (size_t i = 0; i < size; ++i) {
+    selected[i] = MatchesPathAndCollectionGroup(docs[i].key());
+    if (!selected[i]) continue;
+
+    for (const Filter& filter : document_filters_) {
+      if (!filter.Matches(docs[i])) {
+        selected[i] = 0;
+        break;
+      }
+    }
+  }
+
+  for (size_t k = 0; k < field_checks_.size(); ++k) {
+    const FieldCheck& check = field_checks_[k];
+    FieldColumn& column = (*columns)[k];
+    column.Load(check.field, docs, size, selected);
+
+    for (const FieldFilter& filter : check.filters) {
+      ColumnType type = UnboxedType(filter);
+      const FieldValue& rhs = filter.value();
+      switch (type) {
+        case ColumnType::kInteger:
+          SelectWhere(filter.op(), type, column.types, column.integers,
+                      rhs.integer_value(), size, selected);
+          break;
+        case ColumnType::kDouble:
+          SelectWhere(filter.op(), type, column.types, column.doubles,
+                      rhs.double_value(), size, selected);
+          break;
+        case ColumnType::kString:
+          SelectWhere(filter.op(), type, column.types, column.strings,
+                      absl::string_view{rhs.string_value()}, size, selected);
+          break;
+        case ColumnType::kOther:
+          break;
+      }
+
+      // Evaluate the values the loop above couldn't one at a time.
+      for (size_t i = 0; i < size; ++i) {
+        if (selected[i] &&
+            (type == ColumnType::kOther || column.types[i] != type)) {
+          selected[i] = filter.MatchesValue(*column.values[i]);
+        }
+      }
+    }
+  }
+
+  if (!start_at_ && !end_at_) return;
+
+  std::vector<const FieldValue*> bound_values(bound_size_);
+  for (size_t i = 0; i < size; ++i) {
+    if (!selected[i]) continue;
+
+    for (size_t k = 0; k < field_checks_.size(); ++k) {
+      for (size_t idx : field_checks_[k].bound_components) {
+        bound_values[idx] = (*columns)[k].values[i];
+      }
+    }
+    selected[i] = MatchesBounds(docs[i].key(), bound_values.data());
+  }
+}
+
+bool QueryMatcher::MatchesPathAndCollectionGroup(const DocumentKey& key) const {
+  const ResourcePath& doc_path = key.path();
+  if (collection_group_) {
+    // NOTE: path_ is currently always empty since we don't expose Collection
+    // Group queries rooted at a document path yet.
+    return key.HasCollectionId(*collection_group_) &&
+           path_.IsPrefixOf(doc_path);
+  } else if (is_document_query_) {
+    // Exact match for document queries.
+    return path_ == doc_path;
+  } else {
+    // Shallow ancestor queries by default.
+    return path_.IsImmediateParentOf(doc_path);
+  }
+}
+
+bool QueryMatcher::MatchesBounds(const DocumentKey& key,
+                                 const FieldValue* const* bound_values) const {
+  if (start_at_ &&
+      !start_at_->SortsBeforeDocument(order_by_, key, bound_values)) {
+    return false;
+  }
+  if (end_at_ && end_at_->SortsBeforeDocument(order_by_, key, bound_values)) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
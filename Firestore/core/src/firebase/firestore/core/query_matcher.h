@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_MATCHER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_MATCHER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/core_fwd.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/core/order_by.h"
+#include "Firestore/core/src/firebase/firestore/immutable/append_only_list.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * The constraints of a query, arranged to be checked against many documents.
+ *
+ * `Query::Matches` checks each filter, order by and bound in turn, and each
+ * of them looks up its field in the document again. A `QueryMatcher` instead
+ * groups the filters by field, looks up each distinct field once per document
+ * and reuses the value for the bounds. Checks that are cheap or likely to
+ * reject a document (the path, the key, equality) run before the rest.
+ *
+ * Queries build their matcher on first use; see `Query::Matches`. A matcher
+ * keeps its own copy of everything it needs and may outlive its query.
+ */
+class QueryMatcher {
+ public:
+  explicit QueryMatcher(const Query& query);
+
+  /** Returns true if the document matches the constraints of the query. */
+  bool Matches(const model::Document& doc) const;
+
+  /**
+   * Returns whether each of `docs` matches the constraints of the query, as
+   * `Matches` would, for scans over many documents.
+   *
+   * The batch is evaluated in chunks, one field at a time: the field's values
+   * are unboxed into integer, double and string columns so that comparisons
+   * against a constant run as branch-free loops the compiler can vectorize.
+   * Other values, and comparisons between integers and doubles, fall back to
+   * `FieldFilter::MatchesValue`.
+   */
+  std::vector<bool> MatchesBatch(
+      const std::vector<model::Document>& docs) const;
+
+ private:
+  struct FieldColumn;
+
+  /** The filters and order by components that read one document field. */
+  struct FieldCheck {
+    model::FieldPath field;
+
+    /** Filters on `field`, cheapest first. */
+    std::vector<FieldFilter> filters;
+
+    /** Indexes into `order_by_` of the bound components on `field`. */
+    std::vector<size_t> bound_components;
+
+    /** Determines the order in which fields are checked; lower goes first. */
+    int rank = 0;
+  };
+
+  bool MatchesPathAndCollectionGroup(const model::DocumentKey& key) const;
+  bool MatchesBounds(const model::DocumentKey& key,
+                     const model::FieldValue* const* bound_values) const;
+
+  FieldCheck& FieldCheckFor(const model::FieldPath& field);
+
+  /**
+   * Sets `selected[i]` to whether the `i`th of the `size` documents at `docs`
+   * matches. `columns` is scratch space, reused across chunks.
+   */
+  void MatchChunk(const model::Document* docs,
+                  size_t size,
+                  std::vector<FieldColumn>* columns,
+                  uint8_t* selected) const;
+
+  model::ResourcePath path_;
+  std::shared_ptr<const std::string> collection_group_;
+  bool is_document_query_ = false;
+
+  /** Filters that need the whole document, such as those on the key. */
+  std::vector<Filter> document_filters_;
+
+  std::vector<FieldCheck> field_checks_;
+
+  OrderByList order_by_;
+  std::shared_ptr<Bound> start_at_;
+  std::shared_ptr<Bound> end_at_;
+
+  /** The number of leading `order_by_` components used by the bounds. */
+  size_t bound_size_ = 0;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_MATCHER_H_
@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/core/sync_engine.h"
 
+#include <algorithm>
+
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/firebase/firestore/core/sync_engine_callback.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
@@ -33,6 +35,8 @@
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch_result.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/background_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 
@@ -63,6 +67,8 @@ using model::TargetId;
 using remote::RemoteEvent;
 using remote::TargetChange;
 using util::AsyncQueue;
+using util::BackgroundQueue;
+using util::Executor;
 using util::Status;
 using util::StatusCallback;
 
@@ -80,13 +86,26 @@ bool ErrorIsInteresting(const Status& error) {
 
 }  // namespace
 
+constexpr size_t SyncEngine::kDefaultMaxConcurrentLimboResolutions;
+
 SyncEngine::SyncEngine(LocalStore* local_store,
                        remote::RemoteStore* remote_store,
-                       const auth::User& initial_user)
+                       const auth::User& initial_user,
+                       size_t max_concurrent_limbo_resolutions)
     : local_store_(local_store),
       remote_store_(remote_store),
       current_user_(initial_user),
-      target_id_generator_(TargetIdGenerator::SyncEngineTargetIdGenerator()) {
+      target_id_generator_(TargetIdGenerator::SyncEngineTargetIdGenerator()),
+      max_concurrent_limbo_resolutions_(max_concurrent_limbo_resolutions) {
+  HARD_ASSERT(max_concurrent_limbo_resolutions_ > 0,
+              "At least one limbo resolution must be allowed at a time");
+}
+
+void SyncEngine::EnableParallelViewComputation(int threads) {
+  HARD_ASSERT(threads > 0, "Invalid number of threads: %s", threads);
+  view_computation_executor_ = Executor::CreateConcurrent(
+      "com.google.firebase.firestore.views", threads);
+  view_computation_threads_ = threads;
 }
 
 void SyncEngine::AssertCallbackExists(absl::string_view source) {
@@ -141,6 +160,7 @@ ViewSnapshot SyncEngine::InitializeViewAndComputeSnapshot(const Query& query,
   auto query_view =
       std::make_shared<QueryView>(query, target_id, std::move(view));
   query_views_by_query_[query] = query_view;
+  query_views_by_document_.Add(query, query_view.get());
 
   queries_by_target_[target_id].push_back(query);
 
@@ -156,7 +176,7 @@ void SyncEngine::StopListening(const Query& query) {
   auto query_view = query_views_by_query_[query];
   HARD_ASSERT(query_view, "Trying to stop listening to a query not found");
 
-  query_views_by_query_.erase(query);
+  RemoveQueryView(query);
 
   TargetId target_id = query_view->target_id();
   auto& queries = queries_by_target_[target_id];
@@ -171,7 +191,7 @@ void SyncEngine::StopListening(const Query& query) {
 
 void SyncEngine::RemoveAndCleanupTarget(TargetId target_id, Status status) {
   for (const Query& query : queries_by_target_.at(target_id)) {
-    query_views_by_query_.erase(query);
+    RemoveQueryView(query);
     if (!status.ok()) {
       sync_engine_callback_->OnError(query, status);
       if (ErrorIsInteresting(status)) {
@@ -192,6 +212,14 @@ void SyncEngine::RemoveAndCleanupTarget(TargetId target_id, Status status) {
   }
 }
 
+void SyncEngine::RemoveQueryView(const Query& query) {
+  auto found = query_views_by_query_.find(query);
+  if (found == query_views_by_query_.end()) return;
+
+  query_views_by_document_.Remove(query, found->second.get());
+  query_views_by_query_.erase(found);
+}
+
 void SyncEngine::WriteMutations(std::vector<model::Mutation>&& mutations,
                                 StatusCallback callback) {
   AssertCallbackExists("WriteMutations");
@@ -304,6 +332,8 @@ void SyncEngine::HandleRejectedListen(TargetId target_id, Status error) {
   auto it = limbo_resolutions_by_target_.find(target_id);
   if (it != limbo_resolutions_by_target_.end()) {
     DocumentKey limbo_key = it->second.key;
+    RecordLimboResolution(it->second);
+
     // Since this query failed, we won't want to manually unlisten to it.
     // So go ahead and remove it from bookkeeping.
     limbo_targets_by_key_.erase(limbo_key);
@@ -331,6 +361,9 @@ void SyncEngine::HandleRejectedListen(TargetId target_id, Status error) {
                       std::move(target_mismatches), std::move(document_updates),
                       std::move(limbo_documents)};
     ApplyRemoteEvent(event);
+
+    // The failed target no longer counts against the limit.
+    PumpEnqueuedLimboResolutions();
   } else {
     local_store_->ReleaseTarget(target_id);
     RemoveAndCleanupTarget(target_id, error);
@@ -459,19 +492,13 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
   std::vector<ViewSnapshot> new_snapshots;
   std::vector<LocalViewChanges> document_changes_in_all_views;
 
+  std::unordered_map<QueryView*, MaybeDocumentMap> changes_by_view =
+      query_views_by_document_.Route(changes);
+  const MaybeDocumentMap no_changes;
+
+  std::vector<AffectedView> affected_views;
   for (const auto& entry : query_views_by_query_) {
     const auto& query_view = entry.second;
-    View& view = query_view->view();
-    ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(changes);
-    if (view_doc_changes.needs_refill()) {
-      // The query has a limit and some docs were removed/updated, so we need to
-      // re-run the query against the local store to make sure we didn't lose
-      // any good docs that had been past the limit.
-      QueryResult query_result = local_store_->ExecuteQuery(
-          query_view->query(), /* use_previous_results= */ false);
-      view_doc_changes = view.ComputeDocumentChanges(
-          query_result.documents().underlying_map(), view_doc_changes);
-    }
 
     absl::optional<TargetChange> target_changes;
     if (maybe_remote_event.has_value()) {
@@ -481,8 +508,27 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
         target_changes = it->second;
       }
     }
-    ViewChange view_change =
-        view.ApplyChanges(view_doc_changes, target_changes);
+
+    // A view can only change if one of the documents it could match changed
+    // or if its target did.
+    auto routed = changes_by_view.find(query_view.get());
+    if (routed == changes_by_view.end() && !target_changes) {
+      continue;
+    }
+    const MaybeDocumentMap& view_changes =
+        routed != changes_by_view.end() ? routed->second : no_changes;
+    affected_views.push_back(
+        AffectedView{query_view.get(), &view_changes, std::move(target_changes),
+                     absl::nullopt});
+  }
+
+  ComputeDocumentChanges(&affected_views);
+  RefillViews(&affected_views);
+
+  for (AffectedView& affected : affected_views) {
+    QueryView* query_view = affected.query_view;
+    ViewChange view_change = query_view->view().ApplyChanges(
+        *affected.doc_changes, affected.target_changes);
 
     UpdateTrackedLimboDocuments(view_change.limbo_changes(),
                                 query_view->target_id());
@@ -499,6 +545,64 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
   local_store_->NotifyLocalViewChanges(document_changes_in_all_views);
 }
 
+void SyncEngine::ComputeDocumentChanges(
+    std::vector<AffectedView>* affected_views) {
+  size_t count = affected_views->size();
+  size_t tasks_count =
+      std::min(count, static_cast<size_t>(view_computation_threads_));
+  if (!view_computation_executor_ || tasks_count < 2) {
+    for (AffectedView& affected : *affected_views) {
+      affected.doc_changes =
+          affected.query_view->view().ComputeDocumentChanges(*affected.changes);
+    }
+    return;
+  }
+
+  // Each view reads only its own state and the immutable changes routed to
+  // it, and writes only its own slot in `affected_views`, so the views can be
+  // computed independently. Views are split into one contiguous run per
+  // thread to keep the scheduling overhead independent of the number of
+  // views. Applying the results still happens on the worker queue.
+  AffectedView* views = affected_views->data();
+  BackgroundQueue tasks(view_computation_executor_.get());
+  for (size_t task = 0; task != tasks_count; ++task) {
+    size_t begin = count * task / tasks_count;
+    size_t end = count * (task + 1) / tasks_count;
+    tasks.Execute([views, begin, end] {
+      for (size_t i = begin; i != end; ++i) {
+        AffectedView& affected = views[i];
+        affected.doc_changes =
+            affected.query_view->view().ComputeDocumentChanges(
+                *affected.changes);
+      }
+    });
+  }
+  tasks.AwaitAll();
+}
+
+void SyncEngine::RefillViews(std::vector<AffectedView>* affected_views) {
+  // Views of queries with a limit whose documents were removed or updated need
+  // to re-run their query against the local store to make sure they didn't
+  // lose any good docs that had been past the limit. Refill them all at once
+  // so that limit queries over the same collection share one scan.
+  std::vector<AffectedView*> refills;
+  std::vector<Query> queries;
+  for (AffectedView& affected : *affected_views) {
+    if (affected.doc_changes->needs_refill()) {
+      refills.push_back(&affected);
+      queries.push_back(affected.query_view->query());
+    }
+  }
+  if (refills.empty()) return;
+
+  std::vector<QueryResult> results = local_store_->ExecuteQueries(queries);
+  for (size_t i = 0; i != refills.size(); ++i) {
+    AffectedView& affected = *refills[i];
+    affected.doc_changes = affected.query_view->view().ComputeDocumentChanges(
+        results[i].documents().underlying_map(), affected.doc_changes);
+  }
+}
+
 void SyncEngine::UpdateTrackedLimboDocuments(
     const std::vector<LimboDocumentChange>& limbo_changes, TargetId target_id) {
   for (const LimboDocumentChange& limbo_change : limbo_changes) {
@@ -527,21 +631,64 @@ void SyncEngine::UpdateTrackedLimboDocuments(
 void SyncEngine::TrackLimboChange(const LimboDocumentChange& limbo_change) {
   const DocumentKey& key = limbo_change.key();
 
-  if (limbo_targets_by_key_.find(key) == limbo_targets_by_key_.end()) {
+  if (limbo_targets_by_key_.find(key) == limbo_targets_by_key_.end() &&
+      enqueued_limbo_start_times_.find(key) ==
+          enqueued_limbo_start_times_.end()) {
     LOG_DEBUG("New document in limbo: %s", key.ToString());
+    enqueued_limbo_resolutions_.push_back(key);
+    enqueued_limbo_start_times_.emplace(key, Clock::now());
+    PumpEnqueuedLimboResolutions();
+  }
+}
+
+void SyncEngine::PumpEnqueuedLimboResolutions() {
+  while (!enqueued_limbo_resolutions_.empty() &&
+         limbo_targets_by_key_.size() < max_concurrent_limbo_resolutions_) {
+    DocumentKey key = std::move(enqueued_limbo_resolutions_.front());
+    enqueued_limbo_resolutions_.pop_front();
+
+    auto found = enqueued_limbo_start_times_.find(key);
+    HARD_ASSERT(found != enqueued_limbo_start_times_.end(),
+                "Enqueued limbo document %s has no start time",
+                key.ToString());
+    Clock::time_point start_time = found->second;
+    enqueued_limbo_start_times_.erase(found);
 
     TargetId limbo_target_id = target_id_generator_.NextId();
     Query query(key.path());
     TargetData target_data(query.ToTarget(), limbo_target_id,
                            kIrrelevantSequenceNumber,
                            QueryPurpose::LimboResolution);
-    limbo_resolutions_by_target_.emplace(limbo_target_id, LimboResolution{key});
-    remote_store_->Listen(target_data);
+    limbo_resolutions_by_target_.emplace(limbo_target_id,
+                                         LimboResolution{key, start_time});
     limbo_targets_by_key_[key] = limbo_target_id;
+    remote_store_->Listen(target_data);
   }
 }
 
+void SyncEngine::RecordLimboResolution(
+    const LimboResolution& limbo_resolution) {
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Clock::now() - limbo_resolution.start_time);
+  ++resolved_limbo_documents_;
+  total_limbo_resolution_time_ += elapsed;
+  max_limbo_resolution_time_ = std::max(max_limbo_resolution_time_, elapsed);
+}
+
 void SyncEngine::RemoveLimboTarget(const DocumentKey& key) {
+  if (enqueued_limbo_start_times_.erase(key) > 0) {
+    // The resolution never started, so there's no target to remove. Dropping
+    // the key from the queue takes linear time, but only happens when a
+    // document leaves limbo before its turn comes.
+    auto queued = std::find(enqueued_limbo_resolutions_.begin(),
+                            enqueued_limbo_resolutions_.end(), key);
+    HARD_ASSERT(queued != enqueued_limbo_resolutions_.end(),
+                "Enqueued limbo document %s is missing from the queue",
+                key.ToString());
+    enqueued_limbo_resolutions_.erase(queued);
+    return;
+  }
+
   auto it = limbo_targets_by_key_.find(key);
   if (it == limbo_targets_by_key_.end()) {
     // This target already got removed, because the query failed.
@@ -551,7 +698,24 @@ void SyncEngine::RemoveLimboTarget(const DocumentKey& key) {
   TargetId limbo_target_id = it->second;
   remote_store_->StopListening(limbo_target_id);
   limbo_targets_by_key_.erase(key);
-  limbo_resolutions_by_target_.erase(limbo_target_id);
+
+  auto resolution = limbo_resolutions_by_target_.find(limbo_target_id);
+  if (resolution != limbo_resolutions_by_target_.end()) {
+    RecordLimboResolution(resolution->second);
+    limbo_resolutions_by_target_.erase(resolution);
+  }
+
+  PumpEnqueuedLimboResolutions();
+}
+
+LimboResolutionStats SyncEngine::GetLimboResolutionStats() const {
+  LimboResolutionStats stats;
+  stats.enqueued = enqueued_limbo_start_times_.size();
+  stats.active = limbo_targets_by_key_.size();
+  stats.resolved = resolved_limbo_documents_;
+  stats.total_resolution_time = total_limbo_resolution_time_;
+  stats.max_resolution_time = max_limbo_resolution_time_;
+  return stats;
 }
 
 }  // namespace core
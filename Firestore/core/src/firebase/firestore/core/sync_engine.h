@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_SYNC_ENGINE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_SYNC_ENGINE_H_
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
@@ -25,11 +27,13 @@
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/core/query_index.h"
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
 #include "Firestore/core/src/firebase/firestore/core/view.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "absl/strings/string_view.h"
 
@@ -46,6 +50,25 @@ namespace core {
 class SyncEngineCallback;
 class ViewSnapshot;
 
+/** Statistics about the resolution of documents in limbo. */
+struct LimboResolutionStats {
+  /** The number of limbo documents waiting for a resolution target. */
+  size_t enqueued = 0;
+
+  /** The number of limbo documents with an active resolution target. */
+  size_t active = 0;
+
+  /** The number of limbo resolutions that have completed. */
+  size_t resolved = 0;
+
+  /**
+   * The total and the longest time from a document entering limbo until its
+   * resolution completed, across all completed resolutions.
+   */
+  std::chrono::milliseconds total_resolution_time{0};
+  std::chrono::milliseconds max_resolution_time{0};
+};
+
 /**
  * Interface implemented by `SyncEngine` to receive requests from
  * `EventManager`.
@@ -88,9 +111,22 @@ class QueryEventSource {
  */
 class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
  public:
+  /**
+   * The default maximum number of limbo documents that are resolved
+   * concurrently, each with its own listen target.
+   */
+  static constexpr size_t kDefaultMaxConcurrentLimboResolutions = 100;
+
+  /**
+   * @param max_concurrent_limbo_resolutions The maximum number of limbo
+   *     resolution targets to listen to at once. Further limbo documents are
+   *     queued until an active resolution completes.
+   */
   SyncEngine(local::LocalStore* local_store,
              remote::RemoteStore* remote_store,
-             const auth::User& initial_user);
+             const auth::User& initial_user,
+             size_t max_concurrent_limbo_resolutions =
+                 kDefaultMaxConcurrentLimboResolutions);
 
   // Implements `QueryEventSource`.
   void SetCallback(SyncEngineCallback* callback) override {
@@ -133,6 +169,16 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   void HandleCredentialChange(const auth::User& user);
 
+  /**
+   * Computes the document changes of views affected by a change in parallel,
+   * on the given number of threads. By default, views are recomputed serially
+   * on the worker queue.
+   *
+   * Either way, the computed changes are applied to the views, limbo documents
+   * are tracked, and snapshots are raised serially, in the same order.
+   */
+  void EnableParallelViewComputation(int threads);
+
   // Implements `RemoteStoreCallback`
   void ApplyRemoteEvent(const remote::RemoteEvent& remote_event) override;
   void HandleRejectedListen(model::TargetId target_id,
@@ -144,6 +190,9 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   void HandleOnlineStateChange(model::OnlineState online_state) override;
   model::DocumentKeySet GetRemoteKeys(model::TargetId target_id) const override;
 
+  /** Returns statistics about the resolution of documents in limbo. */
+  LimboResolutionStats GetLimboResolutionStats() const;
+
   // For tests only
   std::map<model::DocumentKey, model::TargetId> GetCurrentLimboDocuments()
       const {
@@ -151,6 +200,12 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
     return limbo_targets_by_key_;
   }
 
+  // For tests only
+  std::vector<model::DocumentKey> GetEnqueuedLimboDocuments() const {
+    return {enqueued_limbo_resolutions_.begin(),
+            enqueued_limbo_resolutions_.end()};
+  }
+
  private:
   /**
    * QueryView contains all of the info that SyncEngine needs to track for a
@@ -192,16 +247,22 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
     View view_;
   };
 
+  using Clock = std::chrono::steady_clock;
+
   /** Tracks a limbo resolution. */
   class LimboResolution {
    public:
     LimboResolution() = default;
 
-    explicit LimboResolution(const model::DocumentKey& key) : key{key} {
+    LimboResolution(const model::DocumentKey& key, Clock::time_point start_time)
+        : key{key}, start_time{start_time} {
     }
 
     model::DocumentKey key;
 
+    /** When the document entered limbo. */
+    Clock::time_point start_time;
+
     /**
      * Set to true once we've received a document. This is used in
      * RemoteKeysForTarget and ultimately used by `WatchChangeAggregator` to
@@ -211,6 +272,19 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
     bool document_received = false;
   };
 
+  /** A view that may be changed by a batch of document changes. */
+  struct AffectedView {
+    QueryView* query_view;
+
+    /** The changed documents that the view's query could match. */
+    const model::MaybeDocumentMap* changes;
+
+    absl::optional<remote::TargetChange> target_changes;
+
+    /** The result of `View::ComputeDocumentChanges` for `changes`. */
+    absl::optional<ViewDocumentChanges> doc_changes;
+  };
+
   void AssertCallbackExists(absl::string_view source);
 
   ViewSnapshot InitializeViewAndComputeSnapshot(const Query& query,
@@ -218,12 +292,27 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   void RemoveAndCleanupTarget(model::TargetId target_id, util::Status status);
 
+  /** Removes the QueryView for the given query from all indexes. */
+  void RemoveQueryView(const Query& query);
+
   void RemoveLimboTarget(const model::DocumentKey& key);
 
   void EmitNewSnapshotsAndNotifyLocalStore(
       const model::MaybeDocumentMap& changes,
       const absl::optional<remote::RemoteEvent>& maybe_remote_event);
 
+  /**
+   * Computes the document changes of each of the given views, in parallel if
+   * parallel view computation has been enabled.
+   */
+  void ComputeDocumentChanges(std::vector<AffectedView>* affected_views);
+
+  /**
+   * Recomputes the document changes of the given views that need a refill
+   * from the local store, scanning each collection at most once.
+   */
+  void RefillViews(std::vector<AffectedView>* affected_views);
+
   /** Updates the limbo document state for the given target_id. */
   void UpdateTrackedLimboDocuments(
       const std::vector<LimboDocumentChange>& limbo_changes,
@@ -231,6 +320,15 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   void TrackLimboChange(const LimboDocumentChange& limbo_change);
 
+  /**
+   * Starts listens for enqueued limbo documents until the maximum number of
+   * concurrent limbo resolutions is reached.
+   */
+  void PumpEnqueuedLimboResolutions();
+
+  /** Records that the given active limbo resolution has completed. */
+  void RecordLimboResolution(const LimboResolution& limbo_resolution);
+
   void NotifyUser(model::BatchId batch_id, util::Status status);
 
   /**
@@ -270,6 +368,13 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   /** QueryViews for all active queries, indexed by query. */
   std::unordered_map<Query, std::shared_ptr<QueryView>> query_views_by_query_;
 
+  /**
+   * The same QueryViews as in `query_views_by_query_`, indexed by the
+   * documents they could match so that changes are only routed to the views
+   * they can affect.
+   */
+  QueryIndex<QueryView*> query_views_by_document_;
+
   /** Queries mapped to Targets, indexed by target ID. */
   std::unordered_map<model::TargetId, std::vector<Query>> queries_by_target_;
 
@@ -289,6 +394,27 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   /** Used to track any documents that are currently in limbo. */
   local::ReferenceSet limbo_document_refs_;
+
+  /** The maximum number of limbo resolution targets to listen to at once. */
+  size_t max_concurrent_limbo_resolutions_ = 0;
+
+  /**
+   * Limbo documents that are waiting for a resolution target, in the order
+   * they entered limbo. Holds the same keys as `enqueued_limbo_start_times_`.
+   */
+  std::deque<model::DocumentKey> enqueued_limbo_resolutions_;
+
+  /** The time each enqueued limbo document entered limbo. */
+  std::map<model::DocumentKey, Clock::time_point> enqueued_limbo_start_times_;
+
+  /** Statistics about completed limbo resolutions. */
+  size_t resolved_limbo_documents_ = 0;
+  std::chrono::milliseconds total_limbo_resolution_time_{0};
+  std::chrono::milliseconds max_limbo_resolution_time_{0};
+
+  /** If set, the executor on which views are recomputed in parallel. */
+  std::unique_ptr<util::Executor> view_computation_executor_;
+  int view_computation_threads_ = 1;
 };
 
 }  // namespace core
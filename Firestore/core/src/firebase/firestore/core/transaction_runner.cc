@@ -64,9 +64,11 @@ void TransactionRunner::Run() {
         shared_this->remote_store_->CreateTransaction();
     shared_this->update_callback_(
         transaction, [transaction, shared_this](const util::Status& status) {
-          shared_this->queue_->Enqueue([transaction, shared_this, status] {
-            shared_this->ContinueCommit(transaction, status);
-          });
+          shared_this->queue_->Enqueue(
+              AsyncQueue::Priority::Normal, "transaction_runner.commit",
+              [transaction, shared_this, status] {
+                shared_this->ContinueCommit(transaction, status);
+              });
         });
   });
 }
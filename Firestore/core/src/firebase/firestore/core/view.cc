@@ -17,10 +17,12 @@
 #include "Firestore/core/src/firebase/firestore/core/view.h"
 
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/target.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 
 namespace firebase {
 namespace firestore {
@@ -97,6 +99,10 @@ ComparisonResult View::Compare(const Document& lhs, const Document& rhs) const {
 ViewDocumentChanges View::ComputeDocumentChanges(
     const MaybeDocumentMap& doc_changes,
     const absl::optional<ViewDocumentChanges>& previous_changes) const {
+  TRACE_SPAN("view.compute_document_changes");
+  METRICS_HISTOGRAM_RECORD("view.compute_document_changes.documents",
+                           static_cast<int64_t>(doc_changes.size()));
+
   DocumentViewChangeSet change_set;
   if (previous_changes) {
     change_set = previous_changes->change_set();
@@ -130,6 +136,11 @@ ViewDocumentChanges View::ComputeDocumentChanges(
     first_doc_in_limit = old_document_set.GetFirstDocument();
   }
 
+  // Documents entering a limit query are applied only after all changes to
+  // documents already in the view, once the limit boundary can only move
+  // inwards. Most of them can then be rejected with a single comparison.
+  std::vector<Document> limit_candidates;
+
   for (const auto& kv : doc_changes) {
     const DocumentKey& key = kv.first;
     const MaybeDocument& maybe_new_doc = kv.second;
@@ -161,7 +172,7 @@ ViewDocumentChanges View::ComputeDocumentChanges(
     bool change_applied = false;
     // Calculate change
     if (old_doc && new_doc) {
-      bool docs_equal = old_doc->data() == new_doc->data();
+      bool docs_equal = old_doc->HasEqualData(*new_doc);
       if (!docs_equal) {
         if (!ShouldWaitForSyncedDocument(*new_doc, *old_doc)) {
           change_set.AddChange(
@@ -189,6 +200,10 @@ ViewDocumentChanges View::ComputeDocumentChanges(
       }
 
     } else if (!old_doc && new_doc) {
+      if (query_.limit_type() != LimitType::None) {
+        limit_candidates.push_back(std::move(*new_doc));
+        continue;
+      }
       change_set.AddChange(
           DocumentViewChange{*new_doc, DocumentViewChange::Type::Added});
       change_applied = true;
@@ -220,6 +235,37 @@ ViewDocumentChanges View::ComputeDocumentChanges(
     }
   }
 
+  // Accumulate the top documents among the candidates, keeping the document
+  // set within the limit as it goes. A candidate that is added and then
+  // dropped again nets out to no change at all.
+  for (Document& doc : limit_candidates) {
+    auto limit = static_cast<size_t>(query_.limit());
+    if (new_document_set.size() >= limit &&
+        IsOutsideLimit(new_document_set, doc)) {
+      new_mutated_keys = new_mutated_keys.erase(doc.key());
+      continue;
+    }
+
+    if (doc.has_local_mutations()) {
+      new_mutated_keys = new_mutated_keys.insert(doc.key());
+    } else {
+      new_mutated_keys = new_mutated_keys.erase(doc.key());
+    }
+    new_document_set = new_document_set.insert(doc);
+    change_set.AddChange(
+        DocumentViewChange{std::move(doc), DocumentViewChange::Type::Added});
+
+    if (new_document_set.size() > limit) {
+      Document dropped = query_.has_limit_to_first()
+                             ? *new_document_set.GetLastDocument()
+                             : *new_document_set.GetFirstDocument();
+      new_document_set = new_document_set.erase(dropped.key());
+      new_mutated_keys = new_mutated_keys.erase(dropped.key());
+      change_set.AddChange(
+          DocumentViewChange{dropped, DocumentViewChange::Type::Removed});
+    }
+  }
+
   // Drop documents out to meet limitToFirst/limitToLast requirement.
   if (query_.limit_type() != LimitType::None) {
     auto limit = static_cast<size_t>(query_.limit());
@@ -244,6 +290,15 @@ ViewDocumentChanges View::ComputeDocumentChanges(
                              new_mutated_keys, needs_refill);
 }
 
+bool View::IsOutsideLimit(const DocumentSet& document_set,
+                          const Document& doc) const {
+  if (query_.has_limit_to_first()) {
+    return util::Descending(Compare(doc, *document_set.GetLastDocument()));
+  } else {
+    return util::Ascending(Compare(doc, *document_set.GetFirstDocument()));
+  }
+}
+
 bool View::ShouldWaitForSyncedDocument(const Document& new_doc,
                                        const Document& old_doc) const {
   // We suppress the initial change event for documents that were modified as
@@ -356,16 +411,14 @@ void View::ApplyTargetChange(
   if (maybe_target_change.has_value()) {
     const TargetChange& target_change = maybe_target_change.value();
 
-    for (const DocumentKey& key : target_change.added_documents()) {
-      synced_documents_ = synced_documents_.insert(key);
-    }
+    synced_documents_ =
+        synced_documents_.union_with(target_change.added_documents());
     for (const DocumentKey& key : target_change.modified_documents()) {
       HARD_ASSERT(synced_documents_.find(key) != synced_documents_.end(),
                   "Modified document %s not found in view.", key.ToString());
     }
-    for (const DocumentKey& key : target_change.removed_documents()) {
-      synced_documents_ = synced_documents_.erase(key);
-    }
+    synced_documents_ =
+        synced_documents_.difference_with(target_change.removed_documents());
 
     current_ = target_change.current();
   }
@@ -392,15 +445,13 @@ std::vector<LimboDocumentChange> View::UpdateLimboDocuments() {
   std::vector<LimboDocumentChange> changes;
   changes.reserve(old_limbo_documents.size() + limbo_documents_.size());
 
-  for (const DocumentKey& key : old_limbo_documents) {
-    if (!limbo_documents_.contains(key)) {
-      changes.push_back(LimboDocumentChange::Removed(key));
-    }
+  for (const DocumentKey& key :
+       old_limbo_documents.difference_with(limbo_documents_)) {
+    changes.push_back(LimboDocumentChange::Removed(key));
   }
-  for (const DocumentKey& key : limbo_documents_) {
-    if (!old_limbo_documents.contains(key)) {
-      changes.push_back(LimboDocumentChange::Added(key));
-    }
+  for (const DocumentKey& key :
+       limbo_documents_.difference_with(old_limbo_documents)) {
+    changes.push_back(LimboDocumentChange::Added(key));
   }
   return changes;
 }
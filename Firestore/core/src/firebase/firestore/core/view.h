@@ -198,6 +198,13 @@ class View {
 
   bool ShouldBeInLimbo(const model::DocumentKey& key) const;
 
+  /**
+   * Returns true if `doc` sorts beyond the limit boundary of the (full)
+   * `document_set`, and so would be dropped again if it were added.
+   */
+  bool IsOutsideLimit(const model::DocumentSet& document_set,
+                      const model::Document& doc) const;
+
   bool ShouldWaitForSyncedDocument(const model::Document& new_doc,
                                    const model::Document& old_doc) const;
 
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 
+#include <algorithm>
 #include <ostream>
 
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
@@ -147,7 +148,8 @@ ViewSnapshot::ViewSnapshot(Query query,
     : query_{std::move(query)},
       documents_{std::move(documents)},
       old_documents_{std::move(old_documents)},
-      document_changes_{std::move(document_changes)},
+      document_changes_{std::make_shared<std::vector<DocumentViewChange>>(
+          std::move(document_changes))},
       mutated_keys_{std::move(mutated_keys)},
       from_cache_{from_cache},
       sync_state_changed_{sync_state_changed},
@@ -180,6 +182,28 @@ const Query& ViewSnapshot::query() const {
   return query_;
 }
 
+ViewSnapshot ViewSnapshot::ExcludingMetadataChanges() const {
+  ViewSnapshot result = *this;
+  result.excludes_metadata_changes_ = true;
+
+  auto is_metadata_change = [](const DocumentViewChange& change) {
+    return change.type() == DocumentViewChange::Type::Metadata;
+  };
+  if (std::none_of(document_changes_->begin(), document_changes_->end(),
+                   is_metadata_change)) {
+    return result;
+  }
+
+  auto changes = std::make_shared<std::vector<DocumentViewChange>>();
+  for (const DocumentViewChange& change : *document_changes_) {
+    if (!is_metadata_change(change)) {
+      changes->push_back(change);
+    }
+  }
+  result.document_changes_ = std::move(changes);
+  return result;
+}
+
 std::string ViewSnapshot::ToString() const {
   return StringFormat(
       "<ViewSnapshot query: %s documents: %s old_documents: %s changes: %s "
@@ -131,7 +131,7 @@ class ViewSnapshot {
 
   /** The set of changes that have been applied to the documents. */
   const std::vector<DocumentViewChange>& document_changes() const {
-    return document_changes_;
+    return *document_changes_;
   }
 
   /** Whether any document in the snapshot was served from the local cache. */
@@ -159,6 +159,13 @@ class ViewSnapshot {
     return mutated_keys_;
   }
 
+  /**
+   * Returns this snapshot without any metadata-only document changes. The
+   * result shares the documents and, if there are no metadata-only changes,
+   * the list of changes with this snapshot.
+   */
+  ViewSnapshot ExcludingMetadataChanges() const;
+
   std::string ToString() const;
   friend std::ostream& operator<<(std::ostream& out, const ViewSnapshot& value);
   size_t Hash() const;
@@ -168,7 +175,10 @@ class ViewSnapshot {
 
   model::DocumentSet documents_;
   model::DocumentSet old_documents_;
-  std::vector<DocumentViewChange> document_changes_;
+
+  // Snapshots are copied once per listener, so share the changes rather than
+  // copying them each time.
+  std::shared_ptr<const std::vector<DocumentViewChange>> document_changes_;
   model::DocumentKeySet mutated_keys_;
 
   bool from_cache_ = false;
@@ -152,6 +152,21 @@ class ArraySortedMap : public SortedMapBase {
       : array_{SortedArray(entries, comparator)}, comparator_{comparator} {
   }
 
+  /**
+   * Creates an ArraySortedMap from a random access range of pairs that is
+   * already sorted by key and free of duplicates.
+   */
+  template <typename RandomIt>
+  static ArraySortedMap CreateFromSorted(RandomIt first,
+                                         RandomIt last,
+                                         const C& comparator) {
+    if (first == last) {
+      return ArraySortedMap{comparator};
+    }
+    return ArraySortedMap{std::make_shared<const array_type>(first, last),
+                          comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return size() == 0;
@@ -19,8 +19,10 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/llrb_node_iterator.h"
+#include "Firestore/core/src/firebase/firestore/immutable/node_pool.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 
@@ -92,6 +94,13 @@ class LlrbNode : public SortedMapBase {
     return rep_->right_;
   }
 
+  /**
+   * Builds a tree containing the entries in the range [first, last), which
+   * must already be sorted and free of duplicates, in linear time.
+   */
+  template <typename RandomIt>
+  static LlrbNode FromSortedRange(RandomIt first, RandomIt last);
+
   /** Returns a tree node with the given key-value pair set/updated. */
   template <typename Comparator>
   LlrbNode insert(const K& key,
@@ -149,7 +158,14 @@ class LlrbNode : public SortedMapBase {
     LlrbNode right_;
   };
 
-  explicit LlrbNode(Rep rep) : rep_{std::make_shared<Rep>(std::move(rep))} {
+  /**
+   * Allocates a new Rep from the NodePool. Trees churn through nodes on every
+   * insert and erase so recycling their storage avoids most trips through the
+   * global allocator.
+   */
+  explicit LlrbNode(Rep rep)
+      : rep_{std::allocate_shared<Rep>(NodePoolAllocator<Rep>{},
+                                       std::move(rep))} {
   }
 
   explicit LlrbNode(const std::shared_ptr<Rep>& rep) : rep_{rep} {
@@ -213,6 +229,9 @@ class LlrbNode : public SortedMapBase {
     rep_->right_ = std::move(right);
   }
 
+  template <typename RandomIt>
+  static LlrbNode BuildBalanced(RandomIt first, size_type size);
+
   template <typename Comparator>
   LlrbNode InnerInsert(const K& key,
                        const V& value,
@@ -239,6 +258,77 @@ class LlrbNode : public SortedMapBase {
   std::shared_ptr<Rep> rep_;
 };
 
+/**
+ * Builds a valid left-leaning red-black tree out of a sorted range without any
+ * comparisons or rebalancing.
+ *
+ * The entries are divided into a chain of "pennants", each of which is a node
+ * whose right child is a perfectly balanced all-black tree of 2^k - 1
+ * entries. Pennants are chained through their left links with sizes halving
+ * at each step, so every path from the root encounters the same number of
+ * black nodes. Where the binary representation of `size + 1` calls for an
+ * extra pennant at some level, it is colored red and hung off the left of the
+ * black one, which keeps all red links leaning left.
+ */
+template <typename K, typename V>
+template <typename RandomIt>
+LlrbNode<K, V> LlrbNode<K, V>::FromSortedRange(RandomIt first,
+                                               RandomIt last) {
+  auto size = static_cast<size_type>(last - first);
+  if (size == 0) {
+    return LlrbNode{};
+  }
+
+  struct Pennant {
+    size_type start;
+    size_type chunk_size;
+    Color color;
+  };
+
+  // Walk the bits of `size + 1` below its most significant bit, from highest
+  // to lowest, assigning entries from the end of the range.
+  size_type total = size + 1;
+  int levels = 0;
+  while ((total >> (levels + 1)) != 0) {
+    ++levels;
+  }
+
+  std::vector<Pennant> pennants;
+  size_type index = size;
+  for (int level = levels - 1; level >= 0; --level) {
+    size_type chunk_size = size_type{1} << level;
+    index -= chunk_size;
+    pennants.push_back({index, chunk_size, Color::Black});
+    if ((total & chunk_size) != 0) {
+      index -= chunk_size;
+      pennants.push_back({index, chunk_size, Color::Red});
+    }
+  }
+
+  // Assemble bottom-up so that each Rep is created with its final children.
+  LlrbNode result;
+  for (auto it = pennants.rbegin(); it != pennants.rend(); ++it) {
+    LlrbNode right = BuildBalanced(first + it->start + 1, it->chunk_size - 1);
+    result = LlrbNode{Rep{value_type{*(first + it->start)}, it->color,
+                          std::move(result), std::move(right)}};
+  }
+  return result;
+}
+
+template <typename K, typename V>
+template <typename RandomIt>
+LlrbNode<K, V> LlrbNode<K, V>::BuildBalanced(RandomIt first, size_type size) {
+  if (size == 0) {
+    return LlrbNode{};
+  }
+
+  size_type half = size / 2;
+  LlrbNode left = BuildBalanced(first, half);
+  LlrbNode right = BuildBalanced(first + half + 1, half);
+  return LlrbNode{Rep{value_type{*(first + half)}, Color::Black,
+                      std::move(left), std::move(right)}};
+}
+
 template <typename K, typename V>
 template <typename Comparator>
 LlrbNode<K, V> LlrbNode<K, V>::insert(const K& key,
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/node_pool.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif  // defined(_WIN32)
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+constexpr size_t NodePool::kAlignment;
+constexpr size_t NodePool::kMaxFreeBlocks;
+constexpr size_t NodePool::kThreadCacheSize;
+constexpr size_t NodePool::kTransferSize;
+
+/** The free blocks of one pool cached by one thread. */
+struct NodePool::ThreadCache {
+  NodePool* pool = nullptr;
+  FreeBlock* head = nullptr;
+  size_t count = 0;
+};
+
+/**
+ * Holds each thread's `ThreadCache` for one pool, and returns a thread's
+ * blocks to the pool when the thread exits.
+ */
+class NodePool::ThreadCacheSlot {
+ public:
+  ThreadCacheSlot() {
+#if defined(_WIN32)
+    index_ = FlsAlloc(&OnThreadExit);
+    HARD_ASSERT(index_ != FLS_OUT_OF_INDEXES,
+                "Failed to allocate a thread cache index");
+#else
+    int result = pthread_key_create(&key_, &OnThreadExit);
+    HARD_ASSERT(result == 0, "Failed to create a thread cache key: %s",
+                result);
+#endif  // defined(_WIN32)
+  }
+
+  ~ThreadCacheSlot() {
+#if defined(_WIN32)
+    FlsFree(index_);
+#else
+    pthread_key_delete(key_);
+#endif  // defined(_WIN32)
+  }
+
+  ThreadCacheSlot(const ThreadCacheSlot&) = delete;
+  ThreadCacheSlot& operator=(const ThreadCacheSlot&) = delete;
+
+  ThreadCache* Get() const {
+#if defined(_WIN32)
+    return static_cast<ThreadCache*>(FlsGetValue(index_));
+#else
+    return static_cast<ThreadCache*>(pthread_getspecific(key_));
+#endif  // defined(_WIN32)
+  }
+
+  void Set(ThreadCache* cache) {
+#if defined(_WIN32)
+    FlsSetValue(index_, cache);
+#else
+    pthread_setspecific(key_, cache);
+#endif  // defined(_WIN32)
+  }
+
+ private:
+#if defined(_WIN32)
+  static void NTAPI OnThreadExit(void* value) {
+#else
+  static void OnThreadExit(void* value) {
+#endif  // defined(_WIN32)
+    if (!value) return;
+
+    auto* cache = static_cast<ThreadCache*>(value);
+    cache->pool->Spill(cache, cache->count);
+    delete cache;
+  }
+
+#if defined(_WIN32)
+  DWORD index_ = FLS_OUT_OF_INDEXES;
+#else
+  pthread_key_t key_;
+#endif  // defined(_WIN32)
+};
+
+NodePool::NodePool(size_t block_size)
+    : block_size_(RoundUp(block_size)),
+      thread_caches_(new ThreadCacheSlot()) {
+  HARD_ASSERT(block_size_ >= sizeof(FreeBlock),
+              "Block size %s is too small to pool", block_size_);
+}
+
+NodePool::~NodePool() {
+  ThreadCache* cache = thread_caches_->Get();
+  if (cache) {
+    Spill(cache, cache->count);
+    thread_caches_->Set(nullptr);
+    delete cache;
+  }
+  thread_caches_.reset();
+
+  while (free_list_) {
+    FreeBlock* next = free_list_->next;
+    ::operator delete(free_list_);
+    free_list_ = next;
+  }
+}
+
+size_t NodePool::free_blocks() const {
+  const ThreadCache* cache = thread_caches_->Get();
+  size_t cached = cache ? cache->count : 0;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached + free_count_;
+}
+
+void* NodePool::Allocate() {
+  ThreadCache& cache = LocalCache();
+  if (!cache.head) Refill(&cache);
+
+  FreeBlock* block = cache.head;
+  if (block) {
+    cache.head = block->next;
+    --cache.count;
+    return block;
+  }
+
+  return ::operator new(block_size_);
+}
+
+void NodePool::Deallocate(void* ptr) {
+  if (!ptr) return;
+
+  ThreadCache& cache = LocalCache();
+  if (cache.count == kThreadCacheSize) Spill(&cache, kTransferSize);
+
+  auto* block = static_cast<FreeBlock*>(ptr);
+  block->next = cache.head;
+  cache.head = block;
+  ++cache.count;
+}
+
+NodePool::ThreadCache& NodePool::LocalCache() {
+  ThreadCache* cache = thread_caches_->Get();
+  if (!cache) {
+    cache = new ThreadCache();
+    cache->pool = this;
+    thread_caches_->Set(cache);
+  }
+  return *cache;
+}
+
+void NodePool::Refill(ThreadCache* cache) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (cache->count < kTransferSize && free_list_) {
+    FreeBlock* block = free_list_;
+    free_list_ = block->next;
+    --free_count_;
+
+    block->next = cache->head;
+    cache->head = block;
+    ++cache->count;
+  }
+}
+
+void NodePool::Spill(ThreadCache* cache, size_t count) {
+  FreeBlock* overflow = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < count; ++i) {
+      FreeBlock* block = cache->head;
+      cache->head = block->next;
+      --cache->count;
+
+      if (free_count_ < kMaxFreeBlocks) {
+        block->next = free_list_;
+        free_list_ = block;
+        ++free_count_;
+      } else {
+        block->next = overflow;
+        overflow = block;
+      }
+    }
+  }
+
+  while (overflow) {
+    FreeBlock* next = overflow->next;
+    ::operator delete(overflow);
+    overflow = next;
+  }
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_NODE_POOL_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_NODE_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <new>
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A pool of fixed-size memory blocks that caches freed blocks for reuse.
+ *
+ * Immutable containers constantly allocate new nodes along the path to a
+ * modified entry and release the nodes they replaced. In steady state this
+ * means that nearly every allocation can be satisfied by a block that was
+ * recently returned, avoiding a round trip through the global allocator.
+ *
+ * NodePool is safe to use from multiple threads: blocks may be freed on a
+ * different thread than the one that allocated them, which happens routinely
+ * when containers are handed from the worker queue to user callbacks.
+ *
+ * Each thread keeps a small cache of free blocks in front of a free list
+ * shared by all threads, so that the shared list's lock is only taken to move
+ * blocks between the two in batches. A thread's cache returns to the shared
+ * list when the thread exits. (Threads are tracked with pthread keys or fiber
+ * local storage rather than `thread_local`, which iOS 8 lacks.)
+ *
+ * The number of cached free blocks is bounded so that a transient spike in
+ * container size does not permanently retain memory.
+ */
+class NodePool {
+ public:
+  /**
+   * The granularity of block sizes. All blocks are aligned to this boundary
+   * and their sizes are rounded up to a multiple of it.
+   */
+  static constexpr size_t kAlignment = alignof(std::max_align_t);
+
+  /** The maximum number of free blocks on each pool's shared list. */
+  static constexpr size_t kMaxFreeBlocks = 4096;
+
+  /** The maximum number of free blocks each thread caches per pool. */
+  static constexpr size_t kThreadCacheSize = 64;
+
+  /**
+   * The number of blocks moved at once between a thread's cache and the
+   * shared list.
+   */
+  static constexpr size_t kTransferSize = kThreadCacheSize / 2;
+
+  explicit NodePool(size_t block_size);
+
+  /**
+   * Frees the blocks on the shared list and in the calling thread's cache.
+   * Blocks cached by other threads that are still running are leaked, so
+   * pools other than those returned by `ForSize` should only be used by one
+   * thread at a time.
+   */
+  ~NodePool();
+
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+  /**
+   * Returns the pool that serves blocks of at least the given size. Pools are
+   * never destroyed so that containers with static storage duration can
+   * safely release their nodes during program exit.
+   */
+  template <size_t Size>
+  static NodePool& ForSize() {
+    return ForBlockSize<RoundUp(Size)>();
+  }
+
+  static constexpr size_t RoundUp(size_t size) {
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  size_t block_size() const {
+    return block_size_;
+  }
+
+  /**
+   * Returns the number of freed blocks currently available for reuse by the
+   * calling thread: those in its cache plus those on the shared list.
+   */
+  size_t free_blocks() const;
+
+  void* Allocate();
+  void Deallocate(void* block);
+
+ private:
+  template <size_t BlockSize>
+  static NodePool& ForBlockSize() {
+    static NodePool* pool = new NodePool(BlockSize);
+    return *pool;
+  }
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct ThreadCache;
+  class ThreadCacheSlot;
+
+  /** Returns the calling thread's cache, creating it if necessary. */
+  ThreadCache& LocalCache();
+
+  /** Moves up to `kTransferSize` blocks from the shared list to `cache`. */
+  void Refill(ThreadCache* cache);
+
+  /**
+   * Moves `count` blocks from `cache` to the shared list, freeing those that
+   * don't fit.
+   */
+  void Spill(ThreadCache* cache, size_t count);
+
+  const size_t block_size_;
+  std::unique_ptr<ThreadCacheSlot> thread_caches_;
+
+  mutable std::mutex mutex_;
+  FreeBlock* free_list_ = nullptr;
+  size_t free_count_ = 0;
+};
+
+/**
+ * A standard allocator that serves single-object allocations from a NodePool
+ * matching the size of `T`. Array allocations fall through to the global
+ * allocator.
+ *
+ * This is intended for use with `std::allocate_shared`, which allocates the
+ * object and its reference counts in a single block, so the pool is keyed on
+ * the size of that combined block rather than the size of the object alone.
+ */
+template <typename T>
+class NodePoolAllocator {
+ public:
+  using value_type = T;
+
+  static_assert(alignof(T) <= NodePool::kAlignment,
+                "NodePool cannot satisfy over-aligned types");
+
+  NodePoolAllocator() = default;
+
+  template <typename U>
+  NodePoolAllocator(const NodePoolAllocator<U>&) noexcept {  // NOLINT
+  }
+
+  T* allocate(size_t n) {
+    if (n == 1) {
+      return static_cast<T*>(NodePool::ForSize<sizeof(T)>().Allocate());
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) noexcept {
+    if (n == 1) {
+      NodePool::ForSize<sizeof(T)>().Deallocate(ptr);
+    } else {
+      ::operator delete(ptr);
+    }
+  }
+
+  template <typename U>
+  friend bool operator==(const NodePoolAllocator&,
+                         const NodePoolAllocator<U>&) noexcept {
+    return true;
+  }
+
+  template <typename U>
+  friend bool operator!=(const NodePoolAllocator&,
+                         const NodePoolAllocator<U>&) noexcept {
+    return false;
+  }
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_NODE_POOL_H_
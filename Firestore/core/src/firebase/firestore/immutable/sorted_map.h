@@ -73,6 +73,21 @@ class SortedMap : public SortedMapBase {
     }
   }
 
+  /**
+   * Creates a SortedMap from a random access range of entries that is already
+   * sorted by key and free of duplicates. This takes linear time, as opposed
+   * to inserting the entries one by one.
+   */
+  template <typename RandomIt>
+  static SortedMap FromSortedRange(RandomIt first,
+                                   RandomIt last,
+                                   const C& comparator = {}) {
+    if (static_cast<size_type>(last - first) <= kFixedSize) {
+      return SortedMap{array_type::CreateFromSorted(first, last, comparator)};
+    }
+    return SortedMap{tree_type::CreateFromSorted(first, last, comparator)};
+  }
+
   SortedMap(const SortedMap& other) : tag_{other.tag_} {
     switch (tag_) {
       case Tag::Array:
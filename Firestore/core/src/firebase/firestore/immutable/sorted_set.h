@@ -19,9 +19,11 @@
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/util/bits.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/empty.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -74,21 +76,179 @@ class SortedSet : public SortedContainer {
     return SortedSet{map_.insert(key, {})};
   }
 
+  /**
+   * Returns a set containing the elements of both this set and `other`.
+   *
+   * When one set is much smaller than the other, its elements are inserted
+   * into the larger one, which shares all untouched subtrees with the
+   * original. Otherwise the two sets are merged in a single pass and the
+   * result is built in O(n + m).
+   */
   ABSL_MUST_USE_RESULT SortedSet union_with(const SortedSet& other) const {
-    const SortedSet* result_ptr = this;
-    const SortedSet* other_ptr = &other;
+    const SortedSet* larger = this;
+    const SortedSet* smaller = &other;
+
+    // Make sure `larger` always points to the larger one of the two sets.
+    if (larger->size() < smaller->size()) {
+      std::swap(larger, smaller);
+    }
+
+    if (smaller->empty()) {
+      return *larger;
+    }
+
+    if (PreferIncremental(smaller->size(), larger->size())) {
+      SortedSet result = *larger;
+      for (const K& key : *smaller) {
+        if (!result.contains(key)) {
+          result = result.insert(key);
+        }
+      }
+      return result;
+    }
+
+    std::vector<entry_type> merged;
+    merged.reserve(size() + other.size());
+
+    const C& comparator = this->comparator();
+    const_iterator lhs = begin();
+    const_iterator lhs_end = end();
+    const_iterator rhs = other.begin();
+    const_iterator rhs_end = other.end();
+    while (lhs != lhs_end && rhs != rhs_end) {
+      util::ComparisonResult cmp = comparator.Compare(*lhs, *rhs);
+      if (util::Ascending(cmp)) {
+        merged.emplace_back(*lhs, util::Empty{});
+        ++lhs;
+      } else if (util::Descending(cmp)) {
+        merged.emplace_back(*rhs, util::Empty{});
+        ++rhs;
+      } else {
+        merged.emplace_back(*lhs, util::Empty{});
+        ++lhs;
+        ++rhs;
+      }
+    }
+    for (; lhs != lhs_end; ++lhs) {
+      merged.emplace_back(*lhs, util::Empty{});
+    }
+    for (; rhs != rhs_end; ++rhs) {
+      merged.emplace_back(*rhs, util::Empty{});
+    }
+
+    if (merged.size() == larger->size()) {
+      // The smaller set was entirely contained in the larger one.
+      return *larger;
+    }
+    return FromSorted(merged);
+  }
+
+  /**
+   * Returns a set containing only the elements present in both this set and
+   * `other`.
+   *
+   * Runs in O(n + m), or in O(m log n) when one set is much smaller than the
+   * other. If the result has the same contents as either input, that input is
+   * returned as is.
+   */
+  ABSL_MUST_USE_RESULT SortedSet intersection_with(
+      const SortedSet& other) const {
+    const SortedSet* larger = this;
+    const SortedSet* smaller = &other;
+    if (larger->size() < smaller->size()) {
+      std::swap(larger, smaller);
+    }
+
+    if (smaller->empty()) {
+      return SortedSet{comparator()};
+    }
+
+    std::vector<entry_type> common;
+    if (PreferIncremental(smaller->size(), larger->size())) {
+      for (const K& key : *smaller) {
+        if (larger->contains(key)) {
+          common.emplace_back(key, util::Empty{});
+        }
+      }
+
+    } else {
+      const C& comparator = this->comparator();
+      const_iterator lhs = begin();
+      const_iterator lhs_end = end();
+      const_iterator rhs = other.begin();
+      const_iterator rhs_end = other.end();
+      while (lhs != lhs_end && rhs != rhs_end) {
+        util::ComparisonResult cmp = comparator.Compare(*lhs, *rhs);
+        if (util::Ascending(cmp)) {
+          ++lhs;
+        } else if (util::Descending(cmp)) {
+          ++rhs;
+        } else {
+          common.emplace_back(*lhs, util::Empty{});
+          ++lhs;
+          ++rhs;
+        }
+      }
+    }
+
+    if (common.size() == smaller->size()) {
+      return *smaller;
+    }
+    return FromSorted(common);
+  }
+
+  /**
+   * Returns a set containing the elements of this set that are not present in
+   * `other`.
+   *
+   * When `other` is much smaller than this set, its elements are erased one by
+   * one, which shares all untouched subtrees with this set. Otherwise the sets
+   * are merged in a single pass and the result is built in O(n + m).
+   */
+  ABSL_MUST_USE_RESULT SortedSet difference_with(
+      const SortedSet& other) const {
+    if (empty() || other.empty()) {
+      return *this;
+    }
 
-    // Make sure `result_ptr` always points to the larger one of the two sets.
-    if (result_ptr->size() < other_ptr->size()) {
-      result_ptr = other_ptr;
-      other_ptr = this;
+    if (PreferIncremental(other.size(), size())) {
+      SortedSet result = *this;
+      for (const K& key : other) {
+        if (result.contains(key)) {
+          result = result.erase(key);
+        }
+      }
+      return result;
     }
 
-    auto result = *result_ptr;
-    for (const auto& k : *other_ptr) {
-      result = result.insert(k);
+    std::vector<entry_type> remaining;
+    remaining.reserve(size());
+
+    const C& comparator = this->comparator();
+    const_iterator lhs = begin();
+    const_iterator lhs_end = end();
+    const_iterator rhs = other.begin();
+    const_iterator rhs_end = other.end();
+    while (lhs != lhs_end && rhs != rhs_end) {
+      util::ComparisonResult cmp = comparator.Compare(*lhs, *rhs);
+      if (util::Ascending(cmp)) {
+        remaining.emplace_back(*lhs, util::Empty{});
+        ++lhs;
+      } else if (util::Descending(cmp)) {
+        ++rhs;
+      } else {
+        ++lhs;
+        ++rhs;
+      }
     }
-    return result;
+    for (; lhs != lhs_end; ++lhs) {
+      remaining.emplace_back(*lhs, util::Empty{});
+    }
+
+    if (remaining.size() == size()) {
+      return *this;
+    }
+    return FromSorted(remaining);
   }
 
   ABSL_MUST_USE_RESULT SortedSet erase(const K& key) const {
@@ -153,6 +313,23 @@ class SortedSet : public SortedContainer {
   }
 
  private:
+  using entry_type = typename map_type::value_type;
+
+  /**
+   * Returns true if applying `smaller_size` individual lookups or updates to a
+   * set of `larger_size` elements is expected to be cheaper than a linear
+   * merge of both sets.
+   */
+  static bool PreferIncremental(size_type smaller_size, size_type larger_size) {
+    auto log_larger = static_cast<size_type>(util::Bits::Log2Floor(larger_size));
+    return smaller_size * (log_larger + 1) < larger_size;
+  }
+
+  SortedSet FromSorted(const std::vector<entry_type>& entries) const {
+    return SortedSet{
+        map_type::FromSortedRange(entries.begin(), entries.end(), comparator())};
+  }
+
   map_type map_;
 };
 
@@ -74,6 +74,17 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
     return TreeSortedMap{std::move(node), comparator};
   }
 
+  /**
+   * Creates a TreeSortedMap from a random access range of pairs that is
+   * already sorted by key and free of duplicates. This takes linear time.
+   */
+  template <typename RandomIt>
+  static TreeSortedMap CreateFromSorted(RandomIt first,
+                                        RandomIt last,
+                                        const C& comparator) {
+    return TreeSortedMap{node_type::FromSortedRange(first, last), comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return root_.empty();
@@ -48,6 +48,7 @@ const char* kDocumentTargetsTable = "document_target";
 const char* kRemoteDocumentsTable = "remote_document";
 const char* kCollectionParentsTable = "collection_parent";
 const char* kRemoteDocumentReadTimeTable = "remote_document_read_time";
+const char* kMigrationProgressTable = "migration_progress";
 
 /**
  * Labels for the components of keys. These serve to make keys self-describing.
@@ -107,6 +108,9 @@ enum ComponentLabel {
   /** A component containing a snapshot version. */
   SnapshotVersion = 16,
 
+  /** A component containing the schema version a migration upgrades to. */
+  SchemaVersion = 17,
+
   /**
    * A path segment describes just a single segment in a resource path. Path
    * segments that occur sequentially in a key represent successive segments in
@@ -185,6 +189,10 @@ class Reader {
     return ReadLabeledString(ComponentLabel::DocumentId);
   }
 
+  int32_t ReadSchemaVersion() {
+    return ReadLabeledInt32(ComponentLabel::SchemaVersion);
+  }
+
   /**
    * Reads a snapshot version, encoded as a component label and a pair of
    * seconds (int64) and nanoseconds (int32).
@@ -541,6 +549,12 @@ std::string Reader::Describe() {
         absl::StrAppend(&description,
                         " snapshot_version=", snapshot_version.ToString());
       }
+
+    } else if (label == ComponentLabel::SchemaVersion) {
+      int32_t schema_version = ReadSchemaVersion();
+      if (ok_) {
+        absl::StrAppend(&description, " schema_version=", schema_version);
+      }
     } else {
       absl::StrAppend(&description, " unknown label=", static_cast<int>(label));
       Fail();
@@ -596,6 +610,10 @@ class Writer {
     WriteLabeledString(ComponentLabel::DocumentId, document_id);
   }
 
+  void WriteSchemaVersion(int32_t schema_version) {
+    WriteLabeledInt32(ComponentLabel::SchemaVersion, schema_version);
+  }
+
   void WriteSnapshotVersion(model::SnapshotVersion snapshot_version) {
     WriteComponentLabel(ComponentLabel::SnapshotVersion);
     OrderedCode::WriteSignedNumIncreasing(
@@ -668,6 +686,14 @@ std::string LevelDbVersionKey::Key() {
   return writer.result();
 }
 
+std::string LevelDbMigrationProgressKey::Key(int32_t schema_version) {
+  Writer writer;
+  writer.WriteTableName(kMigrationProgressTable);
+  writer.WriteSchemaVersion(schema_version);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
 std::string LevelDbMutationKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationsTable);
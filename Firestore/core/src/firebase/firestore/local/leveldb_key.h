@@ -89,6 +89,10 @@ namespace local {
 //   - collection: ResourcePath
 //   - read_time: SnapshotVersion
 //   - document_id: string
+//
+// migration_progress:
+//   - table_name: string = "migration_progress"
+//   - schema_version: int32_t
 
 /**
  * Parses the given key and returns a human readable description of its
@@ -108,6 +112,20 @@ class LevelDbVersionKey {
   static std::string Key();
 };
 
+/**
+ * A key to a row recording how far a chunked schema migration has gotten. The
+ * row's value is the key at which the migration resumes, and the row exists
+ * only while the migration is incomplete.
+ */
+class LevelDbMigrationProgressKey {
+ public:
+  /**
+   * Returns the key pointing to the progress row of the migration to the given
+   * schema version.
+   */
+  static std::string Key(int32_t schema_version);
+};
+
 /** A key in the mutations table. */
 class LevelDbMutationKey {
  public:
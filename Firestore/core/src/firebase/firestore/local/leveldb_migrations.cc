@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <string>
 #include <utility>
 
@@ -28,6 +29,9 @@
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 #include "absl/strings/match.h"
 
 namespace firebase {
@@ -104,6 +108,7 @@ void DeleteEverythingWithPrefix(const std::string& prefix, leveldb::DB* db) {
 
 /** Migration 3. */
 void ClearQueryCache(leveldb::DB* db) {
+  TRACE_SPAN("leveldb_migrations.clear_query_cache");
   DeleteEverythingWithPrefix(LevelDbTargetKey::KeyPrefix(), db);
   DeleteEverythingWithPrefix(LevelDbDocumentTargetKey::KeyPrefix(), db);
   DeleteEverythingWithPrefix(LevelDbTargetDocumentKey::KeyPrefix(), db);
@@ -163,6 +168,7 @@ void RemoveMutationBatches(LevelDbTransaction* transaction,
 
 /** Migration 5. */
 void RemoveAcknowledgedMutations(leveldb::DB* db) {
+  TRACE_SPAN("leveldb_migrations.remove_acknowledged_mutations");
   LevelDbTransaction transaction(db, "remove acknowledged mutations");
   std::string mutation_queue_start = LevelDbMutationQueueKey::KeyPrefix();
 
@@ -201,6 +207,96 @@ model::ListenSequenceNumber GetHighestSequenceNumber(
   return target_global->highest_listen_sequence_number;
 }
 
+/**
+ * A migration that processes the rows of one or more tables in chunks, each
+ * committed in its own transaction, so that no transaction has to buffer the
+ * changes to an entire table.
+ */
+struct ChunkedMigration {
+  LevelDbMigrations::SchemaVersion version;
+  const char* label;
+
+  /** Returns the key of the first row to process. */
+  std::string (*first_key)();
+
+  /**
+   * Processes at most `max_rows` rows, starting at `start_key`. Returns the key
+   * of the next row to process, or an empty string once all rows have been
+   * processed.
+   */
+  std::string (*run_chunk)(LevelDbTransaction* transaction,
+                           const std::string& start_key,
+                           size_t max_rows);
+};
+
+/**
+ * Runs the given migration to completion and saves its version in the same
+ * transaction as its last chunk.
+ */
+void RunChunkedMigration(leveldb::DB* db, const ChunkedMigration& migration) {
+  std::string key = migration.first_key();
+  do {
+    LevelDbTransaction transaction(db, migration.label);
+    key = migration.run_chunk(&transaction, key, LevelDbMigrations::kChunkSize);
+    if (key.empty()) {
+      SaveVersion(migration.version, &transaction);
+    }
+    transaction.Commit();
+  } while (!key.empty());
+}
+
+/**
+ * Saves the version of the given migration without running it, leaving a
+ * progress row from which `RunDeferredMigrationChunk` picks it up.
+ */
+void DeferChunkedMigration(leveldb::DB* db, const ChunkedMigration& migration) {
+  LevelDbTransaction transaction(db, migration.label);
+  transaction.Put(LevelDbMigrationProgressKey::Key(migration.version),
+                  migration.first_key());
+  SaveVersion(migration.version, &transaction);
+  transaction.Commit();
+}
+
+bool IsDeferredMigrationPending(leveldb::DB* db,
+                                const ChunkedMigration& migration) {
+  LevelDbTransaction transaction(db, "Read migration progress");
+  std::string unused_value;
+  Status status = transaction.Get(
+      LevelDbMigrationProgressKey::Key(migration.version), &unused_value);
+  HARD_ASSERT(status.ok() || status.IsNotFound(),
+              "Failed to read migration progress from LevelDB, error: '%s'",
+              status.ToString());
+  return status.ok();
+}
+
+/**
+ * Runs the next chunk of the given deferred migration, which must be pending,
+ * and records how far it has gotten.
+ */
+void RunDeferredMigrationChunk(leveldb::DB* db,
+                               const ChunkedMigration& migration,
+                               size_t max_rows) {
+  LevelDbTransaction transaction(db, migration.label);
+  std::string progress_key =
+      LevelDbMigrationProgressKey::Key(migration.version);
+  std::string start_key;
+  Status status = transaction.Get(progress_key, &start_key);
+  HARD_ASSERT(status.ok(),
+              "Failed to read migration progress from LevelDB, error: '%s'",
+              status.ToString());
+
+  std::string next_key =
+      migration.run_chunk(&transaction, start_key, max_rows);
+  if (next_key.empty()) {
+    transaction.Delete(progress_key);
+    LOG_DEBUG("Completed deferred migration to schema version %s",
+              migration.version);
+  } else {
+    transaction.Put(progress_key, next_key);
+  }
+  transaction.Commit();
+}
+
 /**
  * Given a document key, ensure it has a sentinel row. If it doesn't have one,
  * add it with the given value.
@@ -215,36 +311,54 @@ void EnsureSentinelRow(LevelDbTransaction* transaction,
   }
 }
 
+std::string FirstRemoteDocumentKey() {
+  return LevelDbRemoteDocumentKey::KeyPrefix();
+}
+
 /**
  * Migration 4.
  *
  * Ensure each document in the remote document table has a corresponding
  * sentinel row in the document target index.
+ *
+ * Deferred: until a document has a sentinel row, LRU garbage collection just
+ * doesn't consider it for removal.
  */
-void EnsureSentinelRows(leveldb::DB* db) {
-  LevelDbTransaction transaction(db, "Ensure sentinel rows");
-
-  // Get the value we'll use for anything that's missing a row.
+std::string EnsureSentinelRows(LevelDbTransaction* transaction,
+                               const std::string& start_key,
+                               size_t max_rows) {
+  TRACE_SPAN("leveldb_migrations.ensure_sentinel_rows");
+
+  // Get the value we'll use for anything that's missing a row. Sequence
+  // numbers only increase, so documents covered by later chunks can only
+  // appear more recently used than they would have been at upgrade time.
   model::ListenSequenceNumber sequence_number =
-      GetHighestSequenceNumber(&transaction);
+      GetHighestSequenceNumber(transaction);
   std::string sentinel_value =
       LevelDbDocumentTargetKey::EncodeSentinelValue(sequence_number);
 
   std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
-  auto it = transaction.NewIterator();
-  it->Seek(documents_prefix);
+  auto it = transaction->NewIterator();
+  it->Seek(start_key);
   LevelDbRemoteDocumentKey document_key;
-  for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
-       it->Next()) {
+  for (size_t rows = 0;
+       it->Valid() && absl::StartsWith(it->key(), documents_prefix);
+       it->Next(), ++rows) {
+    if (rows == max_rows) {
+      return it->key();
+    }
     HARD_ASSERT(document_key.Decode(it->key()),
                 "Failed to decode document key");
-    EnsureSentinelRow(&transaction, document_key.document_key(),
+    EnsureSentinelRow(transaction, document_key.document_key(),
                       sentinel_value);
   }
-  SaveVersion(4, &transaction);
-  transaction.Commit();
+  return {};
 }
 
+const ChunkedMigration kEnsureSentinelRows{4, "Ensure sentinel rows",
+                                           FirstRemoteDocumentKey,
+                                           EnsureSentinelRows};
+
 // Helper to add an index entry iff we haven't already written it (as determined
 // by the provided cache).
 void EnsureCollectionParentRow(LevelDbTransaction* transaction,
@@ -267,43 +381,65 @@ void EnsureCollectionParentRow(LevelDbTransaction* transaction,
  *
  * Creates appropriate LevelDbCollectionParentKey rows for all collections
  * of documents in the remote document cache and mutation queue.
+ *
+ * Not deferred, since collection group queries rely on the index to find the
+ * collections to query.
  */
-void EnsureCollectionParentsIndex(leveldb::DB* db) {
-  LevelDbTransaction transaction(db, "Ensure Collection Parents Index");
+std::string EnsureCollectionParentsIndex(LevelDbTransaction* transaction,
+                                         const std::string& start_key,
+                                         size_t max_rows) {
+  TRACE_SPAN("leveldb_migrations.ensure_collection_parents_index");
 
+  // Entries are only cached within a chunk, so rows may be rewritten by later
+  // chunks, which is harmless.
   MemoryCollectionParentIndex cache;
+  size_t rows = 0;
 
   // Index existing remote documents.
   std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
-  auto it = transaction.NewIterator();
-  it->Seek(documents_prefix);
-  LevelDbRemoteDocumentKey document_key;
-  for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
-       it->Next()) {
-    HARD_ASSERT(document_key.Decode(it->key()),
-                "Failed to decode document key");
+  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
+  auto it = transaction->NewIterator();
+  if (absl::StartsWith(start_key, documents_prefix)) {
+    it->Seek(start_key);
+    LevelDbRemoteDocumentKey document_key;
+    for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
+         it->Next(), ++rows) {
+      if (rows == max_rows) {
+        return it->key();
+      }
+      HARD_ASSERT(document_key.Decode(it->key()),
+                  "Failed to decode document key");
 
-    EnsureCollectionParentRow(&transaction, &cache,
-                              document_key.document_key());
+      EnsureCollectionParentRow(transaction, &cache,
+                                document_key.document_key());
+    }
+    it->Seek(mutations_prefix);
+  } else {
+    it->Seek(start_key);
   }
 
   // Index existing mutations.
-  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
-  it = transaction.NewIterator();
-  it->Seek(mutations_prefix);
   LevelDbDocumentMutationKey key;
   for (; it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
-       it->Next()) {
+       it->Next(), ++rows) {
+    if (rows == max_rows) {
+      return it->key();
+    }
     HARD_ASSERT(key.Decode(it->key()),
                 "Failed to decode document-mutation key");
 
-    EnsureCollectionParentRow(&transaction, &cache, key.document_key());
+    EnsureCollectionParentRow(transaction, &cache, key.document_key());
   }
-
-  SaveVersion(6, &transaction);
-  transaction.Commit();
+  return {};
 }
 
+const ChunkedMigration kEnsureCollectionParentsIndex{
+    6, "Ensure Collection Parents Index", FirstRemoteDocumentKey,
+    EnsureCollectionParentsIndex};
+
+/** Migrations run in chunks by `RunDeferredMigrations`, in order. */
+const ChunkedMigration* const kDeferredMigrations[] = {&kEnsureSentinelRows};
+
 }  // namespace
 
 LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
@@ -322,12 +458,25 @@ LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
   }
 }
 
+constexpr size_t LevelDbMigrations::kChunkSize;
+
 void LevelDbMigrations::RunMigrations(leveldb::DB* db) {
   RunMigrations(db, kSchemaVersion);
 }
 
 void LevelDbMigrations::RunMigrations(leveldb::DB* db,
                                       SchemaVersion to_version) {
+  RunBlockingMigrations(db, to_version);
+  while (RunDeferredMigrations(db)) {
+  }
+}
+
+void LevelDbMigrations::RunBlockingMigrations(leveldb::DB* db) {
+  RunBlockingMigrations(db, kSchemaVersion);
+}
+
+void LevelDbMigrations::RunBlockingMigrations(leveldb::DB* db,
+                                              SchemaVersion to_version) {
   SchemaVersion from_version = ReadSchemaVersion(db);
   // If this is a downgrade, just save the downgrade version so we can
   // detect it when we go to upgrade again, allowing us to rerun the
@@ -335,9 +484,19 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   if (from_version > to_version) {
     LevelDbTransaction transaction(db, "Save downgrade version");
     SaveVersion(to_version, &transaction);
+    // Any deferred migrations past the downgrade version will start over.
+    for (const ChunkedMigration* migration : kDeferredMigrations) {
+      if (migration->version > to_version) {
+        transaction.Delete(
+            LevelDbMigrationProgressKey::Key(migration->version));
+      }
+    }
     transaction.Commit();
     return;
   }
+  if (from_version == to_version) return;
+
+  auto start = std::chrono::steady_clock::now();
 
   // This must run unconditionally because schema migrations were added to iOS
   // after the first release. There may be clients that have never run any
@@ -347,7 +506,7 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   }
 
   if (from_version < 4 && to_version >= 4) {
-    EnsureSentinelRows(db);
+    DeferChunkedMigration(db, kEnsureSentinelRows);
   }
 
   if (from_version < 5 && to_version >= 5) {
@@ -355,8 +514,31 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   }
 
   if (from_version < 6 && to_version >= 6) {
-    EnsureCollectionParentsIndex(db);
+    RunChunkedMigration(db, kEnsureCollectionParentsIndex);
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  LOG_DEBUG("Migrated LevelDB schema from version %s to %s in %s ms",
+            from_version, to_version, elapsed.count());
+}
+
+bool LevelDbMigrations::HasDeferredMigrations(leveldb::DB* db) {
+  for (const ChunkedMigration* migration : kDeferredMigrations) {
+    if (IsDeferredMigrationPending(db, *migration)) return true;
+  }
+  return false;
+}
+
+bool LevelDbMigrations::RunDeferredMigrations(leveldb::DB* db,
+                                              size_t max_rows) {
+  for (const ChunkedMigration* migration : kDeferredMigrations) {
+    if (IsDeferredMigrationPending(db, *migration)) {
+      RunDeferredMigrationChunk(db, *migration, max_rows);
+      return HasDeferredMigrations(db);
+    }
   }
+  return false;
 }
 
 }  // namespace local
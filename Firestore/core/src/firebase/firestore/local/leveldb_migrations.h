@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_MIGRATIONS_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_MIGRATIONS_H_
 
+#include <cstddef>
 #include <cstdint>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
@@ -27,10 +28,24 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+/**
+ * Upgrades the schema of a LevelDB database to the current version.
+ *
+ * Most migrations run to completion before the database is used. Backfills
+ * that the client can safely run without, such as adding sentinel rows for
+ * LRU garbage collection, are instead deferred: opening the database only
+ * records that they're pending, and `RunDeferredMigrations` later completes
+ * them in chunks of bounded size, each in its own transaction. A progress row
+ * records how far each chunked migration has gotten, so that a deferred
+ * backfill interrupted by the app exiting resumes where it left off.
+ */
 class LevelDbMigrations {
  public:
   using SchemaVersion = int32_t;
 
+  /** The number of rows a chunked migration processes per transaction. */
+  static constexpr size_t kChunkSize = 1000;
+
   /**
    * Returns the current version of the schema for the given database
    */
@@ -38,15 +53,41 @@ class LevelDbMigrations {
 
   /**
    * Runs any migrations needed to bring the given database up to the current
-   * schema version
+   * schema version, including any deferred backfills
    */
   static void RunMigrations(leveldb::DB* db);
 
   /**
    * Runs any migrations needed to bring the given database up to the given
-   * schema version
+   * schema version, including any deferred backfills
    */
   static void RunMigrations(leveldb::DB* db, SchemaVersion version);
+
+  /**
+   * Runs the migrations needed before the given database can be used at the
+   * current schema version, leaving backfills that can safely run later to
+   * `RunDeferredMigrations`.
+   */
+  static void RunBlockingMigrations(leveldb::DB* db);
+
+  /**
+   * Runs the migrations needed before the given database can be used at the
+   * given schema version, leaving backfills that can safely run later to
+   * `RunDeferredMigrations`.
+   */
+  static void RunBlockingMigrations(leveldb::DB* db, SchemaVersion version);
+
+  /** Returns true if any deferred backfills have yet to complete. */
+  static bool HasDeferredMigrations(leveldb::DB* db);
+
+  /**
+   * Runs a single chunk of the pending deferred backfills, processing at most
+   * `max_rows` rows in one transaction.
+   *
+   * @return true if deferred backfills remain to be run.
+   */
+  static bool RunDeferredMigrations(leveldb::DB* db,
+                                    size_t max_rows = kChunkSize);
 };
 
 }  // namespace local
@@ -133,7 +133,6 @@ LevelDbMutationQueue::LevelDbMutationQueue(const User& user,
 }
 
 void LevelDbMutationQueue::Start() {
-  next_batch_id_ = LoadNextBatchIdFromDb(db_->ptr());
   metadata_ = MetadataForKey(mutation_queue_key());
 }
 
@@ -159,6 +158,9 @@ MutationBatch LevelDbMutationQueue::AddMutationBatch(
     const Timestamp& local_write_time,
     std::vector<Mutation>&& base_mutations,
     std::vector<Mutation>&& mutations) {
+  if (next_batch_id_ == kBatchIdUnknown) {
+    next_batch_id_ = LoadNextBatchIdFromDb(db_->ptr());
+  }
   BatchId batch_id = next_batch_id_;
   next_batch_id_++;
 
@@ -24,6 +24,7 @@
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
 #include "absl/strings/string_view.h"
@@ -130,8 +131,11 @@ class LevelDbMutationQueue : public MutationQueue {
    * NOTE: There can only be one LevelDbMutationQueue for a given db at a time,
    * hence it is safe to track next_batch_id_ as an instance-level property.
    * Should we ever relax this constraint we'll need to revisit this.
+   *
+   * Finding it means seeking through every user's mutations, so it's loaded
+   * when the first batch is added rather than when the queue starts.
    */
-  model::BatchId next_batch_id_;
+  model::BatchId next_batch_id_ = model::kBatchIdUnknown;
 
   /**
    * A write-through cache copy of the metadata describing the current queue.
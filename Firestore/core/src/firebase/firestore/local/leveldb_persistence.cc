@@ -89,27 +89,23 @@ util::StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
   if (!created.ok()) return created.status();
 
   std::unique_ptr<DB> db = std::move(created).ValueOrDie();
-  LevelDbMigrations::RunMigrations(db.get());
-
-  LevelDbTransaction transaction(db.get(), "Start LevelDB");
-  std::set<std::string> users = CollectUserSet(&transaction);
-  transaction.Commit();
+  // Backfills that the client can do without are deferred to
+  // `RunDeferredMigrations` so that they don't delay startup.
+  LevelDbMigrations::RunBlockingMigrations(db.get());
 
   // Explicit conversion is required to allow the StatusOr to be created.
   std::unique_ptr<LevelDbPersistence> result(
-      new LevelDbPersistence(std::move(db), std::move(dir), std::move(users),
+      new LevelDbPersistence(std::move(db), std::move(dir),
                              std::move(serializer), lru_params));
   return {std::move(result)};
 }
 
 LevelDbPersistence::LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
                                        util::Path directory,
-                                       std::set<std::string> users,
                                        LocalSerializer serializer,
                                        const LruParams& lru_params)
     : db_(std::move(db)),
       directory_(std::move(directory)),
-      users_(std::move(users)),
       serializer_(std::move(serializer)) {
   target_cache_ = absl::make_unique<LevelDbTargetCache>(this, &serializer_);
   document_cache_ =
@@ -194,6 +190,23 @@ int64_t LevelDbPersistence::CalculateByteSize() {
   return count;
 }
 
+const std::set<std::string>& LevelDbPersistence::users() {
+  if (!users_) {
+    users_ = CollectUserSet(current_transaction());
+  }
+  return *users_;
+}
+
+bool LevelDbPersistence::HasDeferredMigrations() {
+  return LevelDbMigrations::HasDeferredMigrations(db_.get());
+}
+
+bool LevelDbPersistence::RunDeferredMigrations() {
+  HARD_ASSERT(!transaction_,
+              "Deferred migrations cannot run within a transaction");
+  return LevelDbMigrations::RunDeferredMigrations(db_.get());
+}
+
 // MARK: - Persistence
 
 model::ListenSequenceNumber LevelDbPersistence::current_sequence_number()
@@ -209,7 +222,9 @@ void LevelDbPersistence::Shutdown() {
 
 LevelDbMutationQueue* LevelDbPersistence::GetMutationQueueForUser(
     const auth::User& user) {
-  users_.insert(user.uid());
+  if (users_) {
+    users_->insert(user.uid());
+  }
   current_mutation_queue_ =
       absl::make_unique<LevelDbMutationQueue>(user, this, &serializer_);
   return current_mutation_queue_.get();
@@ -32,6 +32,7 @@
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -63,14 +64,31 @@ class LevelDbPersistence : public Persistence {
     return db_.get();
   }
 
-  const std::set<std::string> users() const {
-    return users_;
-  }
+  /**
+   * Returns the IDs of all users with pending mutations. Only garbage
+   * collection needs them, so they're collected on first use rather than at
+   * startup. Must be called within a transaction.
+   */
+  const std::set<std::string>& users();
 
   static util::Status ClearPersistence(const core::DatabaseInfo& database_info);
 
   int64_t CalculateByteSize();
 
+  /**
+   * Returns true if schema migrations deferred when the database was opened
+   * have yet to complete.
+   */
+  bool HasDeferredMigrations();
+
+  /**
+   * Runs a bounded chunk of the deferred schema migrations. Must not be called
+   * within a transaction.
+   *
+   * @return true if deferred migrations remain to be run.
+   */
+  bool RunDeferredMigrations();
+
   // MARK: Persistence overrides
 
   model::ListenSequenceNumber current_sequence_number() const override;
@@ -95,7 +113,6 @@ class LevelDbPersistence : public Persistence {
  private:
   LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
                      util::Path directory,
-                     std::set<std::string> users,
                      LocalSerializer serializer,
                      const LruParams& lru_params);
 
@@ -111,7 +128,7 @@ class LevelDbPersistence : public Persistence {
   std::unique_ptr<leveldb::DB> db_;
 
   util::Path directory_;
-  std::set<std::string> users_;
+  absl::optional<std::set<std::string>> users_;
   LocalSerializer serializer_;
   bool started_ = false;
 
@@ -19,6 +19,7 @@
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 
@@ -30,10 +31,10 @@
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
-#include "Firestore/core/src/firebase/firestore/util/background_queue.h"
-#include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/string_util.h"
+#include "Firestore/core/src/firebase/firestore/util/work_stealing_pool.h"
+#include "absl/memory/memory.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -55,40 +56,7 @@ using model::SnapshotVersion;
 using nanopb::ByteString;
 using nanopb::Message;
 using nanopb::StringReader;
-using util::BackgroundQueue;
-using util::Executor;
-
-/**
- * An accumulator for results produced asynchronously. This accumulates
- * values in a vector to avoid contention caused by accumulating into more
- * complex structures like immutable::SortedMap.
- */
-template <typename T>
-class AsyncResults {
- public:
-  void Insert(T&& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    values_.push_back(std::move(value));
-  }
-
-  void Insert(const T& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    values_.push_back(value);
-  }
-
-  /**
-   * Returns the accumulated result, moving it out of AsyncResults. The
-   * AsyncResults object should not be reused.
-   */
-  std::vector<T> Result() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return std::move(values_);
-  }
-
- private:
-  std::vector<T> values_;
-  std::mutex mutex_;
-};
+using util::WorkStealingPool;
 
 }  // namespace
 
@@ -100,8 +68,8 @@ LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
     // If the standard library doesn't know, guess something reasonable.
     hw_concurrency = 4;
   }
-  executor_ = Executor::CreateConcurrent("com.google.firebase.firestore.query",
-                                         static_cast<int>(hw_concurrency));
+  pool_ = absl::make_unique<WorkStealingPool>(
+      "com.google.firebase.firestore.query", static_cast<int>(hw_concurrency));
 }
 
 // Out of line because of unique_ptrs to incomplete types.
@@ -146,32 +114,32 @@ absl::optional<MaybeDocument> LevelDbRemoteDocumentCache::Get(
 
 OptionalMaybeDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) {
-  BackgroundQueue tasks(executor_.get());
-  AsyncResults<std::pair<DocumentKey, absl::optional<MaybeDocument>>> results;
+  // Entries are produced in key order, with those found in the cache decoded
+  // in parallel into their own slot afterwards.
+  std::vector<std::pair<DocumentKey, absl::optional<MaybeDocument>>> results;
+  std::vector<size_t> found;
+  std::vector<std::string> contents;
 
   LevelDbRemoteDocumentKey current_key;
   auto it = db_->current_transaction()->NewIterator();
 
   for (const DocumentKey& key : keys) {
     it->Seek(LevelDbRemoteDocumentKey::Key(key));
-    if (!it->Valid() || !current_key.Decode(it->key()) ||
-        current_key.document_key() != key) {
-      results.Insert(std::make_pair(key, absl::nullopt));
-    } else {
-      const std::string& contents = it->value();
-      tasks.Execute([this, &results, &key, contents] {
-        results.Insert(std::make_pair(key, DecodeMaybeDocument(contents, key)));
-      });
+    if (it->Valid() && current_key.Decode(it->key()) &&
+        current_key.document_key() == key) {
+      found.push_back(results.size());
+      contents.push_back(it->value());
     }
+    results.emplace_back(key, absl::nullopt);
   }
 
-  tasks.AwaitAll();
+  pool_->ParallelFor(found.size(), [&](size_t i) {
+    auto& entry = results[found[i]];
+    entry.second = DecodeMaybeDocument(contents[i], entry.first);
+  });
 
-  OptionalMaybeDocumentMap map;
-  for (const auto& entry : results.Result()) {
-    map = map.insert(entry.first, entry.second);
-  }
-  return map;
+  return OptionalMaybeDocumentMap::FromSortedRange(results.begin(),
+                                                   results.end());
 }
 
 DocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
@@ -228,8 +196,8 @@ DocumentMap LevelDbRemoteDocumentCache::GetMatching(
 
     return LevelDbRemoteDocumentCache::GetAllExisting(remote_keys);
   } else {
-    BackgroundQueue tasks(executor_.get());
-    AsyncResults<Document> results;
+    std::vector<DocumentKey> document_keys;
+    std::vector<std::string> contents;
 
     // Documents are ordered by key, so we can use a prefix scan to narrow down
     // the documents we need to match the query against.
@@ -253,20 +221,20 @@ DocumentMap LevelDbRemoteDocumentCache::GetMatching(
         break;
       }
 
-      const std::string& contents = it->value();
-      tasks.Execute([this, &results, document_key, contents] {
-        MaybeDocument maybe_doc = DecodeMaybeDocument(contents, document_key);
-        if (maybe_doc.is_document()) {
-          results.Insert(Document(maybe_doc));
-        }
-      });
+      document_keys.push_back(document_key);
+      contents.push_back(it->value());
     }
 
-    tasks.AwaitAll();
+    std::vector<MaybeDocument> decoded =
+        pool_->ParallelMap<MaybeDocument>(document_keys.size(), [&](size_t i) {
+          return DecodeMaybeDocument(contents[i], document_keys[i]);
+        });
 
     DocumentMap map;
-    for (const Document& doc : results.Result()) {
-      map = map.insert(doc.key(), doc);
+    for (const MaybeDocument& maybe_doc : decoded) {
+      if (maybe_doc.is_document()) {
+        map = map.insert(maybe_doc.key(), Document(maybe_doc));
+      }
     }
     return map;
   }
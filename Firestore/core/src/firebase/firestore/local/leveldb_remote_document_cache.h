@@ -30,7 +30,7 @@ namespace firebase {
 namespace firestore {
 
 namespace util {
-class Executor;
+class WorkStealingPool;
 }  // namespace util
 
 namespace local {
@@ -72,7 +72,7 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
   // Owned by LevelDbPersistence.
   LocalSerializer* serializer_ = nullptr;
 
-  std::unique_ptr<util::Executor> executor_;
+  std::unique_ptr<util::WorkStealingPool> pool_;
 };
 
 }  // namespace local
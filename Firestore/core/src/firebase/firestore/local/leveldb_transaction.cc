@@ -19,6 +19,7 @@
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "leveldb/write_batch.h"
@@ -193,6 +194,7 @@ void LevelDbTransaction::Delete(absl::string_view key) {
 }
 
 void LevelDbTransaction::Commit() {
+  TRACE_SPAN("leveldb_transaction.commit");
   WriteBatch batch;
   for (const auto& deletion : deletions_) {
     batch.Delete(deletion);
@@ -202,6 +204,12 @@ void LevelDbTransaction::Commit() {
     batch.Put(entry.first, entry.second);
   }
 
+  METRICS_HISTOGRAM_RECORD(
+      "leveldb_transaction.commit.changes",
+      static_cast<int64_t>(deletions_.size() + mutations_.size()));
+  METRICS_HISTOGRAM_RECORD("leveldb_transaction.commit.bytes",
+                           static_cast<int64_t>(batch.ApproximateSize()));
+
   LOG_DEBUG("Committing transaction: %s", ToString());
 
   Status status = db_->Write(write_options_, &batch);
@@ -18,6 +18,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
@@ -37,6 +38,7 @@ namespace firestore {
 namespace local {
 
 using core::Query;
+using model::BatchId;
 using model::Document;
 using model::DocumentKey;
 using model::DocumentKeySet;
@@ -59,12 +61,78 @@ absl::optional<MaybeDocument> LocalDocumentsView::GetDocument(
 
 absl::optional<MaybeDocument> LocalDocumentsView::GetDocument(
     const DocumentKey& key, const std::vector<MutationBatch>& batches) {
-  absl::optional<MaybeDocument> document = remote_document_cache_->Get(key);
+  return ApplyOverlay(key, remote_document_cache_->Get(key), batches);
+}
+
+namespace {
+
+/**
+ * The maximum number of local views to cache. Entries are normally discarded
+ * as soon as their batches are acknowledged or rejected, so this only bounds
+ * memory while a very large number of writes are pending.
+ */
+const size_t kMaxCachedOverlays = 1000;
+
+bool AffectsKey(const MutationBatch& batch, const DocumentKey& key) {
+  for (const Mutation& mutation : batch.mutations()) {
+    if (mutation.key() == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+absl::optional<MaybeDocument> LocalDocumentsView::ApplyOverlay(
+    const DocumentKey& key,
+    const absl::optional<MaybeDocument>& base_doc,
+    const std::vector<MutationBatch>& batches) {
+  std::vector<BatchId> batch_ids;
   for (const MutationBatch& batch : batches) {
-    document = batch.ApplyToLocalDocument(document, key);
+    if (AffectsKey(batch, key)) {
+      batch_ids.push_back(batch.batch_id());
+    }
+  }
+  if (batch_ids.empty()) {
+    return base_doc;
+  }
+
+  BaseVersion base_version{base_doc};
+  auto found = overlays_.find(key);
+  if (found != overlays_.end()) {
+    const Overlay& overlay = found->second;
+    if (overlay.batch_ids == batch_ids &&
+        overlay.base_version == base_version) {
+      return overlay.local_view;
+    }
   }
 
-  return document;
+  absl::optional<MaybeDocument> local_view = base_doc;
+  for (const MutationBatch& batch : batches) {
+    local_view = batch.ApplyToLocalDocument(std::move(local_view), key);
+  }
+
+  Overlay overlay{base_version, std::move(batch_ids), local_view};
+  if (found != overlays_.end()) {
+    found->second = std::move(overlay);
+  } else {
+    if (overlays_.size() >= kMaxCachedOverlays) {
+      // Evict a single arbitrary entry rather than dropping the whole cache,
+      // so that a long run of pending writes keeps most of its views.
+      overlays_.erase(overlays_.begin());
+    }
+    overlays_.emplace(key, std::move(overlay));
+  }
+  return local_view;
+}
+
+void LocalDocumentsView::InvalidateOverlays(const DocumentKeySet& keys) {
+  if (overlays_.empty()) return;
+
+  for (const DocumentKey& key : keys) {
+    overlays_.erase(key);
+  }
 }
 
 OptionalMaybeDocumentMap LocalDocumentsView::ApplyLocalMutationsToDocuments(
@@ -74,11 +142,7 @@ OptionalMaybeDocumentMap LocalDocumentsView::ApplyLocalMutationsToDocuments(
 
   for (const auto& kv : docs) {
     const DocumentKey& key = kv.first;
-    absl::optional<MaybeDocument> local_view = kv.second;
-    for (const MutationBatch& batch : batches) {
-      local_view = batch.ApplyToLocalDocument(local_view, key);
-    }
-    results = results.insert(key, local_view);
+    results = results.insert(key, ApplyOverlay(key, kv.second, batches));
   }
   return results;
 }
@@ -198,20 +262,24 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
     }
   }
 
-  // Finally, filter out any documents that don't actually match the query. Note
-  // that the extra reference here prevents DocumentMap's destructor from
-  // deallocating the initial unfiltered results while we're iterating over
-  // them.
-  DocumentMap unfiltered = results;
-  for (const auto& kv : unfiltered.underlying_map()) {
-    const DocumentKey& key = kv.first;
-    Document doc(kv.second);
-    if (!query.Matches(doc)) {
-      results = results.erase(key);
+  // Finally, filter out any documents that don't actually match the query.
+  // The documents are visited in key order, so the matches can be built into
+  // a map directly.
+  std::vector<Document> docs;
+  docs.reserve(results.size());
+  for (const auto& kv : results.underlying_map()) {
+    docs.push_back(Document(kv.second));
+  }
+
+  std::vector<bool> matches = query.MatchesBatch(docs);
+  std::vector<std::pair<DocumentKey, Document>> matching;
+  for (size_t i = 0; i < docs.size(); ++i) {
+    if (matches[i]) {
+      matching.emplace_back(docs[i].key(), std::move(docs[i]));
     }
   }
 
-  return results;
+  return DocumentMap::FromSortedRange(matching.begin(), matching.end());
 }
 
 DocumentMap LocalDocumentsView::AddMissingBaseDocuments(
@@ -17,12 +17,17 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LOCAL_DOCUMENTS_VIEW_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LOCAL_DOCUMENTS_VIEW_H_
 
+#include <unordered_map>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
 
 namespace firebase {
 namespace firestore {
@@ -86,6 +91,13 @@ class LocalDocumentsView {
   virtual model::DocumentMap GetDocumentsMatchingQuery(
       const core::Query& query, const model::SnapshotVersion& since_read_time);
 
+  /**
+   * Discards any cached local views of the given documents. Must be called
+   * whenever a mutation batch affecting any of `keys` is added to or removed
+   * from the mutation queue.
+   */
+  void InvalidateOverlays(const model::DocumentKeySet& keys);
+
  private:
   friend class CountingQueryEngine;  // For testing
 
@@ -94,6 +106,22 @@ class LocalDocumentsView {
       const model::DocumentKey& key,
       const std::vector<model::MutationBatch>& batches);
 
+  /**
+   * Returns the view of the document identified by `key` after applying the
+   * mutations in `batches` to `base_doc`. Batches that don't affect `key` are
+   * skipped.
+   *
+   * Results are cached per document so that documents with pending writes
+   * that are read repeatedly share a single local view. A cached result is
+   * reused only while both the version of the base document and the set of
+   * affecting batches are unchanged; the base document itself is not
+   * compared, since persistent caches decode a new copy on every read.
+   */
+  absl::optional<model::MaybeDocument> ApplyOverlay(
+      const model::DocumentKey& key,
+      const absl::optional<model::MaybeDocument>& base_doc,
+      const std::vector<model::MutationBatch>& batches);
+
   /**
    * Returns the view of the given `docs` as they would appear after applying
    * all mutations in the given `batches`.
@@ -139,9 +167,41 @@ class LocalDocumentsView {
   }
 
  private:
+  /**
+   * Identifies a version of a remote document. The remote document cache
+   * holds at most one state of a document per version, so two base documents
+   * with the same `BaseVersion` have the same contents.
+   */
+  struct BaseVersion {
+    explicit BaseVersion(const absl::optional<model::MaybeDocument>& doc)
+        : type(doc ? doc->type() : model::MaybeDocument::Type::Invalid),
+          version(doc ? doc->version() : model::SnapshotVersion::None()),
+          has_pending_writes(doc && doc->has_pending_writes()) {
+    }
+
+    bool operator==(const BaseVersion& other) const {
+      return type == other.type && version == other.version &&
+             has_pending_writes == other.has_pending_writes;
+    }
+
+    model::MaybeDocument::Type type;
+    model::SnapshotVersion version;
+    bool has_pending_writes;
+  };
+
+  /** The cached local view of a single document. */
+  struct Overlay {
+    BaseVersion base_version;
+    std::vector<model::BatchId> batch_ids;
+    absl::optional<model::MaybeDocument> local_view;
+  };
+
   RemoteDocumentCache* remote_document_cache_;
   MutationQueue* mutation_queue_;
   IndexManager* index_manager_;
+
+  std::unordered_map<model::DocumentKey, Overlay, model::DocumentKeyHash>
+      overlays_;
 };
 
 }  // namespace local
@@ -16,8 +16,11 @@
 
 #include "Firestore/core/src/firebase/firestore/local/local_store.h"
 
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 #include "Firestore/core/src/firebase/firestore/local/local_view_changes.h"
 #include "Firestore/core/src/firebase/firestore/local/local_write_result.h"
@@ -27,12 +30,14 @@
 #include "Firestore/core/src/firebase/firestore/local/query_result.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_delegate.h"
 #include "Firestore/core/src/firebase/firestore/local/target_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch_result.h"
 #include "Firestore/core/src/firebase/firestore/model/patch_mutation.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/to_string.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 
 namespace firebase {
 namespace firestore {
@@ -45,6 +50,7 @@ using core::Query;
 using core::Target;
 using core::TargetIdGenerator;
 using model::BatchId;
+using model::Document;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
@@ -105,6 +111,7 @@ void LocalStore::StartMutationQueue() {
 }
 
 MaybeDocumentMap LocalStore::HandleUserChange(const User& user) {
+  TRACE_SPAN("local_store.handle_user_change");
   // Swap out the mutation queue, grabbing the pending mutation batches before
   // and after.
   std::vector<MutationBatch> old_batches = persistence_->Run(
@@ -143,6 +150,7 @@ MaybeDocumentMap LocalStore::HandleUserChange(const User& user) {
 }
 
 LocalWriteResult LocalStore::WriteLocally(std::vector<Mutation>&& mutations) {
+  TRACE_SPAN("local_store.write_locally");
   Timestamp local_write_time = Timestamp::Now();
   DocumentKeySet keys;
   for (const Mutation& mutation : mutations) {
@@ -177,6 +185,7 @@ LocalWriteResult LocalStore::WriteLocally(std::vector<Mutation>&& mutations) {
 
     MutationBatch batch = mutation_queue_->AddMutationBatch(
         local_write_time, std::move(base_mutations), std::move(mutations));
+    local_documents_->InvalidateOverlays(keys);
     MaybeDocumentMap changed_documents =
         batch.ApplyToLocalDocumentSet(existing_documents);
     return LocalWriteResult{batch.batch_id(), std::move(changed_documents)};
@@ -185,6 +194,7 @@ LocalWriteResult LocalStore::WriteLocally(std::vector<Mutation>&& mutations) {
 
 MaybeDocumentMap LocalStore::AcknowledgeBatch(
     const MutationBatchResult& batch_result) {
+  TRACE_SPAN("local_store.acknowledge_batch");
   return persistence_->Run("Acknowledge batch", [&] {
     const MutationBatch& batch = batch_result.batch();
     mutation_queue_->AcknowledgeBatch(batch, batch_result.stream_token());
@@ -224,15 +234,18 @@ void LocalStore::ApplyBatchResult(const MutationBatchResult& batch_result) {
   }
 
   mutation_queue_->RemoveMutationBatch(batch);
+  local_documents_->InvalidateOverlays(doc_keys);
 }
 
 MaybeDocumentMap LocalStore::RejectBatch(BatchId batch_id) {
+  TRACE_SPAN("local_store.reject_batch");
   return persistence_->Run("Reject batch", [&] {
     absl::optional<MutationBatch> to_reject =
         mutation_queue_->LookupMutationBatch(batch_id);
     HARD_ASSERT(to_reject.has_value(), "Attempt to reject nonexistent batch!");
 
     mutation_queue_->RemoveMutationBatch(*to_reject);
+    local_documents_->InvalidateOverlays(to_reject->keys());
     mutation_queue_->PerformConsistencyCheck();
 
     return local_documents_->GetDocuments(to_reject->keys());
@@ -254,6 +267,7 @@ const SnapshotVersion& LocalStore::GetLastRemoteSnapshotVersion() const {
 
 model::MaybeDocumentMap LocalStore::ApplyRemoteEvent(
     const remote::RemoteEvent& remote_event) {
+  TRACE_SPAN("local_store.apply_remote_event");
   const SnapshotVersion& last_remote_version =
       target_cache_->GetLastRemoteSnapshotVersion();
 
@@ -410,6 +424,7 @@ absl::optional<TargetData> LocalStore::GetTargetData(
 
 void LocalStore::NotifyLocalViewChanges(
     const std::vector<local::LocalViewChanges>& view_changes) {
+  TRACE_SPAN("local_store.notify_local_view_changes");
   persistence_->Run("NotifyLocalViewChanges", [&] {
     for (const LocalViewChanges& view_change : view_changes) {
       int target_id = view_change.target_id();
@@ -449,6 +464,7 @@ absl::optional<MutationBatch> LocalStore::GetNextMutationBatch(
 }
 
 absl::optional<MaybeDocument> LocalStore::ReadDocument(const DocumentKey& key) {
+  TRACE_SPAN("local_store.read_document");
   return persistence_->Run("ReadDocument",
                            [&] { return local_documents_->GetDocument(key); });
 }
@@ -460,6 +476,7 @@ BatchId LocalStore::GetHighestUnacknowledgedBatchId() {
 }
 
 TargetData LocalStore::AllocateTarget(Target target) {
+  TRACE_SPAN("local_store.allocate_target");
   TargetData target_data = persistence_->Run("Allocate target", [&] {
     absl::optional<TargetData> cached = target_cache_->GetTarget(target);
     // TODO(mcg): freshen last accessed date if cached exists?
@@ -484,6 +501,7 @@ TargetData LocalStore::AllocateTarget(Target target) {
 }
 
 void LocalStore::ReleaseTarget(TargetId target_id) {
+  TRACE_SPAN("local_store.release_target");
   persistence_->Run("Release target", [&] {
     auto found = target_data_by_target_.find(target_id);
     HARD_ASSERT(found != target_data_by_target_.end(),
@@ -510,23 +528,90 @@ void LocalStore::ReleaseTarget(TargetId target_id) {
 
 QueryResult LocalStore::ExecuteQuery(const Query& query,
                                      bool use_previous_results) {
+  TRACE_SPAN("local_store.execute_query");
   return persistence_->Run("ExecuteQuery", [&] {
-    absl::optional<TargetData> target_data = GetTargetData(query.ToTarget());
-    SnapshotVersion last_limbo_free_snapshot_version;
-    DocumentKeySet remote_keys;
-
-    if (target_data) {
-      last_limbo_free_snapshot_version =
-          target_data->last_limbo_free_snapshot_version();
-      remote_keys = target_cache_->GetMatchingKeys(target_data->target_id());
+    return ExecuteQueryInTransaction(query, use_previous_results);
+  });
+}
+
+QueryResult LocalStore::ExecuteQueryInTransaction(const Query& query,
+                                                  bool use_previous_results) {
+  absl::optional<TargetData> target_data = GetTargetData(query.ToTarget());
+  SnapshotVersion last_limbo_free_snapshot_version;
+  DocumentKeySet remote_keys;
+
+  if (target_data) {
+    last_limbo_free_snapshot_version =
+        target_data->last_limbo_free_snapshot_version();
+    remote_keys = target_cache_->GetMatchingKeys(target_data->target_id());
+  }
+
+  model::DocumentMap documents = query_engine_->GetDocumentsMatchingQuery(
+      query,
+      use_previous_results ? last_limbo_free_snapshot_version
+                           : SnapshotVersion::None(),
+      use_previous_results ? remote_keys : DocumentKeySet{});
+  return QueryResult(std::move(documents), std::move(remote_keys));
+}
+
+std::vector<QueryResult> LocalStore::ExecuteQueries(
+    const std::vector<Query>& queries) {
+  TRACE_SPAN("local_store.execute_queries");
+  return persistence_->Run("ExecuteQueries", [&] {
+    // Queries over the same collection differ only in which of its documents
+    // they match, so group them by the unfiltered query over the collection.
+    std::unordered_map<Query, std::vector<size_t>> queries_by_collection;
+    for (size_t i = 0; i != queries.size(); ++i) {
+      const Query& query = queries[i];
+      queries_by_collection[Query(query.path(), query.collection_group())]
+          .push_back(i);
     }
 
-    model::DocumentMap documents = query_engine_->GetDocumentsMatchingQuery(
-        query,
-        use_previous_results ? last_limbo_free_snapshot_version
-                             : SnapshotVersion::None(),
-        use_previous_results ? remote_keys : DocumentKeySet{});
-    return QueryResult(std::move(documents), std::move(remote_keys));
+    std::vector<QueryResult> results(queries.size());
+    for (const auto& entry : queries_by_collection) {
+      const std::vector<size_t>& indexes = entry.second;
+      if (indexes.size() == 1) {
+        size_t i = indexes.front();
+        results[i] = ExecuteQueryInTransaction(
+            queries[i], /* use_previous_results= */ false);
+        continue;
+      }
+
+      DocumentMap collection_documents =
+          query_engine_->GetDocumentsMatchingQuery(
+              entry.first, SnapshotVersion::None(), DocumentKeySet{});
+      std::vector<Document> candidates;
+      candidates.reserve(collection_documents.size());
+      for (const auto& kv : collection_documents.underlying_map()) {
+        candidates.push_back(Document(kv.second));
+      }
+
+      for (size_t i : indexes) {
+        const Query& query = queries[i];
+
+        // The candidates are in key order, so the matches can be built into
+        // a map directly.
+        std::vector<bool> matches = query.MatchesBatch(candidates);
+        std::vector<std::pair<DocumentKey, Document>> matching;
+        for (size_t j = 0; j != candidates.size(); ++j) {
+          if (matches[j]) {
+            matching.emplace_back(candidates[j].key(), candidates[j]);
+          }
+        }
+        DocumentMap documents =
+            DocumentMap::FromSortedRange(matching.begin(), matching.end());
+
+        DocumentKeySet remote_keys;
+        absl::optional<TargetData> target_data =
+            GetTargetData(query.ToTarget());
+        if (target_data) {
+          remote_keys =
+              target_cache_->GetMatchingKeys(target_data->target_id());
+        }
+        results[i] = QueryResult(std::move(documents), std::move(remote_keys));
+      }
+    }
+    return results;
   });
 }
 
@@ -537,6 +622,7 @@ DocumentKeySet LocalStore::GetRemoteDocumentKeys(TargetId target_id) {
 }
 
 LruResults LocalStore::CollectGarbage(LruGarbageCollector* garbage_collector) {
+  TRACE_SPAN("local_store.collect_garbage");
   return persistence_->Run("Collect garbage", [&] {
     return garbage_collector->Collect(target_data_by_target_);
   });
@@ -212,6 +212,17 @@ class LocalStore {
    */
   QueryResult ExecuteQuery(const core::Query& query, bool use_previous_results);
 
+  /**
+   * Runs each of the specified queries against the local store without using
+   * results from previous executions, and returns their results in the same
+   * order.
+   *
+   * Queries over the same collection or collection group share a single scan
+   * of that collection.
+   */
+  std::vector<QueryResult> ExecuteQueries(
+      const std::vector<core::Query>& queries);
+
   /**
    * Notify the local store of the changed views to locally pin / unpin
    * documents.
@@ -265,6 +276,13 @@ class LocalStore {
    */
   absl::optional<TargetData> GetTargetData(const core::Target& query);
 
+  /**
+   * Runs the specified query within the current transaction. See
+   * `ExecuteQuery()`.
+   */
+  QueryResult ExecuteQueryInTransaction(const core::Query& query,
+                                        bool use_previous_results);
+
   /** Manages our in-memory or durable persistence. Owned by FirestoreClient. */
   Persistence* persistence_ = nullptr;
 
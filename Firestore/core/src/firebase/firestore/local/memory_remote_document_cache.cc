@@ -16,10 +16,14 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_lru_reference_delegate.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/sizer.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 
@@ -79,10 +83,9 @@ DocumentMap MemoryRemoteDocumentCache::GetMatching(
       !query.IsCollectionGroupQuery(),
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
-  DocumentMap results;
-
   // Documents are ordered by key, so we can use a prefix scan to narrow down
   // the documents we need to match the query against.
+  std::vector<Document> candidates;
   DocumentKey prefix{query.path().Append("")};
   for (auto it = docs_.lower_bound(prefix); it != docs_.end(); ++it) {
     const DocumentKey& key = it->first;
@@ -99,12 +102,19 @@ DocumentMap MemoryRemoteDocumentCache::GetMatching(
       continue;
     }
 
-    Document doc(maybe_doc);
-    if (query.Matches(doc)) {
-      results = results.insert(key, std::move(doc));
+    candidates.push_back(Document(maybe_doc));
+  }
+
+  // The candidates are in key order, so the matches can be built into a map
+  // directly.
+  std::vector<bool> matches = query.MatchesBatch(candidates);
+  std::vector<std::pair<DocumentKey, Document>> results;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (matches[i]) {
+      results.emplace_back(candidates[i].key(), std::move(candidates[i]));
     }
   }
-  return results;
+  return DocumentMap::FromSortedRange(results.begin(), results.end());
 }
 
 std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 
+#include <atomic>
 #include <ostream>
 #include <sstream>
 #include <utility>
@@ -81,7 +82,28 @@ class Document::Rep : public MaybeDocument::Rep {
 
     const auto& other_rep = static_cast<const Rep&>(other);
     return document_state_ == other_rep.document_state_ &&
-           data_ == other_rep.data_;
+           DataEquals(other_rep);
+  }
+
+  bool DataEquals(const Rep& other) const {
+    if (this == &other) return true;
+    if (data_hash() != other.data_hash()) return false;
+    return data_ == other.data_;
+  }
+
+  /**
+   * Returns a fingerprint of the document's data, computed on first use.
+   * Documents are shared across threads, but racing to compute the hash is
+   * harmless since every thread stores the same value.
+   */
+  size_t data_hash() const {
+    size_t hash = data_hash_.load(std::memory_order_relaxed);
+    if (hash == kUnknownHash) {
+      hash = data_.Hash();
+      if (hash == kUnknownHash) hash = kUnknownHash + 1;
+      data_hash_.store(hash, std::memory_order_relaxed);
+    }
+    return hash;
   }
 
   size_t Hash() const override {
@@ -97,9 +119,12 @@ class Document::Rep : public MaybeDocument::Rep {
  private:
   friend class Document;
 
+  static constexpr size_t kUnknownHash = 0;
+
   ObjectValue data_;
   DocumentState document_state_;
   absl::any proto_;
+  mutable std::atomic<size_t> data_hash_{kUnknownHash};
 };
 
 Document::Document(ObjectValue data,
@@ -130,6 +155,10 @@ const ObjectValue& Document::data() const {
   return doc_rep().data();
 }
 
+bool Document::HasEqualData(const Document& other) const {
+  return doc_rep().DataEquals(other.doc_rep());
+}
+
 absl::optional<FieldValue> Document::field(const FieldPath& path) const {
   return data().Get(path);
 }
@@ -106,6 +106,15 @@ class Document : public MaybeDocument {
 
   const ObjectValue& data() const;
 
+  /**
+   * Returns true if this document's data is equal to `other`'s.
+   *
+   * This is equivalent to comparing `data()` but documents keep a fingerprint
+   * of their contents, so documents that differ can usually be told apart
+   * without walking their data.
+   */
+  bool HasEqualData(const Document& other) const;
+
   absl::optional<FieldValue> field(const FieldPath& path) const;
 
   DocumentState document_state() const;
@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_MAP_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_MAP_H_
 
+#include <iterator>
+#include <type_traits>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
@@ -62,6 +64,19 @@ class DocumentMap {
 
   DocumentMap() = default;
 
+  /**
+   * Creates a DocumentMap from a random access range of key/`Document` pairs
+   * that is already sorted by key and free of duplicates, in linear time.
+   */
+  template <typename RandomIt>
+  static DocumentMap FromSortedRange(RandomIt first, RandomIt last) {
+    using entry_type = typename std::iterator_traits<RandomIt>::value_type;
+    static_assert(
+        std::is_same<typename entry_type::second_type, Document>::value,
+        "DocumentMap can only be built from Documents");
+    return DocumentMap{MaybeDocumentMap::FromSortedRange(first, last)};
+  }
+
   ABSL_MUST_USE_RESULT DocumentMap insert(const DocumentKey& key,
                                           const Document& value) const;
 
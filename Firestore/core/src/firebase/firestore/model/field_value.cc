@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <new>
 #include <set>
@@ -308,11 +309,8 @@ class ServerTimestampValue : public FieldValue::BaseValue {
   }
 
   size_t Hash() const override {
-    size_t result = TimestampInternal::Hash(value().local_write_time());
-    if (value().previous_value()) {
-      result = util::Hash(result, *value().previous_value());
-    }
-    return result;
+    // Equality only considers the local write time, so the hash must too.
+    return TimestampInternal::Hash(value().local_write_time());
   }
 
   const ServerTimestamp& value() const {
@@ -632,21 +630,27 @@ ObjectValue ObjectValue::Delete(const FieldPath& field_path) const {
 }
 
 absl::optional<FieldValue> ObjectValue::Get(const FieldPath& field_path) const {
+  const FieldValue* value = Find(field_path);
+  if (!value) return absl::nullopt;
+  return *value;
+}
+
+const FieldValue* ObjectValue::Find(const FieldPath& field_path) const {
   const FieldValue* current = &this->fv_;
   for (const auto& path : field_path) {
     if (current->type() != Type::Object) {
-      return absl::nullopt;
+      return nullptr;
     }
 
     const FieldValue::Map& entries = current->object_value();
     const auto iter = entries.find(path);
     if (iter == entries.end()) {
-      return absl::nullopt;
+      return nullptr;
     } else {
       current = &iter->second;
     }
   }
-  return *current;
+  return current;
 }
 
 FieldMask ObjectValue::ToFieldMask() const {
@@ -789,7 +793,7 @@ FieldValue FieldValue::FromMap(FieldValue::Map&& value) {
 }
 
 bool operator==(const FieldValue& lhs, const FieldValue& rhs) {
-  return lhs.rep_->Equals(*rhs.rep_);
+  return lhs.rep_ == rhs.rep_ || lhs.rep_->Equals(*rhs.rep_);
 }
 
 std::ostream& operator<<(std::ostream& os, const FieldValue& value) {
@@ -849,6 +853,172 @@ size_t ObjectValue::Hash() const {
   return fv_.Hash();
 }
 
+/**
+ * A pending change to a single field of an object.
+ *
+ * A kNested overlay describes an object field whose contents are `value` with
+ * the changes in `children` applied on top. kSet and kDelete overlays replace
+ * or remove the field outright and never have children.
+ */
+struct ObjectValue::Builder::Overlay {
+  enum class Kind {
+    kSet,
+    kDelete,
+    kNested,
+  };
+
+  Overlay(Kind overlay_kind, FieldValue overlay_value)
+      : kind(overlay_kind), value(std::move(overlay_value)) {
+  }
+
+  /**
+   * Returns the overlay for the object nested under `name`, converting or
+   * creating it as needed.
+   *
+   * If the field doesn't currently hold an object, a new empty object is
+   * started when `create_missing` is true; otherwise returns nullptr.
+   */
+  Overlay* NestedChild(const std::string& name, bool create_missing) {
+    auto found = children.find(name);
+    if (found == children.end()) {
+      const FieldValue::Map& entries = value.object_value();
+      auto existing = entries.find(name);
+      if (existing != entries.end() && existing->second.is_object()) {
+        return Emplace(name, Kind::kNested, existing->second);
+      } else if (create_missing) {
+        return Emplace(name, Kind::kNested, FieldValue::EmptyObject());
+      } else {
+        return nullptr;
+      }
+    }
+
+    Overlay* child = found->second.get();
+    if (child->kind == Kind::kNested) {
+      return child;
+    }
+    if (child->kind == Kind::kSet && child->value.is_object()) {
+      child->kind = Kind::kNested;
+      return child;
+    }
+    if (!create_missing) {
+      return nullptr;
+    }
+
+    child->kind = Kind::kNested;
+    child->value = FieldValue::EmptyObject();
+    return child;
+  }
+
+  void SetChild(const std::string& name,
+                Kind child_kind,
+                FieldValue child_value) {
+    children[name] = absl::make_unique<Overlay>(child_kind,
+                                                std::move(child_value));
+  }
+
+  /**
+   * Returns the object described by this overlay. If applying the children
+   * leaves every field as it was, returns `value` itself so that the result
+   * continues to share its representation with the original.
+   */
+  FieldValue Apply() const {
+    const FieldValue::Map& original = value.object_value();
+    FieldValue::Map result = original;
+    bool changed = false;
+
+    for (const auto& entry : children) {
+      const Overlay& child = *entry.second;
+      absl::optional<FieldValue> existing = original.get(entry.first);
+      switch (child.kind) {
+        case Kind::kSet:
+          if (existing != child.value) {
+            result = result.insert(entry.first, child.value);
+            changed = true;
+          }
+          break;
+        case Kind::kDelete:
+          if (existing) {
+            result = result.erase(entry.first);
+            changed = true;
+          }
+          break;
+        case Kind::kNested: {
+          FieldValue nested = child.Apply();
+          if (existing != nested) {
+            result = result.insert(entry.first, std::move(nested));
+            changed = true;
+          }
+          break;
+        }
+      }
+    }
+
+    return changed ? FieldValue::FromMap(std::move(result)) : value;
+  }
+
+  Kind kind;
+  FieldValue value;
+  std::map<std::string, std::unique_ptr<Overlay>> children;
+
+ private:
+  Overlay* Emplace(const std::string& name,
+                   Kind child_kind,
+                   FieldValue child_value) {
+    auto inserted = children.emplace(
+        name, absl::make_unique<Overlay>(child_kind, std::move(child_value)));
+    return inserted.first->second.get();
+  }
+};
+
+ObjectValue::Builder::Builder(ObjectValue base_object)
+    : root_(absl::make_unique<Overlay>(Overlay::Kind::kNested,
+                                       std::move(base_object.fv_))) {
+}
+
+ObjectValue::Builder::~Builder() = default;
+
+ObjectValue::Builder::Builder(Builder&& other) noexcept = default;
+
+ObjectValue::Builder& ObjectValue::Builder::operator=(
+    Builder&& other) noexcept = default;
+
+ObjectValue::Builder& ObjectValue::Builder::Set(const FieldPath& field_path,
+                                                FieldValue value) {
+  HARD_ASSERT(!field_path.empty(),
+              "Cannot set field for empty path on ObjectValue");
+
+  Overlay* parent = root_.get();
+  for (size_t i = 0; i + 1 < field_path.size(); ++i) {
+    parent = parent->NestedChild(field_path[i], /* create_missing= */ true);
+  }
+  parent->SetChild(field_path.last_segment(), Overlay::Kind::kSet,
+                   std::move(value));
+  return *this;
+}
+
+ObjectValue::Builder& ObjectValue::Builder::Delete(
+    const FieldPath& field_path) {
+  HARD_ASSERT(!field_path.empty(),
+              "Cannot delete field for empty path on ObjectValue");
+
+  Overlay* parent = root_.get();
+  for (size_t i = 0; i + 1 < field_path.size(); ++i) {
+    parent = parent->NestedChild(field_path[i], /* create_missing= */ false);
+    if (!parent) {
+      // If the found value isn't an object, it cannot contain the remaining
+      // segments of the path.
+      return *this;
+    }
+  }
+  parent->SetChild(field_path.last_segment(), Overlay::Kind::kDelete,
+                   FieldValue::Null());
+  return *this;
+}
+
+ObjectValue ObjectValue::Builder::Build() const {
+  return ObjectValue(root_->Apply());
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
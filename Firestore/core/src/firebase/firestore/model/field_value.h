@@ -283,6 +283,8 @@ class FieldValue {
 /** A structured object value stored in Firestore. */
 class ObjectValue : public util::Comparable<ObjectValue> {
  public:
+  class Builder;
+
   // Default constructible to make using this easy, though prefer
   // ObjectValue::Empty() to make intentions clear to readers.
   ObjectValue();
@@ -305,6 +307,12 @@ class ObjectValue : public util::Comparable<ObjectValue> {
    */
   absl::optional<FieldValue> Get(const FieldPath& field_path) const;
 
+  /**
+   * Returns the value at the given path or nullptr. Unlike `Get`, doesn't copy
+   * the value, which remains valid for as long as this ObjectValue.
+   */
+  const FieldValue* Find(const FieldPath& field_path) const;
+
   /**
    * Returns a FieldValue with the field at the named path set to value.
    * Any absent parent of the field will also be created accordingly.
@@ -363,6 +371,50 @@ class ObjectValue : public util::Comparable<ObjectValue> {
   FieldValue fv_;
 };
 
+/**
+ * Accumulates a batch of Set and Delete operations against an ObjectValue and
+ * applies them all at once.
+ *
+ * Calling ObjectValue::Set or ObjectValue::Delete repeatedly copies every
+ * object along the modified path for each operation. The Builder instead
+ * records the operations in a mutable overlay and rebuilds each affected
+ * nested object exactly once in Build(). The result is identical to applying
+ * the same operations sequentially.
+ */
+class ObjectValue::Builder {
+ public:
+  explicit Builder(ObjectValue base_object);
+  ~Builder();
+
+  Builder(Builder&& other) noexcept;
+  Builder& operator=(Builder&& other) noexcept;
+
+  /**
+   * Sets the field at the given path to the given value. Any absent parent of
+   * the field will also be created accordingly.
+   *
+   * @param field_path The field path to set. Cannot be empty.
+   * @param value The value to set.
+   */
+  Builder& Set(const FieldPath& field_path, FieldValue value);
+
+  /**
+   * Deletes the field at the given path. If there is no field at the specified
+   * path, this has no effect.
+   *
+   * @param field_path The field path to remove. Cannot be empty.
+   */
+  Builder& Delete(const FieldPath& field_path);
+
+  /** Returns a new ObjectValue with all pending operations applied. */
+  ObjectValue Build() const;
+
+ private:
+  struct Overlay;
+
+  std::unique_ptr<Overlay> root_;
+};
+
 class FieldValue::Reference {
  public:
   Reference(DatabaseId database_id, DocumentKey key)
@@ -41,7 +41,8 @@ std::ostream& operator<<(std::ostream& os, const MaybeDocument& doc) {
 bool operator==(const MaybeDocument& lhs, const MaybeDocument& rhs) {
   return lhs.rep_ == nullptr
              ? rhs.rep_ == nullptr
-             : (rhs.rep_ != nullptr && lhs.rep_->Equals(*rhs.rep_));
+             : (lhs.rep_ == rhs.rep_ ||
+                (rhs.rep_ != nullptr && lhs.rep_->Equals(*rhs.rep_)));
 }
 
 }  // namespace model
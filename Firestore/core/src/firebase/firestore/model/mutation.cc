@@ -87,6 +87,21 @@ SnapshotVersion Mutation::Rep::GetPostMutationVersion(
   }
 }
 
+MaybeDocument Mutation::Rep::LocalDocumentWithData(
+    const absl::optional<MaybeDocument>& maybe_doc,
+    ObjectValue new_data) const {
+  if (maybe_doc && maybe_doc->is_document()) {
+    Document doc(*maybe_doc);
+    if (doc.has_local_mutations() && doc.data() == new_data) {
+      return doc;
+    }
+  }
+
+  SnapshotVersion version = GetPostMutationVersion(maybe_doc);
+  return Document(std::move(new_data), key(), version,
+                  DocumentState::kLocalMutations);
+}
+
 bool operator==(const Mutation& lhs, const Mutation& rhs) {
   return lhs.rep_ == nullptr
              ? rhs.rep_ == nullptr
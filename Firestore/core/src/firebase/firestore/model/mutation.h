@@ -313,6 +313,18 @@ class Mutation {
     static SnapshotVersion GetPostMutationVersion(
         const absl::optional<MaybeDocument>& maybe_doc);
 
+    /**
+     * Creates the local view of a document whose contents are `new_data`
+     * after applying this mutation to `maybe_doc`.
+     *
+     * If `maybe_doc` is already a document with local mutations and the same
+     * data, it is returned unchanged so that repeated overlays share a single
+     * representation.
+     */
+    MaybeDocument LocalDocumentWithData(
+        const absl::optional<MaybeDocument>& maybe_doc,
+        ObjectValue new_data) const;
+
    private:
     DocumentKey key_;
     Precondition precondition_;
@@ -88,10 +88,7 @@ absl::optional<MaybeDocument> PatchMutation::Rep::ApplyToLocalView(
     return maybe_doc;
   }
 
-  ObjectValue new_data = PatchDocument(maybe_doc);
-  SnapshotVersion version = GetPostMutationVersion(maybe_doc);
-  return Document(std::move(new_data), key(), version,
-                  DocumentState::kLocalMutations);
+  return LocalDocumentWithData(maybe_doc, PatchDocument(maybe_doc));
 }
 
 ObjectValue PatchMutation::Rep::PatchDocument(
@@ -104,17 +101,18 @@ ObjectValue PatchMutation::Rep::PatchDocument(
 }
 
 ObjectValue PatchMutation::Rep::PatchObject(ObjectValue obj) const {
+  ObjectValue::Builder builder(std::move(obj));
   for (const FieldPath& path : mask_) {
     if (!path.empty()) {
       absl::optional<FieldValue> new_value = value_.Get(path);
       if (!new_value) {
-        obj = obj.Delete(path);
+        builder.Delete(path);
       } else {
-        obj = obj.Set(path, *new_value);
+        builder.Set(path, std::move(*new_value));
       }
     }
   }
-  return obj;
+  return builder.Build();
 }
 
 bool PatchMutation::Rep::Equals(const Mutation::Rep& other) const {
@@ -78,8 +78,7 @@ absl::optional<MaybeDocument> SetMutation::Rep::ApplyToLocalView(
     return maybe_doc;
   }
 
-  SnapshotVersion version = GetPostMutationVersion(maybe_doc);
-  return Document(value_, key(), version, DocumentState::kLocalMutations);
+  return LocalDocumentWithData(maybe_doc, value_);
 }
 
 bool SetMutation::Rep::Equals(const Mutation::Rep& other) const {
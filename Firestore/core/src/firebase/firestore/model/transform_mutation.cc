@@ -112,15 +112,13 @@ absl::optional<MaybeDocument> TransformMutation::Rep::ApplyToLocalView(
 
   std::vector<FieldValue> transform_results =
       LocalTransformResults(maybe_doc, base_doc, local_write_time);
-  ObjectValue new_data = TransformObject(doc.data(), transform_results);
-
-  return Document(std::move(new_data), doc.key(), doc.version(),
-                  DocumentState::kLocalMutations);
+  return LocalDocumentWithData(
+      maybe_doc, TransformObject(doc.data(), transform_results));
 }
 
 absl::optional<ObjectValue> TransformMutation::Rep::ExtractBaseValue(
     const absl::optional<MaybeDocument>& maybe_doc) const {
-  absl::optional<ObjectValue> base_object;
+  absl::optional<ObjectValue::Builder> base_object;
 
   for (const FieldTransform& transform : field_transforms_) {
     absl::optional<FieldValue> existing_value;
@@ -132,13 +130,16 @@ absl::optional<ObjectValue> TransformMutation::Rep::ExtractBaseValue(
         transform.transformation().ComputeBaseValue(existing_value);
     if (coerced_value) {
       if (!base_object) {
-        base_object = ObjectValue::Empty();
+        base_object.emplace(ObjectValue::Empty());
       }
-      base_object = base_object->Set(transform.path(), *coerced_value);
+      base_object->Set(transform.path(), std::move(*coerced_value));
     }
   }
 
-  return base_object;
+  if (!base_object) {
+    return absl::nullopt;
+  }
+  return base_object->Build();
 }
 
 bool TransformMutation::Rep::Equals(const Mutation::Rep& other) const {
@@ -209,12 +210,13 @@ ObjectValue TransformMutation::Rep::TransformObject(
   HARD_ASSERT(transform_results.size() == field_transforms_.size(),
               "Transform results size mismatch.");
 
+  ObjectValue::Builder builder(std::move(object_value));
   for (size_t i = 0; i < field_transforms_.size(); i++) {
     const FieldTransform& field_transform = field_transforms_[i];
     const FieldPath& field_path = field_transform.path();
-    object_value = object_value.Set(field_path, transform_results[i]);
+    builder.Set(field_path, transform_results[i]);
   }
-  return object_value;
+  return builder.Build();
 }
 
 }  // namespace model
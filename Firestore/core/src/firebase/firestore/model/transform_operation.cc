@@ -16,8 +16,11 @@
 
 #include "Firestore/core/src/firebase/firestore/model/transform_operation.h"
 
+#include <algorithm>
 #include <memory>
 #include <ostream>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -240,21 +243,111 @@ FieldValue::Array ArrayTransform::Rep::CoercedFieldValuesArray(
   }
 }
 
-FieldValue ArrayTransform::Rep::Apply(
-    const absl::optional<FieldValue>& previous_value) const {
-  FieldValue::Array result = CoercedFieldValuesArray(previous_value);
-  for (const FieldValue& element : elements_) {
-    auto pos = absl::c_find(result, element);
-    if (type_ == Type::ArrayUnion) {
-      if (pos == result.end()) {
-        result.push_back(element);
+namespace {
+
+/**
+ * Below this many element comparisons, a linear scan of the array is cheaper
+ * than hashing every element.
+ */
+constexpr size_t kMaxLinearComparisons = 256;
+
+/** Hashes FieldValues by pointer so that indexes don't copy their elements. */
+struct FieldValuePtrHash {
+  size_t operator()(const FieldValue* value) const {
+    return value->Hash();
+  }
+};
+
+struct FieldValuePtrEqual {
+  bool operator()(const FieldValue* lhs, const FieldValue* rhs) const {
+    return *lhs == *rhs;
+  }
+};
+
+using FieldValuePtrSet = std::unordered_set<const FieldValue*,
+                                            FieldValuePtrHash,
+                                            FieldValuePtrEqual>;
+
+using FieldValuePtrCounts = std::unordered_map<const FieldValue*, size_t,
+                                                FieldValuePtrHash,
+                                                FieldValuePtrEqual>;
+
+/**
+ * Appends each of the given elements to `result` unless an equal value is
+ * already present, preserving the order of both the existing array and the
+ * appended elements.
+ */
+void UnionElements(const std::vector<FieldValue>& elements,
+                   FieldValue::Array* result) {
+  if (result->size() * elements.size() <= kMaxLinearComparisons) {
+    for (const FieldValue& element : elements) {
+      if (absl::c_find(*result, element) == result->end()) {
+        result->push_back(element);
       }
-    } else {
-      HARD_ASSERT(type_ == Type::ArrayRemove);
-      if (pos != result.end()) {
-        result.erase(pos);
+    }
+    return;
+  }
+
+  // The set points into `result`, so reserve up front to ensure that pushing
+  // new elements never invalidates its contents.
+  result->reserve(result->size() + elements.size());
+
+  FieldValuePtrSet present(result->size() + elements.size());
+  for (const FieldValue& existing : *result) {
+    present.insert(&existing);
+  }
+
+  for (const FieldValue& element : elements) {
+    if (present.count(&element) == 0) {
+      result->push_back(element);
+      present.insert(&result->back());
+    }
+  }
+}
+
+/**
+ * Removes from `result` the first occurrence of each of the given elements. An
+ * element listed more than once removes that many occurrences.
+ */
+void RemoveElements(const std::vector<FieldValue>& elements,
+                    FieldValue::Array* result) {
+  if (result->size() * elements.size() <= kMaxLinearComparisons) {
+    for (const FieldValue& element : elements) {
+      auto pos = absl::c_find(*result, element);
+      if (pos != result->end()) {
+        result->erase(pos);
       }
     }
+    return;
+  }
+
+  FieldValuePtrCounts pending(elements.size());
+  for (const FieldValue& element : elements) {
+    ++pending[&element];
+  }
+
+  auto removed = std::remove_if(
+      result->begin(), result->end(), [&](const FieldValue& value) {
+        auto found = pending.find(&value);
+        if (found == pending.end() || found->second == 0) {
+          return false;
+        }
+        --found->second;
+        return true;
+      });
+  result->erase(removed, result->end());
+}
+
+}  // namespace
+
+FieldValue ArrayTransform::Rep::Apply(
+    const absl::optional<FieldValue>& previous_value) const {
+  FieldValue::Array result = CoercedFieldValuesArray(previous_value);
+  if (type_ == Type::ArrayUnion) {
+    UnionElements(elements_, &result);
+  } else {
+    HARD_ASSERT(type_ == Type::ArrayRemove);
+    RemoveElements(elements_, &result);
   }
   return FieldValue::FromArray(std::move(result));
 }
@@ -266,6 +266,7 @@ void Datastore::ResumeRpcWithCredentials(const OnCredentials& on_credentials) {
         }
 
         strong_this->worker_queue_->EnqueueRelaxed(
+            AsyncQueue::Priority::Normal, "datastore.credentials",
             [weak_this, result, on_credentials] {
               auto strong_this = weak_this.lock();
               if (!strong_this) {
@@ -19,12 +19,32 @@
 #include <memory>
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
 namespace firebase {
 namespace firestore {
 namespace remote {
 
 using util::AsyncQueue;
 
+namespace {
+
+const char* ProfileLabel(GrpcCompletion::Type type) {
+  switch (type) {
+    case GrpcCompletion::Type::Start:
+      return "grpc_completion.start";
+    case GrpcCompletion::Type::Read:
+      return "grpc_completion.read";
+    case GrpcCompletion::Type::Write:
+      return "grpc_completion.write";
+    case GrpcCompletion::Type::Finish:
+      return "grpc_completion.finish";
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
 std::shared_ptr<GrpcCompletion> GrpcCompletion::Create(
     Type type,
     const std::shared_ptr<util::AsyncQueue>& worker_queue,
@@ -90,11 +110,12 @@ void GrpcCompletion::Complete(bool ok) {
   // operation run. If this weren't a retain that ordering would have the
   // callback use after free.
   auto shared_this = grpc_ownership_;
-  worker_queue_->Enqueue([shared_this, ok] {
-    if (shared_this->callback_) {
-      shared_this->callback_(ok, shared_this);
-    }
-  });
+  worker_queue_->Enqueue(AsyncQueue::Priority::Normal, ProfileLabel(type_),
+                         [shared_this, ok] {
+                           if (shared_this->callback_) {
+                             shared_this->callback_(ok, shared_this);
+                           }
+                         });
 
   // Having called Complete, gRPC has released its ownership interest in this
   // object. Once the queued operation completes the `GrpcCompletion` will be
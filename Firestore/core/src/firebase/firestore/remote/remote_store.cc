@@ -29,6 +29,7 @@
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/to_string.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
@@ -204,6 +205,8 @@ void RemoteStore::CleanUpWatchStreamState() {
 }
 
 void RemoteStore::OnWatchStreamOpen() {
+  METRICS_COUNTER_ADD("remote_store.watch_stream.opened", 1);
+
   // Restore any existing watches.
   for (const auto& kv : listen_targets_) {
     SendWatchRequest(kv.second);
@@ -211,11 +214,14 @@ void RemoteStore::OnWatchStreamOpen() {
 }
 
 void RemoteStore::OnWatchStreamClose(const Status& status) {
+  METRICS_COUNTER_ADD("remote_store.watch_stream.closed", 1);
   if (status.ok()) {
     // Graceful stop (due to Stop() or idle timeout). Make sure that's
     // desirable.
     HARD_ASSERT(!ShouldStartWatchStream(),
                 "Watch stream was stopped gracefully while still needed.");
+  } else {
+    METRICS_COUNTER_ADD("remote_store.watch_stream.failed", 1);
   }
 
   CleanUpWatchStreamState();
@@ -235,6 +241,8 @@ void RemoteStore::OnWatchStreamClose(const Status& status) {
 
 void RemoteStore::OnWatchStreamChange(const WatchChange& change,
                                       const SnapshotVersion& snapshot_version) {
+  TRACE_SPAN("remote_store.watch_stream.change");
+
   // Mark the connection as Online because we got a message from the server.
   online_state_tracker_.UpdateState(OnlineState::Online);
 
@@ -269,6 +277,7 @@ void RemoteStore::OnWatchStreamChange(const WatchChange& change,
 }
 
 void RemoteStore::RaiseWatchSnapshot(const SnapshotVersion& snapshot_version) {
+  TRACE_SPAN("remote_store.watch_stream.snapshot");
   HARD_ASSERT(snapshot_version != SnapshotVersion::None(),
               "Can't raise event for unknown SnapshotVersion");
 
@@ -397,10 +406,13 @@ void RemoteStore::StartWriteStream() {
 }
 
 void RemoteStore::OnWriteStreamOpen() {
+  METRICS_COUNTER_ADD("remote_store.write_stream.opened", 1);
   write_stream_->WriteHandshake();
 }
 
 void RemoteStore::OnWriteStreamHandshakeComplete() {
+  METRICS_COUNTER_ADD("remote_store.write_stream.handshakes", 1);
+
   // Record the stream token.
   local_store_->SetLastStreamToken(write_stream_->last_stream_token());
 
@@ -413,6 +425,8 @@ void RemoteStore::OnWriteStreamHandshakeComplete() {
 void RemoteStore::OnWriteStreamMutationResult(
     SnapshotVersion commit_version,
     std::vector<MutationResult> mutation_results) {
+  TRACE_SPAN("remote_store.write_stream.mutation_result");
+
   // This is a response to a write containing mutations and should be correlated
   // to the first write in our write pipeline.
   HARD_ASSERT(!write_pipeline_.empty(), "Got result for empty write pipeline");
@@ -431,11 +445,14 @@ void RemoteStore::OnWriteStreamMutationResult(
 }
 
 void RemoteStore::OnWriteStreamClose(const Status& status) {
+  METRICS_COUNTER_ADD("remote_store.write_stream.closed", 1);
   if (status.ok()) {
     // Graceful stop (due to Stop() or idle timeout). Make sure that's
     // desirable.
     HARD_ASSERT(!ShouldStartWriteStream(),
                 "Write stream was stopped gracefully while still needed.");
+  } else {
+    METRICS_COUNTER_ADD("remote_store.write_stream.failed", 1);
   }
 
   // If the write stream closed due to an error, invoke the error callbacks if
@@ -111,16 +111,18 @@ void Stream::RequestCredentials() {
       return;
     }
 
-    strong_this->worker_queue_->EnqueueRelaxed([maybe_token, weak_this,
-                                                initial_close_count] {
-      auto strong_this = weak_this.lock();
-      // Streams can be stopped while waiting for authorization, so need
-      // to check the close count.
-      if (!strong_this || strong_this->close_count_ != initial_close_count) {
-        return;
-      }
-      strong_this->ResumeStartWithCredentials(maybe_token);
-    });
+    strong_this->worker_queue_->EnqueueRelaxed(
+        AsyncQueue::Priority::Normal, "stream.credentials",
+        [maybe_token, weak_this, initial_close_count] {
+          auto strong_this = weak_this.lock();
+          // Streams can be stopped while waiting for authorization, so need
+          // to check the close count.
+          if (!strong_this ||
+              strong_this->close_count_ != initial_close_count) {
+            return;
+          }
+          strong_this->ResumeStartWithCredentials(maybe_token);
+        });
   });
 }
 
@@ -16,16 +16,159 @@
 
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 
+#include <map>
+#include <string>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 #include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 
 namespace firebase {
 namespace firestore {
 namespace util {
 
+namespace {
+
+namespace chr = std::chrono;
+
+const char* kUnlabeled = "unlabeled";
+
+const char* TimerIdLabel(TimerId timer_id) {
+  switch (timer_id) {
+    case TimerId::All:
+      return "all";
+    case TimerId::ListenStreamIdle:
+      return "listen_stream_idle";
+    case TimerId::ListenStreamConnectionBackoff:
+      return "listen_stream_connection_backoff";
+    case TimerId::WriteStreamIdle:
+      return "write_stream_idle";
+    case TimerId::WriteStreamConnectionBackoff:
+      return "write_stream_connection_backoff";
+    case TimerId::OnlineStateTimeout:
+      return "online_state_timeout";
+    case TimerId::GarbageCollectionDelay:
+      return "garbage_collection_delay";
+    case TimerId::RetryTransaction:
+      return "retry_transaction";
+  }
+  UNREACHABLE();
+}
+
+int64_t MicrosecondsBetween(Tracing::Clock::time_point from,
+                            Tracing::Clock::time_point to) {
+  int64_t result = chr::duration_cast<chr::microseconds>(to - from).count();
+  return result < 0 ? 0 : result;
+}
+
+/** The metrics recorded for operations with a given label. */
+class LabelProfile {
+ public:
+  /** Returns the profile for `label`, creating it if necessary. */
+  static LabelProfile* Get(const char* label) {
+    // Intentionally leaked to avoid destruction order issues at exit.
+    static auto* mutex = new std::mutex();
+    static auto* profiles =
+        new std::map<std::string, std::unique_ptr<LabelProfile>>();
+
+    std::lock_guard<std::mutex> lock{*mutex};
+    std::unique_ptr<LabelProfile>& profile = (*profiles)[label];
+    if (!profile) profile = absl::WrapUnique(new LabelProfile(label));
+    return profile.get();
+  }
+
+  const char* label() const {
+    return label_;
+  }
+
+  Histogram* wait() const {
+    return wait_;
+  }
+
+  Histogram* run() const {
+    return run_;
+  }
+
+  /** Records that an operation with this label was enqueued. */
+  void AddPending() {
+    int depth = ++pending_;
+    if (Metrics::enabled()) depth_->Record(depth);
+  }
+
+  /** Records that an operation with this label started or was discarded. */
+  void RemovePending() {
+    --pending_;
+  }
+
+ private:
+  explicit LabelProfile(const char* label)
+      : label_{label},
+        wait_{Metrics::GetHistogram(absl::StrCat("async_queue.", label,
+                                                 ".wait"))},
+        run_{Metrics::GetHistogram(absl::StrCat("async_queue.", label,
+                                                ".run"))},
+        depth_{Metrics::GetHistogram(absl::StrCat("async_queue.", label,
+                                                  ".depth"))} {
+  }
+
+  const char* label_;
+  Histogram* wait_;
+  Histogram* run_;
+  Histogram* depth_;
+
+  // Shared by all queues, since the histograms are too.
+  std::atomic<int> pending_{0};
+};
+
+/**
+ * An operation that has been enqueued but hasn't started running yet. Counts
+ * as pending in its profile until it starts or is discarded.
+ */
+class PendingOperation {
+ public:
+  PendingOperation(LabelProfile* profile, Tracing::Clock::time_point due)
+      : profile_{profile}, due_{due} {
+    profile_->AddPending();
+  }
+
+  ~PendingOperation() {
+    if (!started_) profile_->RemovePending();
+  }
+
+  PendingOperation(const PendingOperation&) = delete;
+  PendingOperation& operator=(const PendingOperation&) = delete;
+
+  void Run(const AsyncQueue::Operation& operation) {
+    started_ = true;
+    profile_->RemovePending();
+
+    Tracing::Clock::time_point start = Tracing::Clock::now();
+    operation();
+    Tracing::Clock::time_point end = Tracing::Clock::now();
+
+    if (Metrics::enabled()) {
+      profile_->wait()->Record(MicrosecondsBetween(due_, start));
+      profile_->run()->Record(MicrosecondsBetween(start, end));
+    }
+    if (Tracing::enabled()) {
+      Tracing::RecordSpan(profile_->label(), start, end);
+    }
+  }
+
+ private:
+  LabelProfile* profile_;
+  Tracing::Clock::time_point due_;
+  bool started_ = false;
+};
+
+}  // namespace
+
+constexpr int AsyncQueue::kMaxSkippedOperations;
+constexpr int AsyncQueue::kPriorityCount;
+
 std::shared_ptr<AsyncQueue> AsyncQueue::Create(
     std::unique_ptr<Executor> executor) {
   // Use new because make_shared cannot access a private constructor.
@@ -72,8 +215,18 @@ void AsyncQueue::ExecuteBlocking(const Operation& operation) {
 }
 
 void AsyncQueue::Enqueue(const Operation& operation) {
+  Enqueue(Priority::Normal, operation);
+}
+
+void AsyncQueue::Enqueue(Priority priority, const Operation& operation) {
+  Enqueue(priority, kUnlabeled, operation);
+}
+
+void AsyncQueue::Enqueue(Priority priority,
+                         const char* label,
+                         const Operation& operation) {
   VerifySequentialOrder();
-  EnqueueRelaxed(operation);
+  EnqueueRelaxed(priority, label, operation);
 }
 
 void AsyncQueue::EnqueueAndInitiateShutdown(const Operation& operation) {
@@ -81,14 +234,14 @@ void AsyncQueue::EnqueueAndInitiateShutdown(const Operation& operation) {
   VerifySequentialOrder();
 
   is_shutting_down_ = true;
-  executor_->Execute(Wrap(operation));
+  executor_->Execute(WrapImmediate(Profile(kUnlabeled, operation)));
 }
 
 void AsyncQueue::EnqueueEvenAfterShutdown(const Operation& operation) {
   // Still guarding the lock to ensure sequential scheduling.
   std::lock_guard<std::mutex> lock{shut_down_mutex_};
   VerifySequentialOrder();
-  executor_->Execute(Wrap(operation));
+  executor_->Execute(WrapImmediate(Profile(kUnlabeled, operation)));
 }
 
 bool AsyncQueue::is_shutting_down() const {
@@ -97,11 +250,67 @@ bool AsyncQueue::is_shutting_down() const {
 }
 
 void AsyncQueue::EnqueueRelaxed(const Operation& operation) {
+  EnqueueRelaxed(Priority::Normal, operation);
+}
+
+void AsyncQueue::EnqueueRelaxed(Priority priority,
+                                const Operation& operation) {
+  EnqueueRelaxed(priority, kUnlabeled, operation);
+}
+
+void AsyncQueue::EnqueueRelaxed(Priority priority,
+                                const char* label,
+                                const Operation& operation) {
   std::lock_guard<std::mutex> lock{shut_down_mutex_};
   if (is_shutting_down_) {
     return;
   }
-  executor_->Execute(Wrap(operation));
+
+  {
+    std::lock_guard<std::mutex> lanes_lock{lanes_mutex_};
+    lanes_[static_cast<int>(priority)].push_back(Profile(label, operation));
+  }
+
+  // The executor still sees one operation per enqueued operation, so anything
+  // enqueued before an operation that bypasses the lanes (like the one
+  // initiating shutdown) is guaranteed to run before it.
+  executor_->Execute(
+      WrapImmediate([this] { RunNextPrioritizedOperation(); }));
+}
+
+void AsyncQueue::RunNextPrioritizedOperation() {
+  Operation operation;
+  {
+    std::lock_guard<std::mutex> lock{lanes_mutex_};
+
+    // Pick the highest-priority lane with pending operations, unless a lower
+    // one has been passed over too many times.
+    int next = -1;
+    for (int i = 0; i < kPriorityCount; ++i) {
+      if (lanes_[i].empty()) continue;
+
+      if (next == -1) {
+        next = i;
+      } else if (skipped_operations_[i] >= kMaxSkippedOperations) {
+        next = i;
+        break;
+      }
+    }
+    HARD_ASSERT(next != -1, "No operation is pending in any lane");
+
+    for (int i = 0; i < kPriorityCount; ++i) {
+      if (i == next) {
+        skipped_operations_[i] = 0;
+      } else if (!lanes_[i].empty()) {
+        ++skipped_operations_[i];
+      }
+    }
+
+    operation = std::move(lanes_[next].front());
+    lanes_[next].pop_front();
+  }
+
+  operation();
 }
 
 DelayedOperation AsyncQueue::EnqueueAfterDelay(Milliseconds delay,
@@ -119,7 +328,9 @@ DelayedOperation AsyncQueue::EnqueueAfterDelay(Milliseconds delay,
     delay = Milliseconds(0);
   }
 
-  Executor::TaggedOperation tagged{static_cast<int>(timer_id), Wrap(operation)};
+  Executor::TaggedOperation tagged{
+      static_cast<int>(timer_id),
+      Wrap(Profile(TimerIdLabel(timer_id), operation, delay))};
   return executor_->Schedule(delay, std::move(tagged));
 }
 
@@ -132,6 +343,42 @@ AsyncQueue::Operation AsyncQueue::Wrap(const Operation& operation) {
   return [shared_this, operation] { shared_this->ExecuteBlocking(operation); };
 }
 
+AsyncQueue::Operation AsyncQueue::Profile(const char* label,
+                                          const Operation& operation,
+                                          Milliseconds delay) {
+  if (!Metrics::enabled() && !Tracing::enabled()) {
+    return operation;
+  }
+
+  auto pending = std::make_shared<PendingOperation>(
+      LabelProfile::Get(label), Tracing::Clock::now() + delay);
+  return [pending, operation] { pending->Run(operation); };
+}
+
+AsyncQueue::Operation AsyncQueue::WrapImmediate(const Operation& operation) {
+  if (!Metrics::enabled() && !Tracing::enabled()) {
+    return Wrap(operation);
+  }
+
+  int depth = ++measured_operations_;
+  TRACE_COUNTER("async_queue.depth", depth);
+
+  auto enqueued = std::chrono::steady_clock::now();
+  auto shared_this = shared_from_this();
+  return [shared_this, operation, enqueued] {
+    int depth = --shared_this->measured_operations_;
+    TRACE_COUNTER("async_queue.depth", depth);
+    METRICS_HISTOGRAM_RECORD(
+        "async_queue.latency",
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - enqueued)
+            .count());
+
+    TRACE_SPAN("async_queue.operation");
+    shared_this->ExecuteBlocking(operation);
+  };
+}
+
 void AsyncQueue::VerifySequentialOrder() const {
   // This is the inverse of `VerifyIsCurrentQueue`.
   HARD_ASSERT(!is_operation_in_progress_ || !executor_->IsCurrentExecutor(),
@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT(build/c++11)
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
@@ -82,6 +83,23 @@ enum class TimerId {
 // invoked on the queue or not; check "preconditions" section in comments on
 // each method.
 //
+// Operations enqueued for immediate execution are assigned to one of several
+// priority lanes. Operations are FIFO-ordered within a lane, and operations in
+// a higher-priority lane run before those in lower-priority ones. To bound
+// starvation, a lane that has been passed over `kMaxSkippedOperations` times in
+// a row is served next (after any higher lane in the same situation).
+// Prioritization only changes the order in which operations run; they still
+// run one at a time.
+//
+// Operations may be given a label naming their caller. While metrics are
+// enabled (see `Metrics`), the queue records for each label how long operations
+// waited to run, how long they ran and how many were pending, in histograms
+// named `async_queue.<label>.wait`, `async_queue.<label>.run` (both in
+// microseconds) and `async_queue.<label>.depth`. Delayed operations are labeled
+// by their `TimerId`, and operations enqueued without a label are recorded as
+// `unlabeled`. While tracing is enabled (see `Tracing`), each labeled operation
+// is also recorded as a span named after its label.
+//
 // A significant portion of `AsyncQueue` interface only exists for test purposes
 // and must *not* be used in regular code.
 class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
@@ -89,6 +107,23 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   using Operation = Executor::Operation;
   using Milliseconds = Executor::Milliseconds;
 
+  // The lanes operations can be enqueued into, from highest to lowest priority.
+  enum class Priority {
+    // Operations requested directly by the user, such as listening to a query
+    // or writing a document, which the user is likely waiting on.
+    Interactive,
+
+    // Everything else, notably handling responses from the backend.
+    Normal,
+
+    // Maintenance work that nobody is waiting on, such as garbage collection.
+    Background,
+  };
+
+  // The number of times an operation may be passed over in favor of operations
+  // in higher-priority lanes before it is run regardless of their priority.
+  static constexpr int kMaxSkippedOperations = 16;
+
   static std::shared_ptr<AsyncQueue> Create(std::unique_ptr<Executor> executor);
 
   // Asserts for the caller that it is being invoked as part of an operation on
@@ -98,7 +133,8 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   // Enqueue methods
 
   // Puts the `operation` on the queue to be executed as soon as possible, while
-  // maintaining FIFO order.
+  // maintaining FIFO order. The operation is put in the `Priority::Normal`
+  // lane.
   //
   // Precondition: `Enqueue` calls cannot be nested; that is, `Enqueue` may not
   // be called by a previously enqueued operation when it is run (as a special
@@ -109,6 +145,15 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   // calling `Enqueue` is a no-op.
   void Enqueue(const Operation& operation);
 
+  // Like `Enqueue`, but puts the `operation` in the lane for `priority`.
+  void Enqueue(Priority priority, const Operation& operation);
+
+  // Like `Enqueue`, but also labels the `operation` for profiling. `label` must
+  // be a string literal.
+  void Enqueue(Priority priority,
+               const char* label,
+               const Operation& operation);
+
   // Like `Enqueue`, but also starts the shutdown process. Once the shutdown
   // process has started, calling any Enqueue* methods becomes a no-op
   //
@@ -122,6 +167,10 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
 
   // Like `Enqueue`, but without applying any prerequisite checks.
   void EnqueueRelaxed(const Operation& operation);
+  void EnqueueRelaxed(Priority priority, const Operation& operation);
+  void EnqueueRelaxed(Priority priority,
+                      const char* label,
+                      const Operation& operation);
 
   // Whether the queue has initiated its shutdown process.
   bool is_shutting_down() const;
@@ -188,8 +237,26 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
  private:
   explicit AsyncQueue(std::unique_ptr<Executor> executor);
 
+  static constexpr int kPriorityCount = 3;
+
   Operation Wrap(const Operation& operation);
 
+  // If metrics or tracing are enabled, wraps `operation` to record its wait
+  // time, run time and the number of pending operations under `label`, taking
+  // the wait time to start `delay` after now. Otherwise returns `operation`.
+  static Operation Profile(const char* label,
+                           const Operation& operation,
+                           Milliseconds delay = Milliseconds(0));
+
+  // Like `Wrap`, for operations meant to run as soon as possible. If metrics
+  // or tracing are enabled, also records the number of such operations waiting
+  // to run and how long each one waited.
+  Operation WrapImmediate(const Operation& operation);
+
+  // Runs the operation that should go next according to lane priorities. Each
+  // operation put in a lane is paired with one call to this on the executor.
+  void RunNextPrioritizedOperation();
+
   // Asserts that the current invocation happens asynchronously on the queue.
   void VerifyIsCurrentExecutor() const;
   void VerifySequentialOrder() const;
@@ -201,6 +268,14 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   mutable std::mutex shut_down_mutex_;
 
   std::vector<TimerId> timer_ids_to_skip_;
+
+  std::mutex lanes_mutex_;
+  std::deque<Operation> lanes_[kPriorityCount];
+  int skipped_operations_[kPriorityCount] = {};
+
+  // The number of operations wrapped by `WrapImmediate` while metrics or
+  // tracing were enabled that haven't started running yet.
+  std::atomic<int> measured_operations_{0};
 };
 
 }  // namespace util
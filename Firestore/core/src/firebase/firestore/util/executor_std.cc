@@ -79,7 +79,7 @@ ExecutorStd::~ExecutorStd() {
 }
 
 void ExecutorStd::Execute(Operation&& operation) {
-  PushOnSchedule(std::move(operation), Immediate());
+  PushImmediate(std::move(operation));
 }
 
 DelayedOperation ExecutorStd::Schedule(const Milliseconds delay,
@@ -91,44 +91,115 @@ DelayedOperation ExecutorStd::Schedule(const Milliseconds delay,
 
   namespace chr = std::chrono;
   const auto now = chr::time_point_cast<Milliseconds>(chr::steady_clock::now());
-  const auto id =
-      PushOnSchedule(std::move(tagged.operation), now + delay, tagged.tag);
+  const auto id = PushOnSchedule(std::move(tagged.operation), now + delay, now,
+                                 tagged.tag);
 
   return DelayedOperation{[this, id] { TryCancel(id); }};
 }
 
 void ExecutorStd::TryCancel(const Id operation_id) {
-  schedule_.RemoveIf(
-      [operation_id](const Entry& e) { return e.id == operation_id; });
+  std::lock_guard<std::mutex> lock{mutex_};
+  delayed_.Remove(operation_id);
 }
 
 ExecutorStd::Id ExecutorStd::PushOnSchedule(Operation&& operation,
                                             const TimePoint when,
+                                            const TimePoint now,
                                             const Tag tag) {
-  // Note: operations scheduled for immediate execution don't actually need an
-  // id. This could be tweaked to reuse the same id for all such operations.
   const auto id = NextId();
-  schedule_.Push(Entry{std::move(operation), id, tag}, when);
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    delayed_.Push(id, Entry{std::move(operation), id, tag}, when, now);
+  }
+  // The new operation may be due before whatever the idle threads are waiting
+  // for.
+  wake_up_.notify_all();
   return id;
 }
 
+void ExecutorStd::PushImmediate(Operation&& operation) {
+  // Operations scheduled for immediate execution don't need an id since they
+  // cannot be canceled.
+  immediate_.Push(Entry{std::move(operation), /*id=*/0});
+
+  // Pairs with the increment in `WaitForWork`: either the idle thread sees
+  // the new entry before going to sleep, or this sees the idle thread and
+  // wakes it.
+  if (idle_threads_.load() > 0) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    wake_up_.notify_one();
+  }
+}
+
 void ExecutorStd::PollingThread() {
   // Keep a local shared_ptr here to ensure that the atomic pointed to by
   // shutting_down_ remains valid even after the destruction of the executor.
   std::shared_ptr<std::atomic<bool>> local_shutting_down = shutting_down_;
   while (!*local_shutting_down) {
-    Entry entry = schedule_.PopBlocking();
+    Entry entry;
+    if (!PopNext(&entry)) {
+      WaitForWork();
+      continue;
+    }
+
     if (entry.tagged.operation) {
       entry.tagged.operation();
     }
   }
 }
 
+bool ExecutorStd::PopNext(Entry* entry) {
+  {
+    std::lock_guard<std::mutex> lock{pop_mutex_};
+    if (immediate_.Pop(entry)) return true;
+  }
+
+  namespace chr = std::chrono;
+  const auto now = chr::time_point_cast<Milliseconds>(chr::steady_clock::now());
+  std::lock_guard<std::mutex> lock{mutex_};
+  absl::optional<Entry> due = delayed_.PopDue(now);
+  if (!due) return false;
+
+  *entry = std::move(due).value();
+  return true;
+}
+
+void ExecutorStd::WaitForWork() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  ++idle_threads_;
+
+  bool has_immediate;
+  {
+    std::lock_guard<std::mutex> pop_lock{pop_mutex_};
+    has_immediate = !immediate_.empty();
+  }
+
+  if (has_immediate) {
+    // An operation is available, or about to be once its producer finishes
+    // linking it in.
+    lock.unlock();
+    std::this_thread::yield();
+  } else {
+    absl::optional<TimePoint> next_due = delayed_.NextDue();
+    if (next_due) {
+      // Workaround for Visual Studio 2015: cast to a time point with
+      // resolution that's at least as fine-grained as the clock on which
+      // `wait_until` is parametrized.
+      wake_up_.wait_until(lock,
+                          std::chrono::time_point_cast<
+                              std::chrono::steady_clock::duration>(*next_due));
+    } else {
+      wake_up_.wait(lock);
+    }
+  }
+
+  --idle_threads_;
+}
+
 void ExecutorStd::UnblockQueue() {
-  // Put a no-op for immediate execution on the queue to ensure that
-  // `schedule_.PopBlocking` returns, and worker thread can notice that shutdown
-  // is in progress.
-  schedule_.Push(Entry{[] {}, /*id=*/0}, Immediate());
+  // Put a no-op for immediate execution on the queue to ensure that worker
+  // threads wake up and notice that shutdown is in progress.
+  PushImmediate([] {});
 }
 
 ExecutorStd::Id ExecutorStd::NextId() {
@@ -171,13 +242,14 @@ void ExecutorStd::ExecuteBlocking(Operation&& operation) {
 }
 
 bool ExecutorStd::IsScheduled(const Tag tag) const {
-  return schedule_.Contains(
+  std::lock_guard<std::mutex> lock{mutex_};
+  return delayed_.Contains(
       [&tag](const Entry& e) { return e.tagged.tag == tag; });
 }
 
 absl::optional<Executor::TaggedOperation> ExecutorStd::PopFromSchedule() {
-  auto removed =
-      schedule_.RemoveIf([](const Entry& e) { return !e.IsImmediate(); });
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto removed = delayed_.PopEarliest();
   if (!removed.has_value()) {
     return {};
   }
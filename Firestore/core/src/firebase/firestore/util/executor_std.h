@@ -20,11 +20,15 @@
 #include <algorithm>
 #include <atomic>
 #include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <deque>
+#include <limits>
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -205,6 +209,314 @@ class Schedule {
   Container scheduled_;
 };
 
+// A queue that any number of threads can push to without locking, while only
+// a single thread at a time may pop from it. Callers are responsible for
+// serializing calls to `Pop` and `empty`.
+//
+// This is Dmitry Vyukov's MPSC queue: a push atomically swaps in the
+// new tail and then links the previous tail to it. Between these two steps the
+// entry is not yet reachable, so `Pop` may briefly fail even though `empty`
+// returns false.
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(new Node()) {
+    tail_ = head_;
+  }
+
+  ~MpscQueue() {
+    T value;
+    while (Pop(&value)) {
+    }
+    delete head_;
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  void Push(T value) {
+    Node* node = new Node(std::move(value));
+    Node* prev = tail_.exchange(node);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  // If an entry is available, moves it into `value` and returns true.
+  bool Pop(T* value) {
+    Node* next = head_->next.load(std::memory_order_acquire);
+    if (!next) return false;
+
+    // `next` becomes the new stub node, so only its value is taken.
+    *value = std::move(next->value);
+    delete head_;
+    head_ = next;
+    return true;
+  }
+
+  // Returns false if any push has started, even if it hasn't completed yet.
+  bool empty() const {
+    return tail_.load() == head_;
+  }
+
+ private:
+  struct Node {
+    Node() = default;
+    explicit Node(T v) : value(std::move(v)) {
+    }
+
+    std::atomic<Node*> next{nullptr};
+    T value;
+  };
+
+  // Owned by the consumer; always points to a stub node whose value has
+  // already been consumed.
+  Node* head_;
+  std::atomic<Node*> tail_;
+};
+
+// Holds entries scheduled for a time in the future, with constant-time
+// insertion and cancellation.
+//
+// Entries are kept in a hierarchy of wheels by how far in the future they are
+// due: the first level has one slot per millisecond for the next 64
+// milliseconds, the next one slot per 64 milliseconds, and so on. As time
+// advances, entries cascade down the levels until they expire from the first
+// one. Entries due at the same time expire in the order they were added.
+//
+// `TimerWheel` is not thread-safe.
+template <typename T, typename Id>
+class TimerWheel {
+ public:
+  using Duration = std::chrono::milliseconds;
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = std::chrono::time_point<Clock, Duration>;
+
+  // Adds `value` under the unique `id`, to expire at `due`, which may be in
+  // the past. `now` is the current time.
+  void Push(Id id, T value, TimePoint due, TimePoint now) {
+    if (entries_.empty() && ready_.empty()) {
+      // Nothing is pending, so there is no need to step through the time that
+      // has passed since the wheel was last advanced.
+      current_tick_ = now.time_since_epoch().count();
+    }
+
+    int64_t tick = due.time_since_epoch().count();
+    entries_.emplace(id, Entry{std::move(value), tick, next_sequence_++});
+    if (tick < current_tick_) {
+      InsertReady(id);
+    } else {
+      Place(id, tick);
+    }
+  }
+
+  // Removes the entry with the given `id`, if it hasn't expired yet.
+  absl::optional<T> Remove(Id id) {
+    auto found = entries_.find(id);
+    if (found == entries_.end()) return {};
+
+    // The id is left behind in its slot, and skipped once the slot is
+    // processed.
+    absl::optional<T> value = std::move(found->second.value);
+    entries_.erase(found);
+    return value;
+  }
+
+  // Advances the wheel to `now` and removes and returns the entry that has
+  // been due the longest, if any.
+  absl::optional<T> PopDue(TimePoint now) {
+    Advance(now.time_since_epoch().count());
+    while (!ready_.empty()) {
+      Id id = ready_.front();
+      ready_.pop_front();
+      absl::optional<T> removed = Remove(id);
+      if (removed) return removed;
+    }
+    return {};
+  }
+
+  // Returns the earliest time at which an entry might become due, or nothing
+  // if the wheel is empty. The time may be early, in which case the wheel just
+  // needs to be advanced again.
+  absl::optional<TimePoint> NextDue() const {
+    if (entries_.empty()) return {};
+    if (!ready_.empty()) return ToTimePoint(current_tick_);
+
+    return ToTimePoint(NextOccupiedTick());
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  bool empty() const {
+    return entries_.empty();
+  }
+
+  // Checks whether the wheel contains an entry satisfying the given predicate.
+  template <typename Pred>
+  bool Contains(const Pred pred) const {
+    return std::any_of(entries_.begin(), entries_.end(),
+                       [&pred](const std::pair<const Id, Entry>& entry) {
+                         return pred(entry.second.value);
+                       });
+  }
+
+  // Removes and returns the entry that is due first, regardless of whether it
+  // is due yet. This takes linear time.
+  absl::optional<T> PopEarliest() {
+    auto earliest = entries_.end();
+    for (auto iter = entries_.begin(); iter != entries_.end(); ++iter) {
+      if (earliest == entries_.end() ||
+          Before(iter->second, earliest->second)) {
+        earliest = iter;
+      }
+    }
+    if (earliest == entries_.end()) return {};
+
+    return Remove(earliest->first);
+  }
+
+ private:
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr int64_t kSlotMask = kSlots - 1;
+  // Covers delays of up to 2^36 milliseconds (a little over two years); later
+  // entries wait in the last level until they come within range.
+  static constexpr int kLevels = 6;
+
+  struct Entry {
+    T value;
+    int64_t tick;
+    uint64_t sequence;
+  };
+
+  static bool Before(const Entry& lhs, const Entry& rhs) {
+    return lhs.tick < rhs.tick ||
+           (lhs.tick == rhs.tick && lhs.sequence < rhs.sequence);
+  }
+
+  static TimePoint ToTimePoint(int64_t tick) {
+    return TimePoint{Duration{tick}};
+  }
+
+  // Puts the entry with `id` in the slot covering `tick`, which must not be
+  // before `current_tick_`.
+  void Place(Id id, int64_t tick) {
+    int64_t delta = tick - current_tick_;
+    for (int level = 0; level < kLevels; ++level) {
+      int shift = level * kSlotBits;
+      if (delta < (int64_t{1} << (shift + kSlotBits)) || level == kLevels - 1) {
+        int64_t limit = current_tick_ + (int64_t{1} << (shift + kSlotBits)) - 1;
+        int64_t slot_tick = std::min(tick, limit);
+        slots_[level][(slot_tick >> shift) & kSlotMask].push_back(id);
+        return;
+      }
+    }
+  }
+
+  // Returns the first tick, at or after `current_tick_`, at which a non-empty
+  // slot is processed: either a slot of the lowest level expires or a slot of
+  // a higher level cascades. Returns the maximum tick if every slot is empty.
+  int64_t NextOccupiedTick() const {
+    int64_t next = std::numeric_limits<int64_t>::max();
+    for (int level = 0; level < kLevels; ++level) {
+      int shift = level * kSlotBits;
+      int64_t block = current_tick_ >> shift;
+      bool at_boundary = (current_tick_ & ((int64_t{1} << shift) - 1)) == 0;
+
+      // Each level cascades no earlier than the start of its next block, and
+      // higher levels no earlier than that, so stop once a slot is found
+      // before then.
+      int64_t earliest = at_boundary ? current_tick_ : (block + 1) << shift;
+      if (earliest >= next) break;
+
+      for (int offset = 0; offset < kSlots; ++offset) {
+        if (slots_[level][(block + offset) & kSlotMask].empty()) continue;
+
+        // The current slot of a higher level cascades now if the current tick
+        // starts its block, and otherwise holds entries that are a full
+        // revolution away, so later slots may still come first.
+        if (offset == 0 && !at_boundary) {
+          next = std::min(next, (block + kSlots) << shift);
+          continue;
+        }
+        next = std::min(next, (block + offset) << shift);
+        break;
+      }
+    }
+    return next;
+  }
+
+  // Processes every tick up to and including `now`, skipping directly over
+  // ticks at which every slot to be processed is empty.
+  void Advance(int64_t now) {
+    while (current_tick_ <= now) {
+      if (entries_.empty()) {
+        // Only cancelled ids remain in the slots, and those are skipped
+        // wherever they end up.
+        current_tick_ = now + 1;
+        return;
+      }
+
+      int64_t next = NextOccupiedTick();
+      if (next > now) {
+        current_tick_ = now + 1;
+        return;
+      }
+      current_tick_ = next;
+
+      // Cascade entries from higher levels whenever the lower level wraps
+      // around.
+      for (int level = 1; level < kLevels; ++level) {
+        int shift = level * kSlotBits;
+        if ((current_tick_ & ((int64_t{1} << shift) - 1)) != 0) break;
+        Cascade(level, (current_tick_ >> shift) & kSlotMask);
+      }
+
+      std::vector<Id>& slot = slots_[0][current_tick_ & kSlotMask];
+      if (!slot.empty()) {
+        std::vector<Id> expired;
+        for (Id id : slot) {
+          if (entries_.count(id)) expired.push_back(id);
+        }
+        slot.clear();
+
+        std::sort(expired.begin(), expired.end(), [this](Id lhs, Id rhs) {
+          return entries_.at(lhs).sequence < entries_.at(rhs).sequence;
+        });
+        ready_.insert(ready_.end(), expired.begin(), expired.end());
+      }
+      ++current_tick_;
+    }
+  }
+
+  void Cascade(int level, int64_t index) {
+    std::vector<Id> slot;
+    slot.swap(slots_[level][index]);
+    for (Id id : slot) {
+      auto found = entries_.find(id);
+      if (found == entries_.end()) continue;
+      Place(id, found->second.tick);
+    }
+  }
+
+  void InsertReady(Id id) {
+    const Entry& entry = entries_.at(id);
+    auto pos = std::find_if(ready_.begin(), ready_.end(), [&](Id other) {
+      auto found = entries_.find(other);
+      return found != entries_.end() && Before(entry, found->second);
+    });
+    ready_.insert(pos, id);
+  }
+
+  std::unordered_map<Id, Entry> entries_;
+  std::vector<Id> slots_[kLevels][kSlots];
+  // Expired entries, in the order they became due.
+  std::deque<Id> ready_;
+  // The next tick to process; every slot before it has been processed.
+  int64_t current_tick_ = 0;
+  uint64_t next_sequence_ = 0;
+};
+
 }  // namespace async
 
 // A serial queue that executes provided operations on a dedicated background
@@ -228,6 +540,9 @@ class ExecutorStd : public Executor {
   absl::optional<TaggedOperation> PopFromSchedule() override;
 
   using TimePoint = async::Schedule<Operation>::TimePoint;
+  static_assert(
+      std::is_same<TimePoint, async::TimerWheel<int, int>::TimePoint>::value,
+      "Schedule and TimerWheel must measure time the same way");
   // To allow canceling operations, each scheduled operation is assigned
   // a monotonically increasing identifier.
   using Id = unsigned int;
@@ -236,21 +551,16 @@ class ExecutorStd : public Executor {
   // Otherwise, this function is a no-op.
   void TryCancel(Id operation_id);
 
-  Id PushOnSchedule(Operation&& operation, TimePoint when, Tag tag = -1);
+  Id PushOnSchedule(Operation&& operation,
+                    TimePoint when,
+                    TimePoint now,
+                    Tag tag = -1);
+  void PushImmediate(Operation&& operation);
 
   void PollingThread();
   void UnblockQueue();
   Id NextId();
 
-  // As a convention, assign the epoch time to all operations scheduled for
-  // immediate execution. Note that it means that an immediate operation is
-  // always scheduled before any delayed operation, even in the corner case when
-  // the immediate operation was scheduled after a delayed operation was due
-  // (but hasn't yet run).
-  static TimePoint Immediate() {
-    return TimePoint{};
-  }
-
   struct Entry {
     Entry() {
     }
@@ -260,17 +570,34 @@ class ExecutorStd : public Executor {
         : tagged{tag, std::move(operation)}, id{id} {
     }
 
-    bool IsImmediate() const {
-      return tagged.tag == kNoTag;
-    }
-
     static constexpr Tag kNoTag = -1;
     TaggedOperation tagged;
     Id id = 0;
   };
-  // Operations scheduled for immediate execution are also put on the schedule
-  // (with due time set to `Immediate`).
-  async::Schedule<Entry> schedule_;
+  // Removes the next operation to run. Immediate operations are always run
+  // before any delayed operation, even in the corner case when the immediate
+  // operation was scheduled after a delayed operation was due (but hasn't yet
+  // run). Returns false if no operation is ready.
+  bool PopNext(Entry* entry);
+
+  // Blocks until an operation might be ready to run.
+  void WaitForWork();
+
+  // Operations scheduled for immediate execution are pushed without taking any
+  // lock. Worker threads take turns popping them under `pop_mutex_`.
+  async::MpscQueue<Entry> immediate_;
+  std::mutex pop_mutex_;
+
+  // Guards `delayed_` and is used with `wake_up_` to put idle worker threads
+  // to sleep.
+  mutable std::mutex mutex_;
+  std::condition_variable wake_up_;
+  async::TimerWheel<Entry, Id> delayed_;
+
+  // The number of worker threads that are about to sleep or are sleeping on
+  // `wake_up_`. Producers of immediate operations only need to take `mutex_`
+  // to wake them when this is nonzero.
+  std::atomic<int> idle_threads_{0};
 
   std::vector<std::thread> worker_thread_pool_;
   // Used to stop the worker thread.
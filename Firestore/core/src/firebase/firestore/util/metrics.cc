@@ -0,0 +1,219 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+int BucketIndex(int64_t value) {
+  int index = 0;
+  while (value > 0 && index < Histogram::kBucketCount - 1) {
+    value >>= 1;
+    ++index;
+  }
+  return index;
+}
+
+// Compare-and-swap loops, since std::atomic has no fetch_min/fetch_max.
+void UpdateMin(std::atomic<int64_t>* min, int64_t value) {
+  int64_t current = min->load(std::memory_order_relaxed);
+  while (value < current &&
+         !min->compare_exchange_weak(current, value,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+void UpdateMax(std::atomic<int64_t>* max, int64_t value) {
+  int64_t current = max->load(std::memory_order_relaxed);
+  while (value > current &&
+         !max->compare_exchange_weak(current, value,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+/** Owns all metrics. Metrics are never removed, so pointers remain valid. */
+class Registry {
+ public:
+  static Registry& Get() {
+    // Intentionally leaked to avoid destruction order issues at exit.
+    static Registry* registry = new Registry();
+    return *registry;
+  }
+
+  Counter* GetCounter(const std::string& name) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    std::unique_ptr<Counter>& counter = counters_[name];
+    if (!counter) counter = absl::make_unique<Counter>();
+    return counter.get();
+  }
+
+  Histogram* GetHistogram(const std::string& name) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    std::unique_ptr<Histogram>& histogram = histograms_[name];
+    if (!histogram) histogram = absl::make_unique<Histogram>();
+    return histogram.get();
+  }
+
+  MetricsSnapshot Snapshot() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    MetricsSnapshot result;
+    for (const auto& entry : counters_) {
+      result.counters[entry.first] = entry.second->value();
+    }
+    for (const auto& entry : histograms_) {
+      result.histograms[entry.first] = entry.second->Snapshot();
+    }
+    return result;
+  }
+
+  void Reset() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (const auto& entry : counters_) {
+      entry.second->Reset();
+    }
+    for (const auto& entry : histograms_) {
+      entry.second->Reset();
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Counter>> counters_;
+  std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+};
+
+}  // namespace
+
+// MARK: - HistogramSnapshot
+
+int64_t HistogramSnapshot::Percentile(double percentile) const {
+  if (count == 0) return 0;
+
+  // The rank of the requested value, counting from 1.
+  auto rank = static_cast<int64_t>(percentile / 100 * (count - 1)) + 1;
+  int64_t seen = 0;
+  for (size_t i = 0; i != buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      // Report the upper bound of the bucket, but never more than the largest
+      // recorded value.
+      int64_t bound = i == 0 ? 0 : (int64_t{1} << i) - 1;
+      return std::min(bound, max);
+    }
+  }
+  return max;
+}
+
+double HistogramSnapshot::Mean() const {
+  return count == 0 ? 0 : static_cast<double>(sum) / count;
+}
+
+// MARK: - Histogram
+
+constexpr int Histogram::kBucketCount;
+
+void Histogram::Record(int64_t value) {
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  UpdateMin(&min_, value);
+  UpdateMax(&max_, value);
+  buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+  // Values recorded concurrently with the snapshot may be partially included.
+  HistogramSnapshot result;
+  result.count = count_.load(std::memory_order_relaxed);
+  result.sum = sum_.load(std::memory_order_relaxed);
+  if (result.count > 0) {
+    result.min = min_.load(std::memory_order_relaxed);
+    result.max = max_.load(std::memory_order_relaxed);
+  }
+  result.buckets.reserve(kBucketCount);
+  for (const std::atomic<int64_t>& bucket : buckets_) {
+    result.buckets.push_back(bucket.load(std::memory_order_relaxed));
+  }
+  return result;
+}
+
+void Histogram::Reset() {
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  min_.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+  max_.store(std::numeric_limits<int64_t>::min(), std::memory_order_relaxed);
+  for (std::atomic<int64_t>& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+// MARK: - MetricsSnapshot
+
+std::string MetricsSnapshot::ToString() const {
+  std::string result;
+  for (const auto& entry : counters) {
+    absl::StrAppend(&result, entry.first, ": ", entry.second, "\n");
+  }
+  for (const auto& entry : histograms) {
+    const HistogramSnapshot& histogram = entry.second;
+    absl::StrAppend(&result, entry.first, ": count=", histogram.count,
+                    " mean=", histogram.Mean(), " min=", histogram.min,
+                    " p50=", histogram.Percentile(50),
+                    " p90=", histogram.Percentile(90),
+                    " p99=", histogram.Percentile(99), " max=", histogram.max,
+                    "\n");
+  }
+  return result;
+}
+
+// MARK: - Metrics
+
+std::atomic<bool> Metrics::enabled_{false};
+
+void Metrics::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+Counter* Metrics::GetCounter(const std::string& name) {
+  return Registry::Get().GetCounter(name);
+}
+
+Histogram* Metrics::GetHistogram(const std::string& name) {
+  return Registry::Get().GetHistogram(name);
+}
+
+MetricsSnapshot Metrics::Snapshot() {
+  return Registry::Get().Snapshot();
+}
+
+void Metrics::Reset() {
+  Registry::Get().Reset();
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_METRICS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/** A monotonically increasing count of events. */
+class Counter {
+ public:
+  void Add(int64_t delta) {
+    value_.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  int64_t value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+  void Reset() {
+    value_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+/** A point-in-time copy of the values recorded by a `Histogram`. */
+struct HistogramSnapshot {
+  /**
+   * Returns an upper bound of the given percentile (between 0 and 100) of the
+   * recorded values, accurate to within a factor of two.
+   */
+  int64_t Percentile(double percentile) const;
+
+  double Mean() const;
+
+  int64_t count = 0;
+  int64_t sum = 0;
+  int64_t min = 0;
+  int64_t max = 0;
+
+  /**
+   * The number of values recorded in each bucket. The first bucket holds
+   * values less than 1, and bucket `i` values in `[2^(i-1), 2^i)`. The last
+   * bucket also holds all larger values.
+   */
+  std::vector<int64_t> buckets;
+};
+
+/**
+ * A distribution of non-negative values, such as latencies or sizes, kept in
+ * exponentially sized buckets. Recording a value takes a handful of relaxed
+ * atomic operations and never allocates.
+ */
+class Histogram {
+ public:
+  static constexpr int kBucketCount = 40;
+
+  void Record(int64_t value);
+
+  HistogramSnapshot Snapshot() const;
+
+  void Reset();
+
+ private:
+  std::atomic<int64_t> count_{0};
+  std::atomic<int64_t> sum_{0};
+  std::atomic<int64_t> min_{std::numeric_limits<int64_t>::max()};
+  std::atomic<int64_t> max_{std::numeric_limits<int64_t>::min()};
+  std::atomic<int64_t> buckets_[kBucketCount] = {};
+};
+
+/** A point-in-time copy of all registered metrics, keyed by name. */
+struct MetricsSnapshot {
+  /** Returns a human-readable summary, one metric per line. */
+  std::string ToString() const;
+
+  std::map<std::string, int64_t> counters;
+  std::map<std::string, HistogramSnapshot> histograms;
+};
+
+/**
+ * The process-wide registry of metrics.
+ *
+ * Metrics are created on first use and live until the process exits, so
+ * pointers to them can be cached. Recording is disabled by default; while
+ * disabled, the `METRICS_*` macros cost a single relaxed atomic load.
+ */
+class Metrics {
+ public:
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  static void SetEnabled(bool enabled);
+
+  /** Returns the counter with the given name, creating it if necessary. */
+  static Counter* GetCounter(const std::string& name);
+
+  /** Returns the histogram with the given name, creating it if necessary. */
+  static Histogram* GetHistogram(const std::string& name);
+
+  static MetricsSnapshot Snapshot();
+
+  /** Resets the values of all metrics, without unregistering them. */
+  static void Reset();
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+/**
+ * A reference to a named metric that is looked up in the registry only once.
+ * Instances are meant to be function-local statics; their constructor is
+ * `constexpr`, so they are initialized without any runtime cost.
+ */
+template <typename M>
+class MetricRef {
+ public:
+  constexpr explicit MetricRef(const char* name)
+      : name_(name), metric_(nullptr) {
+  }
+
+  const char* name() const {
+    return name_;
+  }
+
+  M* get() {
+    M* metric = metric_.load(std::memory_order_acquire);
+    if (!metric) {
+      metric = Lookup(name_);
+      metric_.store(metric, std::memory_order_release);
+    }
+    return metric;
+  }
+
+ private:
+  static M* Lookup(const char* name);
+
+  const char* name_;
+  std::atomic<M*> metric_;
+};
+
+template <>
+inline Counter* MetricRef<Counter>::Lookup(const char* name) {
+  return Metrics::GetCounter(name);
+}
+
+template <>
+inline Histogram* MetricRef<Histogram>::Lookup(const char* name) {
+  return Metrics::GetHistogram(name);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+// Adds `delta` to the counter named `name` if metrics are enabled. `name` must
+// be a string literal, and `delta` is not evaluated if metrics are disabled.
+#define METRICS_COUNTER_ADD(name, delta)                         \
+  do {                                                           \
+    namespace _util = firebase::firestore::util;                 \
+    if (_util::Metrics::enabled()) {                             \
+      static _util::MetricRef<_util::Counter> _metric_ref{name}; \
+      _metric_ref.get()->Add(delta);                             \
+    }                                                            \
+  } while (0)
+
+// Records `value` in the histogram named `name` if metrics are enabled.
+// `name` must be a string literal, and `value` is not evaluated if metrics are
+// disabled.
+#define METRICS_HISTOGRAM_RECORD(name, value)                      \
+  do {                                                             \
+    namespace _util = firebase::firestore::util;                   \
+    if (_util::Metrics::enabled()) {                               \
+      static _util::MetricRef<_util::Histogram> _metric_ref{name}; \
+      _metric_ref.get()->Record(value);                            \
+    }                                                              \
+  } while (0)
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_METRICS_H_
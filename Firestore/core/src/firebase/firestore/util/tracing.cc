@@ -0,0 +1,169 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
+
+#include <map>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+namespace chr = std::chrono;
+
+struct TraceEvent {
+  const char* name;
+  // 'X' for complete spans, 'C' for counters.
+  char phase;
+  int thread;
+  int64_t timestamp_micros;
+  // The duration of spans, or the value of counters.
+  int64_t value;
+};
+
+class TraceBuffer {
+ public:
+  static TraceBuffer& Get() {
+    // Intentionally leaked to avoid destruction order issues at exit.
+    static TraceBuffer* buffer = new TraceBuffer();
+    return *buffer;
+  }
+
+  void Reset(size_t max_events) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    events_.clear();
+    threads_.clear();
+    dropped_events_ = 0;
+    max_events_ = max_events;
+    origin_ = Tracing::Clock::now();
+  }
+
+  void Add(const char* name,
+           char phase,
+           Tracing::Clock::time_point time,
+           int64_t value) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (events_.size() >= max_events_) {
+      ++dropped_events_;
+      return;
+    }
+
+    auto inserted = threads_.emplace(std::this_thread::get_id(),
+                                     static_cast<int>(threads_.size()) + 1);
+    int64_t timestamp =
+        chr::duration_cast<chr::microseconds>(time - origin_).count();
+    events_.push_back(
+        TraceEvent{name, phase, inserted.first->second, timestamp, value});
+  }
+
+  std::string ExportChromeTrace() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    std::string result = "{\"traceEvents\":[";
+    for (size_t i = 0; i != events_.size(); ++i) {
+      const TraceEvent& event = events_[i];
+      if (i != 0) result += ",";
+
+      absl::StrAppend(&result, "\n{\"name\":\"", Escape(event.name),
+                      "\",\"cat\":\"firestore\",\"ph\":\"",
+                      absl::string_view{&event.phase, 1},
+                      "\",\"pid\":1,\"tid\":", event.thread,
+                      ",\"ts\":", event.timestamp_micros);
+      if (event.phase == 'X') {
+        absl::StrAppend(&result, ",\"dur\":", event.value, "}");
+      } else {
+        absl::StrAppend(&result, ",\"args\":{\"value\":", event.value, "}}");
+      }
+    }
+    absl::StrAppend(&result, "\n],\"displayTimeUnit\":\"ms\",",
+                    "\"otherData\":{\"dropped_events\":", dropped_events_,
+                    "}}\n");
+    return result;
+  }
+
+ private:
+  static std::string Escape(const char* name) {
+    std::string result;
+    for (const char* c = name; *c; ++c) {
+      if (*c == '"' || *c == '\\') result += '\\';
+      result += *c;
+    }
+    return result;
+  }
+
+  std::mutex mutex_;
+  std::vector<TraceEvent> events_;
+  std::map<std::thread::id, int> threads_;
+  size_t max_events_ = 0;
+  int64_t dropped_events_ = 0;
+  Tracing::Clock::time_point origin_;
+};
+
+}  // namespace
+
+// MARK: - Tracing
+
+constexpr size_t Tracing::kDefaultMaxEvents;
+
+std::atomic<bool> Tracing::enabled_{false};
+
+void Tracing::Start(size_t max_events) {
+  TraceBuffer::Get().Reset(max_events);
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracing::Stop() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+std::string Tracing::ExportChromeTrace() {
+  return TraceBuffer::Get().ExportChromeTrace();
+}
+
+void Tracing::RecordSpan(const char* name,
+                         Clock::time_point start,
+                         Clock::time_point end) {
+  int64_t duration =
+      chr::duration_cast<chr::microseconds>(end - start).count();
+  TraceBuffer::Get().Add(name, 'X', start, duration);
+}
+
+void Tracing::RecordCounter(const char* name, int64_t value) {
+  TraceBuffer::Get().Add(name, 'C', Clock::now(), value);
+}
+
+// MARK: - ScopedSpan
+
+void ScopedSpan::Finish() {
+  Tracing::Clock::time_point end = Tracing::Clock::now();
+  if (Metrics::enabled()) {
+    site_->get()->Record(
+        chr::duration_cast<chr::microseconds>(end - start_).count());
+  }
+  if (Tracing::enabled()) {
+    Tracing::RecordSpan(site_->name(), start_, end);
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACING_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACING_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * Records trace events in memory for offline analysis, for example in
+ * `chrome://tracing`.
+ *
+ * Tracing is disabled by default; while disabled, `TRACE_SPAN` and
+ * `TRACE_COUNTER` cost a relaxed atomic load.
+ */
+class Tracing {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t kDefaultMaxEvents = 100000;
+
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Discards any previously recorded events and starts recording. Events
+   * beyond the first `max_events` are dropped.
+   */
+  static void Start(size_t max_events = kDefaultMaxEvents);
+
+  /** Stops recording, keeping the events recorded so far. */
+  static void Stop();
+
+  /**
+   * Returns the recorded events as a JSON object in the Chrome trace event
+   * format, with timestamps in microseconds since recording started.
+   */
+  static std::string ExportChromeTrace();
+
+  /** Records a span named `name`. `name` must outlive the recorded events. */
+  static void RecordSpan(const char* name,
+                         Clock::time_point start,
+                         Clock::time_point end);
+
+  /** Records a sample of a value named `name` over time. */
+  static void RecordCounter(const char* name, int64_t value);
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+/**
+ * Measures the time between its construction and destruction, recording it
+ * as a trace span if tracing is enabled, and in microseconds in the histogram
+ * referenced by `site` if metrics are enabled.
+ *
+ * Use the `TRACE_SPAN` macro rather than creating instances directly.
+ */
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(MetricRef<Histogram>* site) {
+    if (Metrics::enabled() || Tracing::enabled()) {
+      site_ = site;
+      start_ = Tracing::Clock::now();
+    }
+  }
+
+  ~ScopedSpan() {
+    if (site_) Finish();
+  }
+
+  ScopedSpan(const ScopedSpan&) = delete;
+  ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+ private:
+  void Finish();
+
+  MetricRef<Histogram>* site_ = nullptr;
+  Tracing::Clock::time_point start_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#define FIRESTORE_TRACE_CONCAT_IMPL(a, b) a##b
+#define FIRESTORE_TRACE_CONCAT(a, b) FIRESTORE_TRACE_CONCAT_IMPL(a, b)
+
+// Measures the rest of the enclosing scope as a span named `name`, which must
+// be a string literal. See `ScopedSpan`.
+#define TRACE_SPAN(name)                                        \
+  static firebase::firestore::util::MetricRef<                  \
+      firebase::firestore::util::Histogram>                     \
+      FIRESTORE_TRACE_CONCAT(_trace_site_, __LINE__){name};     \
+  firebase::firestore::util::ScopedSpan FIRESTORE_TRACE_CONCAT( \
+      _trace_span_, __LINE__) {                                 \
+    &FIRESTORE_TRACE_CONCAT(_trace_site_, __LINE__)             \
+  }
+
+// Records the current `value` of a quantity named `name`, such as a queue
+// depth, as a trace counter if tracing is enabled and in the histogram of the
+// same name if metrics are enabled. `name` must be a string literal, and
+// `value` is not evaluated if both are disabled.
+#define TRACE_COUNTER(name, value)                                \
+  do {                                                            \
+    namespace _util = firebase::firestore::util;                  \
+    if (_util::Tracing::enabled() || _util::Metrics::enabled()) { \
+      int64_t _value = (value);                                   \
+      if (_util::Tracing::enabled()) {                            \
+        _util::Tracing::RecordCounter(name, _value);              \
+      }                                                           \
+      METRICS_HISTOGRAM_RECORD(name, _value);                     \
+    }                                                             \
+  } while (0)
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACING_H_
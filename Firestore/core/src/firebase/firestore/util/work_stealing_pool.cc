@@ -0,0 +1,196 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/work_stealing_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <limits>
+#include <mutex>  // NOLINT(build/c++11)
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+// A thread takes this fraction of its remaining range at a time, so chunks
+// start out large and shrink as the range empties, leaving work to steal near
+// the end.
+constexpr uint64_t kChunkDivisor = 8;
+
+// A half-open range of indices, packed into a single word so that it can be
+// updated atomically: the begin in the lower half and the end in the upper.
+uint64_t Pack(uint64_t begin, uint64_t end) {
+  return (end << 32) | begin;
+}
+
+uint64_t Begin(uint64_t range) {
+  return range & 0xFFFFFFFFu;
+}
+
+uint64_t End(uint64_t range) {
+  return range >> 32;
+}
+
+}  // namespace
+
+/**
+ * The state of a single call to `RunRanges`, shared by all threads working on
+ * it.
+ */
+class WorkStealingPool::Loop {
+ public:
+  Loop(size_t count, int workers, const RangeBody& body)
+      : ranges_(absl::make_unique<Range[]>(workers)),
+        workers_(workers),
+        body_(body),
+        pending_helpers_(workers - 1) {
+    for (int i = 0; i < workers; ++i) {
+      uint64_t begin = count * i / workers;
+      uint64_t end = count * (i + 1) / workers;
+      ranges_[i].bounds.store(Pack(begin, end), std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Runs chunks of the range owned by `worker`, and then of ranges stolen from
+   * other workers, until no work is left to take.
+   */
+  void Work(int worker) {
+    do {
+      uint64_t begin = 0;
+      uint64_t end = 0;
+      while (TakeChunk(worker, &begin, &end)) {
+        body_(static_cast<size_t>(begin), static_cast<size_t>(end));
+      }
+    } while (Steal(worker));
+  }
+
+  /** Called by each worker other than the calling thread once it's done. */
+  void FinishHelper() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    --pending_helpers_;
+    if (pending_helpers_ == 0) {
+      done_.notify_all();
+    }
+  }
+
+  void AwaitHelpers() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    done_.wait(lock, [this] { return pending_helpers_ == 0; });
+  }
+
+ private:
+  struct Range {
+    std::atomic<uint64_t> bounds{0};
+    // Keep ranges of different workers on separate cache lines.
+    char padding[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  bool TakeChunk(int worker, uint64_t* begin, uint64_t* end) {
+    std::atomic<uint64_t>& bounds = ranges_[worker].bounds;
+    uint64_t range = bounds.load();
+    while (true) {
+      uint64_t first = Begin(range);
+      uint64_t last = End(range);
+      if (first >= last) return false;
+
+      uint64_t chunk = std::max<uint64_t>(1, (last - first) / kChunkDivisor);
+      if (bounds.compare_exchange_weak(range, Pack(first + chunk, last))) {
+        *begin = first;
+        *end = first + chunk;
+        return true;
+      }
+    }
+  }
+
+  /**
+   * Moves the back half of the remaining range of some other worker into the
+   * range of `worker`. Returns false if all other ranges are empty.
+   */
+  bool Steal(int worker) {
+    for (int offset = 1; offset < workers_; ++offset) {
+      std::atomic<uint64_t>& victim =
+          ranges_[(worker + offset) % workers_].bounds;
+      uint64_t range = victim.load();
+      while (Begin(range) < End(range)) {
+        uint64_t first = Begin(range);
+        uint64_t last = End(range);
+        uint64_t middle = first + (last - first) / 2;
+        if (victim.compare_exchange_weak(range, Pack(first, middle))) {
+          // Other thieves only ever observe this range as empty until now, so
+          // it can simply be overwritten.
+          ranges_[worker].bounds.store(Pack(middle, last));
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  std::unique_ptr<Range[]> ranges_;
+  const int workers_;
+  const RangeBody& body_;
+
+  std::mutex mutex_;
+  std::condition_variable done_;
+  int pending_helpers_ = 0;
+};
+
+WorkStealingPool::WorkStealingPool(const char* label, int threads)
+    : threads_(threads) {
+  HARD_ASSERT(threads > 0);
+  // The calling thread takes part in every loop.
+  executor_ = Executor::CreateConcurrent(label, std::max(1, threads - 1));
+}
+
+// Out of line because of unique_ptrs to incomplete types.
+WorkStealingPool::~WorkStealingPool() = default;
+
+void WorkStealingPool::RunRanges(size_t count, const RangeBody& body) {
+  HARD_ASSERT(count <= std::numeric_limits<uint32_t>::max(),
+              "Too many items to run in parallel: %s", count);
+
+  int workers = static_cast<int>(
+      std::min(count, static_cast<size_t>(threads_)));
+  if (workers <= 1) {
+    if (count > 0) body(0, count);
+    return;
+  }
+
+  // Schedule one task per helper thread, rather than one per item.
+  Loop loop{count, workers, body};
+  for (int worker = 1; worker < workers; ++worker) {
+    executor_->Execute([&loop, worker] {
+      loop.Work(worker);
+      loop.FinishHelper();
+    });
+  }
+
+  loop.Work(0);
+  loop.AwaitHelpers();
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WORK_STEALING_POOL_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WORK_STEALING_POOL_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+class Executor;
+
+/**
+ * Runs loops over index ranges in parallel on a concurrent Executor.
+ *
+ * Unlike `BackgroundQueue`, which schedules one task per item, each loop is
+ * split into one contiguous range per thread. Threads consume their own range
+ * in chunks that shrink as the range empties, and threads that run out of
+ * work steal half of the remaining range of another thread, so that uneven
+ * items still keep all threads busy while the number of scheduled tasks and
+ * synchronization points stays independent of the number of items.
+ *
+ * The calling thread participates in running the loop. Loops must not be
+ * started from within the body of another loop on the same pool.
+ *
+ * This class is thread-safe.
+ */
+class WorkStealingPool {
+ public:
+  /**
+   * Creates a pool that runs loops on up to `threads` threads, including the
+   * calling thread, using a new concurrent Executor labeled `label`.
+   */
+  WorkStealingPool(const char* label, int threads);
+  ~WorkStealingPool();
+
+  int threads() const {
+    return threads_;
+  }
+
+  /**
+   * Calls `body(i)` for each `i` in `[0, count)`, in parallel, and returns
+   * once all calls have completed. Calls for neighboring indices are likely,
+   * but not guaranteed, to be made from the same thread in increasing order.
+   */
+  template <typename F>
+  void ParallelFor(size_t count, const F& body) {
+    RunRanges(count, [&body](size_t begin, size_t end) {
+      for (size_t i = begin; i != end; ++i) {
+        body(i);
+      }
+    });
+  }
+
+  /**
+   * Returns the results of `fn(i)` for each `i` in `[0, count)`, computed in
+   * parallel. `T` must be default-constructible and move-assignable.
+   */
+  template <typename T, typename F>
+  std::vector<T> ParallelMap(size_t count, const F& fn) {
+    std::vector<T> results(count);
+    T* data = results.data();
+    RunRanges(count, [data, &fn](size_t begin, size_t end) {
+      for (size_t i = begin; i != end; ++i) {
+        data[i] = fn(i);
+      }
+    });
+    return results;
+  }
+
+ private:
+  class Loop;
+
+  using RangeBody = std::function<void(size_t begin, size_t end)>;
+
+  /**
+   * Calls `body` with disjoint subranges that together cover `[0, count)` and
+   * waits for all calls to complete.
+   */
+  void RunRanges(size_t count, const RangeBody& body);
+
+  std::unique_ptr<Executor> executor_;
+  int threads_ = 1;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WORK_STEALING_POOL_H_
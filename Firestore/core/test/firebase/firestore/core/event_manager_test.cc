@@ -36,12 +36,16 @@ namespace firestore {
 namespace core {
 namespace {
 
+using model::Document;
 using model::DocumentKeySet;
 using model::DocumentSet;
+using model::DocumentState;
 using model::OnlineState;
 using testing::_;
 using testing::ElementsAre;
 using testing::StrictMock;
+using testutil::Doc;
+using testutil::Map;
 using testutil::Query;
 using util::StatusOr;
 using util::StatusOrCallback;
@@ -142,6 +146,131 @@ TEST(EventManagerTest, NotifiesListenersInTheRightOrder) {
   ASSERT_THAT(event_order, ElementsAre("listener1", "listener3", "listener2"));
 }
 
+TEST(EventManagerTest, SharesFilteredSnapshotsBetweenListeners) {
+  core::Query query = Query("rooms");
+  std::vector<ViewSnapshot> events1;
+  std::vector<ViewSnapshot> events2;
+  std::vector<ViewSnapshot> metadata_events;
+
+  auto listener1 = QueryListener::Create(query, [&](StatusOr<ViewSnapshot> s) {
+    events1.push_back(s.ValueOrDie());
+  });
+  auto listener2 = QueryListener::Create(query, [&](StatusOr<ViewSnapshot> s) {
+    events2.push_back(s.ValueOrDie());
+  });
+  auto metadata_listener = QueryListener::Create(
+      query, ListenOptions::FromIncludeMetadataChanges(true),
+      [&](StatusOr<ViewSnapshot> s) {
+        metadata_events.push_back(s.ValueOrDie());
+      });
+
+  MockEventSource mock_event_source;
+  EventManager event_manager(&mock_event_source);
+  event_manager.AddQueryListener(listener1);
+  event_manager.AddQueryListener(listener2);
+  event_manager.AddQueryListener(metadata_listener);
+
+  Document doc1 = Doc("rooms/Eros", 1, Map("name", "Eros"));
+  Document doc2 = Doc("rooms/Hades", 2, Map("name", "Hades"));
+  Document doc1_modified = Doc("rooms/Eros", 3, Map("name", "Eros2"));
+  Document doc2_synced = Doc("rooms/Hades", 2, Map("name", "Hades"),
+                             DocumentState::kCommittedMutations);
+
+  DocumentSet empty_docs{query.Comparator()};
+  DocumentSet docs = empty_docs.insert(doc1).insert(doc2);
+  DocumentSet new_docs = docs.insert(doc1_modified).insert(doc2_synced);
+
+  ViewSnapshot initial{query,
+                       docs,
+                       empty_docs,
+                       {{doc1, DocumentViewChange::Type::Added},
+                        {doc2, DocumentViewChange::Type::Added}},
+                       DocumentKeySet{},
+                       /*from_cache=*/false,
+                       /*sync_state_changed=*/true,
+                       /*excludes_metadata_changes=*/false};
+  ViewSnapshot update{query,
+                      new_docs,
+                      docs,
+                      {{doc1_modified, DocumentViewChange::Type::Modified},
+                       {doc2_synced, DocumentViewChange::Type::Metadata}},
+                      DocumentKeySet{},
+                      /*from_cache=*/false,
+                      /*sync_state_changed=*/false,
+                      /*excludes_metadata_changes=*/false};
+  event_manager.OnViewSnapshots({initial, update});
+
+  ASSERT_EQ(2u, events1.size());
+  ASSERT_EQ(2u, events2.size());
+  ASSERT_EQ(2u, metadata_events.size());
+
+  EXPECT_EQ(events1[1], events2[1]);
+  EXPECT_TRUE(events1[1].excludes_metadata_changes());
+  EXPECT_THAT(events1[1].document_changes(),
+              ElementsAre(DocumentViewChange{
+                  doc1_modified, DocumentViewChange::Type::Modified}));
+
+  // Listeners with the same options share the filtered changes.
+  EXPECT_EQ(&events1[1].document_changes(), &events2[1].document_changes());
+
+  EXPECT_EQ(update, metadata_events[1]);
+  EXPECT_EQ(&update.document_changes(),
+            &metadata_events[1].document_changes());
+}
+
+TEST(EventManagerTest, DropsMetadataOnlySnapshotsForDefaultListeners) {
+  core::Query query = Query("rooms");
+  std::vector<ViewSnapshot> events;
+  std::vector<ViewSnapshot> metadata_events;
+
+  auto listener = QueryListener::Create(query, [&](StatusOr<ViewSnapshot> s) {
+    events.push_back(s.ValueOrDie());
+  });
+  auto metadata_listener = QueryListener::Create(
+      query, ListenOptions::FromIncludeMetadataChanges(true),
+      [&](StatusOr<ViewSnapshot> s) {
+        metadata_events.push_back(s.ValueOrDie());
+      });
+
+  MockEventSource mock_event_source;
+  EventManager event_manager(&mock_event_source);
+  event_manager.AddQueryListener(listener);
+  event_manager.AddQueryListener(metadata_listener);
+
+  Document doc = Doc("rooms/Eros", 1, Map("name", "Eros"),
+                     DocumentState::kLocalMutations);
+  Document doc_acknowledged = Doc("rooms/Eros", 1, Map("name", "Eros"),
+                                  DocumentState::kCommittedMutations);
+
+  DocumentSet empty_docs{query.Comparator()};
+  DocumentSet docs = empty_docs.insert(doc);
+  DocumentSet acknowledged_docs = empty_docs.insert(doc_acknowledged);
+
+  ViewSnapshot initial{query,
+                       docs,
+                       empty_docs,
+                       {{doc, DocumentViewChange::Type::Added}},
+                       DocumentKeySet{doc.key()},
+                       /*from_cache=*/false,
+                       /*sync_state_changed=*/true,
+                       /*excludes_metadata_changes=*/false};
+  // The write is acknowledged, which only changes the document's metadata.
+  ViewSnapshot acknowledged{
+      query,
+      acknowledged_docs,
+      docs,
+      {{doc_acknowledged, DocumentViewChange::Type::Metadata}},
+      DocumentKeySet{},
+      /*from_cache=*/false,
+      /*sync_state_changed=*/false,
+      /*excludes_metadata_changes=*/false};
+  event_manager.OnViewSnapshots({initial, acknowledged});
+
+  EXPECT_EQ(1u, events.size());
+  ASSERT_EQ(2u, metadata_events.size());
+  EXPECT_EQ(acknowledged, metadata_events[1]);
+}
+
 TEST(EventManagerTest, WillForwardOnlineStateChanges) {
   core::Query query = Query("foo/bar");
 
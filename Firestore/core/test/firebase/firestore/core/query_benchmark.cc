@@ -0,0 +1,203 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/bound.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::Document;
+
+using testutil::BenchmarkDocuments;
+using testutil::Filter;
+using testutil::OrderBy;
+using testutil::Value;
+
+constexpr int kDocuments = 10000;
+constexpr int kLargeCollection = 100000;
+
+/** Evaluates `query` against every document, as a collection scan does. */
+void MatchDocuments(benchmark::State& state,
+                    const Query& query,
+                    int count = kDocuments) {
+  std::vector<Document> docs = BenchmarkDocuments("docs", count);
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    int matches = 0;
+    for (const Document& doc : docs) {
+      if (query.Matches(doc)) ++matches;
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+/** Like `MatchDocuments`, but evaluates all documents as one batch. */
+void MatchDocumentsInBatch(benchmark::State& state,
+                           const Query& query,
+                           int count = kDocuments) {
+  std::vector<Document> docs = BenchmarkDocuments("docs", count);
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    std::vector<bool> matches = query.MatchesBatch(docs);
+    benchmark::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+/** Returns a query for `percent` percent of `kLargeCollection` documents. */
+Query NumericRangeQuery(int percent) {
+  int lower = kLargeCollection / 10;
+  int upper = lower + kLargeCollection / 100 * percent;
+  return testutil::Query("docs")
+      .AddingFilter(Filter("value", ">=", lower))
+      .AddingFilter(Filter("value", "<", upper));
+}
+
+/** Matches `range(0)` percent of the documents with a single filter. */
+void BM_MatchesWithSelectivity(benchmark::State& state) {
+  int percent = static_cast<int>(state.range(0));
+  MatchDocuments(state,
+                 testutil::Query("docs").AddingFilter(
+                     Filter("bucket", "<", percent)));
+}
+BENCHMARK(BM_MatchesWithSelectivity)->Arg(1)->Arg(10)->Arg(100);
+
+/** Matches about half of the documents with `range(0)` equivalent filters. */
+void BM_MatchesWithFilterCount(benchmark::State& state) {
+  Query query = testutil::Query("docs");
+  for (int i = 0; i < state.range(0); ++i) {
+    query = query.AddingFilter(Filter("bucket", "<", 50 + i));
+  }
+  MatchDocuments(state, query);
+}
+BENCHMARK(BM_MatchesWithFilterCount)->Arg(1)->Arg(2)->Arg(4);
+
+/** Filters on a nested field and a string field. */
+void BM_MatchesNestedAndStringFilters(benchmark::State& state) {
+  MatchDocuments(state, testutil::Query("docs")
+                            .AddingFilter(Filter("meta.likes", ">=", 500))
+                            .AddingFilter(Filter("author", "==", "user7")));
+}
+BENCHMARK(BM_MatchesNestedAndStringFilters);
+
+/** Filters on array membership. */
+void BM_MatchesArrayContains(benchmark::State& state) {
+  MatchDocuments(state, testutil::Query("docs").AddingFilter(
+                            Filter("tags", "array-contains", "three")));
+}
+BENCHMARK(BM_MatchesArrayContains);
+
+/**
+ * Combines range, membership and equality filters on three fields, with the
+ * most selective filter added last.
+ */
+void BM_MatchesMixedFilters(benchmark::State& state) {
+  MatchDocuments(
+      state, testutil::Query("docs")
+                 .AddingFilter(Filter("value", ">=", 1000))
+                 .AddingFilter(Filter("value", "<", 9000))
+                 .AddingFilter(Filter("tags", "array-contains", "two"))
+                 .AddingFilter(Filter("author", "==", "user7")));
+}
+BENCHMARK(BM_MatchesMixedFilters);
+
+/** Filters and orders by two fields, between a start and an end bound. */
+void BM_MatchesOrderByAndBounds(benchmark::State& state) {
+  MatchDocuments(
+      state,
+      testutil::Query("docs")
+          .AddingFilter(Filter("bucket", ">=", 10))
+          .AddingOrderBy(OrderBy("bucket"))
+          .AddingOrderBy(OrderBy("value"))
+          .StartingAt(Bound({Value(20)}, /* is_before= */ true))
+          .EndingAt(Bound({Value(80), Value(5000)}, /* is_before= */ false)));
+}
+BENCHMARK(BM_MatchesOrderByAndBounds);
+
+/**
+ * Matches `range(0)` percent of 100,000 documents with an integer range, one
+ * document at a time.
+ */
+void BM_MatchesNumericRange(benchmark::State& state) {
+  MatchDocuments(state, NumericRangeQuery(static_cast<int>(state.range(0))),
+                 kLargeCollection);
+}
+BENCHMARK(BM_MatchesNumericRange)->Arg(10)->Arg(90);
+
+/** Matches the same ranges as `BM_MatchesNumericRange` as a batch. */
+void BM_MatchesBatchNumericRange(benchmark::State& state) {
+  MatchDocumentsInBatch(state,
+                        NumericRangeQuery(static_cast<int>(state.range(0))),
+                        kLargeCollection);
+}
+BENCHMARK(BM_MatchesBatchNumericRange)->Arg(10)->Arg(90);
+
+/** Matches a range on a nested field and an equality as a batch. */
+void BM_MatchesBatchNestedAndStringFilters(benchmark::State& state) {
+  MatchDocumentsInBatch(state,
+                        testutil::Query("docs")
+                            .AddingFilter(Filter("meta.likes", ">=", 500))
+                            .AddingFilter(Filter("author", "==", "user7")),
+                        kLargeCollection);
+}
+BENCHMARK(BM_MatchesBatchNestedAndStringFilters);
+
+/** Sorts all documents with the comparator of an ordered query. */
+void BM_SortWithComparator(benchmark::State& state) {
+  std::vector<Document> docs = BenchmarkDocuments("docs", kDocuments);
+  Query query = testutil::Query("docs")
+                    .AddingOrderBy(OrderBy("bucket"))
+                    .AddingOrderBy(OrderBy("value", "desc"));
+  model::DocumentComparator comparator = query.Comparator();
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    state.PauseTiming();
+    allocations.Pause();
+    std::vector<Document> sorted = docs;
+    allocations.Resume();
+    state.ResumeTiming();
+
+    std::sort(sorted.begin(), sorted.end(),
+              [&](const Document& lhs, const Document& rhs) {
+                return comparator.Compare(lhs, rhs) ==
+                       util::ComparisonResult::Ascending;
+              });
+    benchmark::DoNotOptimize(sorted.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kDocuments);
+}
+BENCHMARK(BM_SortWithComparator);
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
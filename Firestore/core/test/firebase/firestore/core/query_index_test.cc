@@ -0,0 +1,141 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_index.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "Firestore/core/test/firebase/firestore/testutil/view_testing.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::DocumentKey;
+using model::MaybeDocumentMap;
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::UnorderedElementsAre;
+using testutil::CollectionGroupQuery;
+using testutil::Doc;
+using testutil::DocUpdates;
+using testutil::Key;
+using testutil::Map;
+using testutil::Query;
+
+std::vector<std::string> Candidates(const QueryIndex<std::string>& index,
+                                    const DocumentKey& key) {
+  std::vector<std::string> result;
+  index.ForEachCandidate(
+      key, [&](const std::string& name) { result.push_back(name); });
+  return result;
+}
+
+std::vector<DocumentKey> Keys(const MaybeDocumentMap& changes) {
+  std::vector<DocumentKey> result;
+  for (const auto& kv : changes) {
+    result.push_back(kv.first);
+  }
+  return result;
+}
+
+TEST(QueryIndexTest, RoutesByCollection) {
+  QueryIndex<std::string> index;
+  index.Add(Query("rooms"), "rooms");
+  index.Add(Query("rooms").WithLimitToFirst(2), "limited rooms");
+  index.Add(Query("rooms/eros/messages"), "messages");
+
+  EXPECT_THAT(Candidates(index, Key("rooms/eros")),
+              UnorderedElementsAre("rooms", "limited rooms"));
+  EXPECT_THAT(Candidates(index, Key("rooms/eros/messages/1")),
+              ElementsAre("messages"));
+  EXPECT_THAT(Candidates(index, Key("rooms/other/messages/1")), IsEmpty());
+  EXPECT_THAT(Candidates(index, Key("users/eros")), IsEmpty());
+}
+
+TEST(QueryIndexTest, RoutesDocumentQueries) {
+  QueryIndex<std::string> index;
+  index.Add(Query("rooms/eros"), "eros");
+
+  EXPECT_THAT(Candidates(index, Key("rooms/eros")), ElementsAre("eros"));
+  EXPECT_THAT(Candidates(index, Key("rooms/other")), IsEmpty());
+}
+
+TEST(QueryIndexTest, RoutesCollectionGroupQueries) {
+  QueryIndex<std::string> index;
+  index.Add(CollectionGroupQuery("messages"), "all messages");
+
+  EXPECT_THAT(Candidates(index, Key("rooms/eros/messages/1")),
+              ElementsAre("all messages"));
+  EXPECT_THAT(Candidates(index, Key("messages/1")),
+              ElementsAre("all messages"));
+  EXPECT_THAT(Candidates(index, Key("rooms/eros")), IsEmpty());
+}
+
+TEST(QueryIndexTest, Remove) {
+  QueryIndex<std::string> index;
+  index.Add(Query("rooms"), "first");
+  index.Add(Query("rooms"), "second");
+  index.Add(Query("rooms/eros"), "eros");
+  index.Add(CollectionGroupQuery("rooms"), "group");
+
+  index.Remove(Query("rooms"), "first");
+  EXPECT_THAT(Candidates(index, Key("rooms/eros")),
+              UnorderedElementsAre("second", "eros", "group"));
+
+  index.Remove(Query("rooms"), "second");
+  index.Remove(Query("rooms/eros"), "eros");
+  index.Remove(CollectionGroupQuery("rooms"), "group");
+  EXPECT_THAT(Candidates(index, Key("rooms/eros")), IsEmpty());
+
+  // Removing an unknown value is a no-op.
+  index.Remove(Query("rooms"), "first");
+}
+
+TEST(QueryIndexTest, RoutesChanges) {
+  QueryIndex<std::string> index;
+  index.Add(Query("rooms"), "rooms");
+  index.Add(Query("users"), "users");
+  index.Add(Query("empty"), "empty");
+
+  MaybeDocumentMap changes = DocUpdates({
+      Doc("rooms/a", 1, Map()),
+      Doc("rooms/b", 1, Map()),
+      Doc("users/a", 1, Map()),
+      Doc("other/a", 1, Map()),
+  });
+
+  std::unordered_map<std::string, MaybeDocumentMap> routed =
+      index.Route(changes);
+  ASSERT_EQ(2u, routed.size());
+  EXPECT_THAT(Keys(routed["rooms"]),
+              ElementsAre(Key("rooms/a"), Key("rooms/b")));
+  EXPECT_THAT(Keys(routed["users"]), ElementsAre(Key("users/a")));
+}
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -17,6 +17,8 @@
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 
 #include <cmath>
+#include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/bound.h"
 #include "Firestore/core/src/firebase/firestore/core/field_filter.h"
@@ -26,6 +28,7 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -389,6 +392,111 @@ TEST(QueryTest, FiltersBasedOnObjectValue) {
   }
 }
 
+TEST(QueryTest, MatchesMultipleFiltersOnTheSameField) {
+  auto query = testutil::Query("collection")
+                   .AddingFilter(Filter("a", ">", 1))
+                   .AddingFilter(Filter("b", "==", "x"))
+                   .AddingFilter(Filter("a", "<=", 3))
+                   .AddingFilter(Filter("a", "in", Array(2, 3, 4)));
+
+  auto doc1 = Doc("collection/1", 0, Map("a", 2, "b", "x"));
+  auto doc2 = Doc("collection/2", 0, Map("a", 3, "b", "x"));
+  auto doc3 = Doc("collection/3", 0, Map("a", 4, "b", "x"));
+  auto doc4 = Doc("collection/4", 0, Map("a", 2, "b", "y"));
+  auto doc5 = Doc("collection/5", 0, Map("a", 2));
+  auto doc6 = Doc("collection/6", 0, Map("a", 1.5, "b", "x"));
+
+  EXPECT_THAT(query, Matches(doc1));
+  EXPECT_THAT(query, Matches(doc2));
+  EXPECT_THAT(query, Not(Matches(doc3)));
+  EXPECT_THAT(query, Not(Matches(doc4)));
+  EXPECT_THAT(query, Not(Matches(doc5)));
+  EXPECT_THAT(query, Not(Matches(doc6)));
+}
+
+TEST(QueryTest, MatchesBoundsAlongsideFilters) {
+  auto base_query = testutil::Query("collection")
+                        .AddingFilter(Filter("tags", "array-contains", "a"))
+                        .AddingOrderBy(OrderBy("sort"));
+  auto query =
+      base_query
+          .StartingAt(Bound({Value(2), Ref("project", "collection/2")},
+                            /* is_before= */ true))
+          .EndingAt(Bound({Value(3)}, /* is_before= */ false));
+
+  auto doc1 = Doc("collection/1", 0, Map("sort", 2, "tags", Array("a")));
+  auto doc2 = Doc("collection/2", 0, Map("sort", 2, "tags", Array("a")));
+  auto doc3 = Doc("collection/3", 0, Map("sort", 3, "tags", Array("a", "b")));
+  auto doc4 = Doc("collection/4", 0, Map("sort", 4, "tags", Array("a")));
+  auto doc5 = Doc("collection/5", 0, Map("sort", 3, "tags", Array("b")));
+  auto doc6 = Doc("collection/6", 0, Map("tags", Array("a")));
+
+  EXPECT_THAT(query, Not(Matches(doc1)));
+  EXPECT_THAT(query, Matches(doc2));
+  EXPECT_THAT(query, Matches(doc3));
+  EXPECT_THAT(query, Not(Matches(doc4)));
+  EXPECT_THAT(query, Not(Matches(doc5)));
+  EXPECT_THAT(query, Not(Matches(doc6)));
+
+  // The bounds of one query don't leak into related queries.
+  EXPECT_THAT(base_query, Matches(doc1));
+  EXPECT_THAT(base_query, Matches(doc4));
+}
+
+TEST(QueryTest, MatchesBatchAgreesWithMatches) {
+  std::vector<FieldValue> values = {
+      Value(-1),    Value(0),     Value(2),       Value(3),
+      Value(2.5),   Value(-0.0),  Value(0.0),     Value(NAN),
+      Value(3.0),   Value(""),    Value("a"),     Value("b"),
+      Value("foo"), Value(true),  Value(nullptr), Value(Array(2, "a")),
+      Value(Map("x", 2)),
+  };
+
+  // More documents than fit in a single chunk, including some outside of the
+  // collection and some without the field.
+  std::vector<Document> docs;
+  for (size_t i = 0; i < 600; ++i) {
+    std::string path = absl::StrCat(i % 50 == 0 ? "other/" : "coll/", i);
+    if (i % 7 == 0) {
+      docs.push_back(Doc(path, 0, Map("b", static_cast<int>(i))));
+    } else {
+      docs.push_back(Doc(path, 0,
+                         Map("a", values[i % values.size()], "b",
+                             static_cast<int>(i))));
+    }
+  }
+
+  auto base_query = testutil::Query("coll");
+  std::vector<Query> queries = {
+      base_query,
+      base_query.AddingFilter(Filter("a", "<", 3)),
+      base_query.AddingFilter(Filter("a", ">=", 2.5)),
+      base_query.AddingFilter(Filter("a", "==", 0)),
+      base_query.AddingFilter(Filter("a", "==", 0.0)),
+      base_query.AddingFilter(Filter("a", "==", NAN)),
+      base_query.AddingFilter(Filter("a", ">", "a")),
+      base_query.AddingFilter(Filter("a", "<=", "")),
+      base_query.AddingFilter(Filter("a", "in", Array(2, "b", true))),
+      base_query.AddingFilter(Filter("a", "array-contains", "a")),
+      base_query.AddingFilter(Filter("a", ">", -1))
+          .AddingFilter(Filter("a", "<=", 2.5))
+          .AddingFilter(Filter("a", "in", Array(0, 2, 2.5, "a"))),
+      base_query.AddingFilter(Filter("__name__", ">", Ref("p", "coll/300"))),
+      base_query.AddingOrderBy(OrderBy("a"))
+          .StartingAt(Bound({Value(0)}, /* is_before= */ false))
+          .EndingAt(Bound({Value("b")}, /* is_before= */ true)),
+  };
+
+  for (const Query& query : queries) {
+    std::vector<bool> matches = query.MatchesBatch(docs);
+    ASSERT_EQ(matches.size(), docs.size());
+    for (size_t i = 0; i < docs.size(); ++i) {
+      EXPECT_EQ(matches[i], query.Matches(docs[i]))
+          << query.ToString() << " on " << docs[i].ToString();
+    }
+  }
+}
+
 /**
  * Checks that an ordered array of elements yields the correct pair-wise
  * comparison result for the supplied comparator.
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <future>              // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
+#include "Firestore/core/src/firebase/firestore/auth/empty_credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/event_listener.h"
+#include "Firestore/core/src/firebase/firestore/core/firestore_client.h"
+#include "Firestore/core/src/firebase/firestore/core/listen_options.h"
+#include "Firestore/core/src/firebase/firestore/core/query_listener.h"
+#include "Firestore/core/src/firebase/firestore/core/transaction.h"
+#include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/test/firebase/firestore/remote/fake_firestore_server.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using auth::EmptyCredentialsProvider;
+using model::DatabaseId;
+using model::DocumentKey;
+using model::MaybeDocument;
+using model::Mutation;
+using remote::FakeFirestoreServer;
+using util::AsyncQueue;
+using util::Executor;
+using util::Status;
+using util::StatusOr;
+
+using testutil::Key;
+using testutil::Map;
+
+// Generous enough for a loaded machine; exceeding it means a hang.
+constexpr std::chrono::seconds kTimeout{30};
+
+/** Counts snapshots delivered on the worker queue. */
+class SnapshotCounter {
+ public:
+  void Increment() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    ++count_;
+    changed_.notify_one();
+  }
+
+  /** Returns false if fewer than `count` arrive before the timeout. */
+  bool AwaitAtLeast(int count) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    return changed_.wait_for(lock, kTimeout,
+                             [&] { return count_ >= count; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  int count_ = 0;
+};
+
+/**
+ * A `FirestoreClient` without persistence, connected to a fake server over
+ * loopback, so that everything from gRPC to the event manager runs as it
+ * does in an app.
+ */
+class SyncHarness {
+ public:
+  explicit SyncHarness(const FakeFirestoreServer& server) {
+    api::Settings settings;
+    settings.set_host(server.host());
+    settings.set_ssl_enabled(false);
+    settings.set_persistence_enabled(false);
+
+    client_ = FirestoreClient::Create(
+        DatabaseInfo(DatabaseId("sync-benchmark"), "sync_benchmark",
+                     server.host(), /*ssl_enabled=*/false),
+        settings, std::make_shared<EmptyCredentialsProvider>(),
+        Executor::CreateSerial("com.google.firebase.firestore.benchmark.user"),
+        AsyncQueue::Create(Executor::CreateSerial(
+            "com.google.firebase.firestore.benchmark.worker")));
+  }
+
+  ~SyncHarness() {
+    client_->Terminate();
+  }
+
+  /**
+   * Listens to `query` until `snapshots` snapshots have been received from
+   * the server (rather than the cache), then stops listening.
+   */
+  void Listen(const Query& query, int snapshots) {
+    // Shared with the listener, which may still be called after this returns,
+    // until the listener's removal reaches the worker queue.
+    auto counter = std::make_shared<SnapshotCounter>();
+
+    auto listener = EventListener<ViewSnapshot>::Create(
+        [counter](const StatusOr<ViewSnapshot>& maybe_snapshot) {
+          HARD_ASSERT(maybe_snapshot.ok(), "Listen failed: %s",
+                      maybe_snapshot.status().ToString());
+          if (!maybe_snapshot.ValueOrDie().from_cache()) counter->Increment();
+        });
+    std::shared_ptr<QueryListener> query_listener = client_->ListenToQuery(
+        query, ListenOptions::DefaultOptions(), std::move(listener));
+
+    bool done = counter->AwaitAtLeast(snapshots);
+    HARD_ASSERT(done, "Timed out waiting for snapshots");
+
+    client_->RemoveListener(query_listener);
+  }
+
+  /** Writes `mutation` and blocks until the server has acknowledged it. */
+  void Write(Mutation mutation) {
+    auto acknowledged = std::make_shared<std::promise<Status>>();
+    std::vector<Mutation> mutations{std::move(mutation)};
+    client_->WriteMutations(std::move(mutations),
+                            [acknowledged](const Status& status) {
+                              acknowledged->set_value(status);
+                            });
+    Await(acknowledged->get_future());
+  }
+
+  /**
+   * Runs a transaction that reads the document at `key` and commits without
+   * changes, which verifies the read version with the server.
+   */
+  void ReadInTransaction(const DocumentKey& key) {
+    auto committed = std::make_shared<std::promise<Status>>();
+    client_->Transaction(
+        /*retries=*/5,
+        [key](std::shared_ptr<Transaction> transaction,
+              TransactionResultCallback callback) {
+          transaction->Lookup(
+              {key}, [callback](const StatusOr<std::vector<MaybeDocument>>&
+                                    maybe_documents) {
+                callback(maybe_documents.status());
+              });
+        },
+        [committed](const Status& status) { committed->set_value(status); });
+    Await(committed->get_future());
+  }
+
+ private:
+  static void Await(std::future<Status> future) {
+    bool ready = future.wait_for(kTimeout) == std::future_status::ready;
+    HARD_ASSERT(ready, "Timed out waiting for the server");
+    Status status = future.get();
+    HARD_ASSERT(status.ok(), "Request failed: %s", status.ToString());
+  }
+
+  std::shared_ptr<FirestoreClient> client_;
+};
+
+/**
+ * Measures the latency from listening to a new query matching `range(0)`
+ * documents to its first snapshot from the server.
+ */
+void BM_ListenToFirstSnapshot(benchmark::State& state) {
+  FakeFirestoreServer server;
+  server.set_initial_documents(static_cast<int>(state.range(0)));
+  SyncHarness harness{server};
+
+  int iteration = 0;
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    // A fresh collection each time, so the cache has nothing to offer.
+    harness.Listen(testutil::Query(absl::StrCat("listen", iteration++)),
+                   /*snapshots=*/1);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ListenToFirstSnapshot)
+    ->Arg(1)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Measures how quickly remote changes reach a listener: each listen receives
+ * 1000 documents followed by 100 snapshots that each modify `range(0)` of
+ * them.
+ */
+void BM_SnapshotThroughput(benchmark::State& state) {
+  constexpr int kUpdates = 100;
+  int documents_per_update = static_cast<int>(state.range(0));
+
+  FakeFirestoreServer server;
+  server.set_initial_documents(1000);
+  server.set_updates(kUpdates, documents_per_update);
+  SyncHarness harness{server};
+
+  int iteration = 0;
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    harness.Listen(testutil::Query(absl::StrCat("updates", iteration++)),
+                   /*snapshots=*/1 + kUpdates);
+  }
+  state.counters["snapshots/s"] = benchmark::Counter(
+      state.iterations() * kUpdates, benchmark::Counter::kIsRate);
+  state.SetItemsProcessed(state.iterations() * kUpdates *
+                          documents_per_update);
+}
+BENCHMARK(BM_SnapshotThroughput)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/** Measures the round trip of a single write through the write stream. */
+void BM_WriteAckLatency(benchmark::State& state) {
+  FakeFirestoreServer server;
+  SyncHarness harness{server};
+
+  int iteration = 0;
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    harness.Write(testutil::SetMutation(absl::StrCat("writes/doc", iteration),
+                                        Map("value", iteration)));
+    ++iteration;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WriteAckLatency)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+/**
+ * Measures a transaction that reads a document and commits, which takes a
+ * `BatchGetDocuments` and a `Commit` round trip.
+ */
+void BM_TransactionReadAndCommit(benchmark::State& state) {
+  FakeFirestoreServer server;
+  SyncHarness harness{server};
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    harness.ReadInTransaction(Key("transactions/doc"));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TransactionReadAndCommit)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
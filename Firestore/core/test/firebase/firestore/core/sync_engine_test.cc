@@ -0,0 +1,285 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/sync_engine.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/model/no_document.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/test/firebase/firestore/testutil/sync_engine_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::MaybeDocument;
+using model::TargetId;
+using remote::RemoteEvent;
+using remote::TargetChange;
+using testing::ElementsAre;
+using testutil::SyncEngineTester;
+using util::Status;
+
+using testutil::DeletedDoc;
+using testutil::Doc;
+using testutil::Key;
+using testutil::Map;
+
+constexpr size_t kMaxConcurrentLimboResolutions = 2;
+
+class SyncEngineTest : public testing::Test {
+ public:
+  SyncEngineTest() : tester_(kMaxConcurrentLimboResolutions) {
+  }
+
+ protected:
+  SyncEngine* sync_engine() {
+    return tester_.sync_engine();
+  }
+
+  /** Resolves the given limbo document as deleted, as Watch would. */
+  void ResolveLimboDocumentAsDeleted(const DocumentKey& key, int64_t version) {
+    RemoteEvent::TargetChangeMap target_changes;
+    target_changes[LimboTarget(key)] =
+        TargetChange({}, /*current=*/true, DocumentKeySet{}, DocumentKeySet{},
+                     DocumentKeySet{});
+    RemoteEvent::DocumentUpdateMap document_updates;
+    document_updates[key] = DeletedDoc(key, version);
+
+    tester_.ApplyRemoteEvent(RemoteEvent(testutil::Version(version),
+                                         std::move(target_changes),
+                                         RemoteEvent::TargetSet{},
+                                         std::move(document_updates),
+                                         DocumentKeySet{key}));
+  }
+
+  /** Rejects the resolution of the given limbo document, as Watch would. */
+  void RejectLimboResolution(const DocumentKey& key) {
+    tester_.HandleRejectedListen(
+        LimboTarget(key), Status(Error::PermissionDenied, "Permission denied"));
+  }
+
+  TargetId LimboTarget(const DocumentKey& key) {
+    auto limbo_documents = sync_engine()->GetCurrentLimboDocuments();
+    auto found = limbo_documents.find(key);
+    EXPECT_NE(found, limbo_documents.end())
+        << key.ToString() << " has no active limbo resolution";
+    return found == limbo_documents.end() ? 0 : found->second;
+  }
+
+  std::vector<DocumentKey> ActiveLimboDocuments() {
+    std::vector<DocumentKey> result;
+    for (const auto& kv : sync_engine()->GetCurrentLimboDocuments()) {
+      result.push_back(kv.first);
+    }
+    return result;
+  }
+
+  /**
+   * Listens to "collection" and puts the documents with the given ids into
+   * limbo, in key order: Watch first sends them as part of the results, and
+   * then resets the target without them.
+   */
+  TargetId PutDocumentsInLimbo(const std::vector<const char*>& ids) {
+    TargetId target_id = tester_.Listen(testutil::Query("collection"));
+
+    DocumentKeySet keys;
+    std::vector<MaybeDocument> docs;
+    for (const char* id : ids) {
+      DocumentKey key = Key(absl::StrCat("collection/", id));
+      keys = keys.insert(key);
+      docs.push_back(Doc(key.ToString(), 1000, Map("id", id)));
+    }
+    tester_.ApplyTargetChange(target_id, 1000, keys, DocumentKeySet{}, docs);
+    tester_.ApplyTargetChange(target_id, 1001, DocumentKeySet{}, keys);
+    return target_id;
+  }
+
+  SyncEngineTester tester_;
+};
+
+/**
+ * Listens to several collections, one of them also through a limit query, and
+ * applies remote events that affect all of them: updates and deletes, which
+ * make the limit query refill, and a reset that puts documents into limbo.
+ * Returns the snapshots raised.
+ */
+std::vector<ViewSnapshot> ListenToCollections(SyncEngineTester* tester) {
+  constexpr int kCollections = 8;
+  constexpr int kDocsPerCollection = 4;
+
+  std::vector<TargetId> target_ids;
+  std::vector<std::vector<DocumentKey>> keys(kCollections);
+  for (int i = 0; i != kCollections; ++i) {
+    std::string collection = absl::StrCat("collection", i);
+    target_ids.push_back(tester->Listen(testutil::Query(collection)));
+    for (int j = 0; j != kDocsPerCollection; ++j) {
+      keys[i].push_back(Key(absl::StrCat(collection, "/doc", j)));
+    }
+  }
+  target_ids.push_back(
+      tester->Listen(testutil::Query("collection0").WithLimitToFirst(2)));
+  keys.push_back(keys[0]);
+
+  // Watch sends the initial results of every target.
+  for (size_t i = 0; i != target_ids.size(); ++i) {
+    DocumentKeySet added;
+    std::vector<MaybeDocument> docs;
+    for (const DocumentKey& key : keys[i]) {
+      added = added.insert(key);
+      docs.push_back(Doc(key.ToString(), 1000, Map("value", 0)));
+    }
+    tester->ApplyTargetChange(target_ids[i], 1000, added, DocumentKeySet{},
+                              docs);
+  }
+
+  // A single event updates doc0 and deletes doc1 in every collection.
+  RemoteEvent::TargetChangeMap target_changes;
+  RemoteEvent::DocumentUpdateMap document_updates;
+  for (size_t i = 0; i != target_ids.size(); ++i) {
+    target_changes[target_ids[i]] =
+        TargetChange({}, /*current=*/true, DocumentKeySet{},
+                     DocumentKeySet{keys[i][0]}, DocumentKeySet{keys[i][1]});
+    document_updates[keys[i][0]] =
+        Doc(keys[i][0].ToString(), 1001, Map("value", 1));
+    document_updates[keys[i][1]] = DeletedDoc(keys[i][1], 1001);
+  }
+  tester->ApplyRemoteEvent(RemoteEvent(
+      testutil::Version(1001), std::move(target_changes),
+      RemoteEvent::TargetSet{}, std::move(document_updates), DocumentKeySet{}));
+
+  // Watch drops doc2 from every collection without deleting it.
+  for (size_t i = 0; i != target_ids.size(); ++i) {
+    tester->ApplyTargetChange(target_ids[i], 1002, DocumentKeySet{},
+                              DocumentKeySet{keys[i][2]});
+  }
+
+  return tester->TakeSnapshots();
+}
+
+TEST_F(SyncEngineTest, LimitsConcurrentLimboResolutions) {
+  PutDocumentsInLimbo({"a", "b", "c", "d"});
+
+  EXPECT_THAT(ActiveLimboDocuments(),
+              ElementsAre(Key("collection/a"), Key("collection/b")));
+  EXPECT_THAT(sync_engine()->GetEnqueuedLimboDocuments(),
+              ElementsAre(Key("collection/c"), Key("collection/d")));
+
+  LimboResolutionStats stats = sync_engine()->GetLimboResolutionStats();
+  EXPECT_EQ(stats.active, 2u);
+  EXPECT_EQ(stats.enqueued, 2u);
+  EXPECT_EQ(stats.resolved, 0u);
+}
+
+TEST_F(SyncEngineTest, StartsEnqueuedLimboResolutionWhenOneCompletes) {
+  PutDocumentsInLimbo({"a", "b", "c", "d"});
+
+  ResolveLimboDocumentAsDeleted(Key("collection/a"), 1002);
+
+  EXPECT_THAT(ActiveLimboDocuments(),
+              ElementsAre(Key("collection/b"), Key("collection/c")));
+  EXPECT_THAT(sync_engine()->GetEnqueuedLimboDocuments(),
+              ElementsAre(Key("collection/d")));
+  EXPECT_EQ(sync_engine()->GetLimboResolutionStats().resolved, 1u);
+}
+
+TEST_F(SyncEngineTest, StartsEnqueuedLimboResolutionWhenOneIsRejected) {
+  PutDocumentsInLimbo({"a", "b", "c", "d"});
+
+  RejectLimboResolution(Key("collection/b"));
+
+  EXPECT_THAT(ActiveLimboDocuments(),
+              ElementsAre(Key("collection/a"), Key("collection/c")));
+  EXPECT_THAT(sync_engine()->GetEnqueuedLimboDocuments(),
+              ElementsAre(Key("collection/d")));
+  EXPECT_EQ(sync_engine()->GetLimboResolutionStats().resolved, 1u);
+}
+
+TEST_F(SyncEngineTest, DropsEnqueuedLimboDocumentThatLeavesLimbo) {
+  TargetId target_id = PutDocumentsInLimbo({"a", "b", "c", "d"});
+
+  // Watch sends "c" again, so it's no longer in limbo.
+  DocumentKey key = Key("collection/c");
+  tester_.ApplyTargetChange(target_id, 1002, DocumentKeySet{key},
+                            DocumentKeySet{},
+                            {Doc("collection/c", 1002, Map("id", "c"))});
+
+  EXPECT_THAT(sync_engine()->GetEnqueuedLimboDocuments(),
+              ElementsAre(Key("collection/d")));
+  EXPECT_EQ(sync_engine()->GetLimboResolutionStats().enqueued, 1u);
+
+  ResolveLimboDocumentAsDeleted(Key("collection/a"), 1003);
+  EXPECT_THAT(ActiveLimboDocuments(),
+              ElementsAre(Key("collection/b"), Key("collection/d")));
+  EXPECT_THAT(sync_engine()->GetEnqueuedLimboDocuments(), ElementsAre());
+}
+
+TEST_F(SyncEngineTest, LimboDocumentThatReentersLimboIsEnqueuedLast) {
+  TargetId target_id = PutDocumentsInLimbo({"a", "b", "c", "d", "e"});
+
+  // "c" leaves limbo while enqueued, and then enters it again behind "e".
+  DocumentKey key = Key("collection/c");
+  tester_.ApplyTargetChange(target_id, 1002, DocumentKeySet{key},
+                            DocumentKeySet{},
+                            {Doc("collection/c", 1002, Map("id", "c"))});
+  tester_.ApplyTargetChange(target_id, 1003, DocumentKeySet{},
+                            DocumentKeySet{key});
+
+  EXPECT_THAT(sync_engine()->GetEnqueuedLimboDocuments(),
+              ElementsAre(Key("collection/d"), Key("collection/e"),
+                          Key("collection/c")));
+
+  ResolveLimboDocumentAsDeleted(Key("collection/a"), 1004);
+  ResolveLimboDocumentAsDeleted(Key("collection/b"), 1005);
+  EXPECT_THAT(ActiveLimboDocuments(),
+              ElementsAre(Key("collection/d"), Key("collection/e")));
+  EXPECT_THAT(sync_engine()->GetEnqueuedLimboDocuments(),
+              ElementsAre(Key("collection/c")));
+}
+
+TEST(SyncEngineViewComputationTest, ParallelComputationMatchesSerial) {
+  SyncEngineTester serial;
+  SyncEngineTester parallel;
+  parallel.sync_engine()->EnableParallelViewComputation(4);
+
+  std::vector<ViewSnapshot> expected = ListenToCollections(&serial);
+  std::vector<ViewSnapshot> actual = ListenToCollections(&parallel);
+
+  EXPECT_FALSE(expected.empty());
+  EXPECT_EQ(actual, expected);
+  EXPECT_EQ(parallel.sync_engine()->GetCurrentLimboDocuments(),
+            serial.sync_engine()->GetCurrentLimboDocuments());
+}
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
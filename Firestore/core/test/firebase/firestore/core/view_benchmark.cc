@@ -0,0 +1,173 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/view.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "Firestore/core/test/firebase/firestore/testutil/view_testing.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::DocumentKeySet;
+using model::MaybeDocument;
+using model::MaybeDocumentMap;
+
+using testutil::Doc;
+using testutil::DocUpdates;
+using testutil::Map;
+using testutil::OrderBy;
+
+constexpr int kLimit = 20;
+
+/**
+ * Returns `count` documents in the "messages" collection whose keys start with
+ * `prefix`, with values spread across [offset, offset + count) in an order
+ * unrelated to their keys.
+ */
+std::vector<MaybeDocument> Messages(const char* prefix, int count, int offset) {
+  std::vector<MaybeDocument> docs;
+  for (int i = 0; i < count; ++i) {
+    int value = offset + testutil::ScatteredIndex(i, count);
+    docs.push_back(
+        Doc(absl::StrCat("messages/", prefix, i), 1, Map("value", value)));
+  }
+  return docs;
+}
+
+Query MessagesQuery() {
+  return testutil::Query("messages").AddingOrderBy(OrderBy("value"));
+}
+
+/**
+ * Computes the initial changes for a large batch of documents, as when a
+ * query first hears back from the backend.
+ */
+void ComputeInitialChanges(benchmark::State& state, const Query& query) {
+  MaybeDocumentMap docs =
+      DocUpdates(Messages("new", static_cast<int>(state.range(0)), 0));
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    View view(query, DocumentKeySet{});
+    benchmark::DoNotOptimize(view.ComputeDocumentChanges(docs));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_InitialChangesUnlimited(benchmark::State& state) {
+  ComputeInitialChanges(state, MessagesQuery());
+}
+BENCHMARK(BM_InitialChangesUnlimited)->Arg(1000)->Arg(10000);
+
+void BM_InitialChangesLimitToFirst(benchmark::State& state) {
+  ComputeInitialChanges(state, MessagesQuery().WithLimitToFirst(kLimit));
+}
+BENCHMARK(BM_InitialChangesLimitToFirst)->Arg(1000)->Arg(10000)->Arg(100000);
+
+void BM_InitialChangesLimitToLast(benchmark::State& state) {
+  ComputeInitialChanges(state, MessagesQuery().WithLimitToLast(kLimit));
+}
+BENCHMARK(BM_InitialChangesLimitToLast)->Arg(1000)->Arg(10000)->Arg(100000);
+
+/**
+ * Computes the changes for a large batch of documents arriving at a full limit
+ * query, almost all of which sort beyond its current last document.
+ */
+void BM_UpdateFullLimitQuery(benchmark::State& state) {
+  Query query = MessagesQuery().WithLimitToFirst(kLimit);
+  View view(query, DocumentKeySet{});
+  testutil::ApplyChanges(&view, Messages("old", kLimit, 0), absl::nullopt);
+
+  MaybeDocumentMap docs = DocUpdates(
+      Messages("new", static_cast<int>(state.range(0)), kLimit / 2));
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(view.ComputeDocumentChanges(docs));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UpdateFullLimitQuery)->Arg(1000)->Arg(10000)->Arg(100000);
+
+/**
+ * Returns a document with a moderately large body, whose last field is set to
+ * `value`.
+ */
+MaybeDocument Message(int id, int version, int value) {
+  return Doc(absl::StrCat("messages/", id), version,
+             Map("author", absl::StrCat("user", id % 50), "text",
+                 "The quick brown fox jumps over the lazy dog", "tags",
+                 testutil::Array("one", "two", "three"), "meta",
+                 Map("likes", id, "edited", false, "replies", id % 7), "value",
+                 value));
+}
+
+/**
+ * Computes the changes for the backend resending every document in a large
+ * view at a new version, with `modified` controlling whether the contents
+ * changed, as happens after a resumed or reset listen.
+ */
+void ResendDocuments(benchmark::State& state, bool modified) {
+  int count = static_cast<int>(state.range(0));
+  View view(MessagesQuery(), DocumentKeySet{});
+  std::vector<MaybeDocument> docs;
+  for (int i = 0; i < count; ++i) {
+    docs.push_back(Message(i, 1, i));
+  }
+  testutil::ApplyChanges(&view, docs, absl::nullopt);
+
+  int version = 2;
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    state.PauseTiming();
+    allocations.Pause();
+    // Build fresh documents each time, as they would be decoded anew.
+    docs.clear();
+    for (int i = 0; i < count; ++i) {
+      docs.push_back(Message(i, version, modified ? version + i : i));
+    }
+    MaybeDocumentMap changes = DocUpdates(docs);
+    ++version;
+    allocations.Resume();
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(view.ComputeDocumentChanges(changes));
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+void BM_ResendIdenticalDocuments(benchmark::State& state) {
+  ResendDocuments(state, /*modified=*/false);
+}
+BENCHMARK(BM_ResendIdenticalDocuments)->Arg(1000)->Arg(10000);
+
+void BM_ResendModifiedDocuments(benchmark::State& state) {
+  ResendDocuments(state, /*modified=*/true);
+}
+BENCHMARK(BM_ResendModifiedDocuments)->Arg(1000)->Arg(10000);
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/query_index.h"
+#include "Firestore/core/src/firebase/firestore/core/sync_engine.h"
+#include "Firestore/core/src/firebase/firestore/core/view.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+#include "Firestore/core/test/firebase/firestore/testutil/sync_engine_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "Firestore/core/test/firebase/firestore/testutil/view_testing.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::Document;
+using model::DocumentKeySet;
+using model::MaybeDocument;
+using model::MaybeDocumentMap;
+using model::TargetId;
+using remote::RemoteEvent;
+
+using testutil::Doc;
+using testutil::DocUpdates;
+using testutil::Map;
+
+constexpr int kDocsPerView = 20;
+
+/**
+ * A set of listeners, each on its own collection, as a dashboard with many
+ * independent widgets would have.
+ */
+class Listeners {
+ public:
+  explicit Listeners(int count) {
+    for (int i = 0; i < count; ++i) {
+      std::string collection = absl::StrCat("collection", i);
+      Query query = testutil::Query(collection);
+
+      std::vector<model::MaybeDocument> docs;
+      for (int j = 0; j < kDocsPerView; ++j) {
+        docs.push_back(
+            Doc(absl::StrCat(collection, "/doc", j), 1, Map("value", j)));
+      }
+
+      auto view = std::make_shared<View>(query, DocumentKeySet{});
+      testutil::ApplyChanges(view.get(), docs, absl::nullopt);
+      views_.push_back(view);
+      index_.Add(query, view.get());
+    }
+  }
+
+  /**
+   * Returns an update to a single document in one of the collections, cycling
+   * through collections and values on each call.
+   */
+  MaybeDocumentMap NextUpdate() {
+    int collection = counter_ % static_cast<int>(views_.size());
+    ++counter_;
+    return DocUpdates({Doc(absl::StrCat("collection", collection, "/doc0"), 2,
+                           Map("value", counter_))});
+  }
+
+  /** Recomputes every view, as SyncEngine did without routing. */
+  void ApplyToAllViews(const MaybeDocumentMap& changes) {
+    for (const auto& view : views_) {
+      ViewDocumentChanges doc_changes = view->ComputeDocumentChanges(changes);
+      benchmark::DoNotOptimize(view->ApplyChanges(doc_changes));
+    }
+  }
+
+  /** Recomputes only the views that the changes were routed to. */
+  void ApplyToRoutedViews(const MaybeDocumentMap& changes) {
+    std::unordered_map<View*, MaybeDocumentMap> routed = index_.Route(changes);
+    for (const auto& view : views_) {
+      auto found = routed.find(view.get());
+      if (found == routed.end()) continue;
+
+      ViewDocumentChanges doc_changes =
+          view->ComputeDocumentChanges(found->second);
+      benchmark::DoNotOptimize(view->ApplyChanges(doc_changes));
+    }
+  }
+
+ private:
+  std::vector<std::shared_ptr<View>> views_;
+  QueryIndex<View*> index_;
+  int counter_ = 0;
+};
+
+/**
+ * The same listeners, but listening through a `SyncEngine`, which routes
+ * remote changes to their views and computes the views' changes, serially or
+ * in parallel.
+ */
+class SyncEngineListeners {
+ public:
+  /**
+   * @param threads The number of threads to compute views on, or 0 to compute
+   *     them serially.
+   */
+  SyncEngineListeners(int count, int threads) : count_(count) {
+    if (threads > 0) {
+      tester_.sync_engine()->EnableParallelViewComputation(threads);
+    }
+
+    for (int i = 0; i < count; ++i) {
+      std::string collection = absl::StrCat("collection", i);
+      TargetId target_id = tester_.Listen(testutil::Query(collection));
+
+      DocumentKeySet keys;
+      std::vector<MaybeDocument> docs;
+      for (int j = 0; j < kDocsPerView; ++j) {
+        Document doc = Doc(absl::StrCat(collection, "/doc", j), version_,
+                           Map("value", j));
+        keys = keys.insert(doc.key());
+        docs.push_back(doc);
+      }
+      tester_.ApplyTargetChange(target_id, version_, keys, DocumentKeySet{},
+                                docs);
+    }
+    tester_.TakeSnapshots();
+  }
+
+  /**
+   * Applies a remote event that updates one document in every collection, so
+   * that every view is affected, and waits for the snapshots.
+   */
+  void ApplyDenseUpdate() {
+    ++version_;
+    RemoteEvent::DocumentUpdateMap document_updates;
+    for (int i = 0; i != count_; ++i) {
+      Document doc = Doc(absl::StrCat("collection", i, "/doc0"), version_,
+                         Map("value", version_));
+      document_updates[doc.key()] = doc;
+    }
+
+    tester_.ApplyRemoteEvent(RemoteEvent(
+        testutil::Version(version_), RemoteEvent::TargetChangeMap{},
+        RemoteEvent::TargetSet{}, std::move(document_updates),
+        DocumentKeySet{}));
+    benchmark::DoNotOptimize(tester_.TakeSnapshots());
+  }
+
+ private:
+  testutil::SyncEngineTester tester_;
+  int count_ = 0;
+  int64_t version_ = 1;
+};
+
+void BM_SparseUpdateAllViews(benchmark::State& state) {
+  Listeners listeners(static_cast<int>(state.range(0)));
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    listeners.ApplyToAllViews(listeners.NextUpdate());
+  }
+}
+BENCHMARK(BM_SparseUpdateAllViews)->Arg(1)->Arg(10)->Arg(100)->Arg(500);
+
+void BM_SparseUpdateRoutedViews(benchmark::State& state) {
+  Listeners listeners(static_cast<int>(state.range(0)));
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    listeners.ApplyToRoutedViews(listeners.NextUpdate());
+  }
+}
+BENCHMARK(BM_SparseUpdateRoutedViews)->Arg(1)->Arg(10)->Arg(100)->Arg(500);
+
+// The sync engine works on its worker queue, so the dense update benchmarks
+// measure real time.
+
+void BM_DenseUpdateSerialViews(benchmark::State& state) {
+  SyncEngineListeners listeners(static_cast<int>(state.range(0)),
+                                /*threads=*/0);
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    listeners.ApplyDenseUpdate();
+  }
+}
+BENCHMARK(BM_DenseUpdateSerialViews)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(500)
+    ->UseRealTime();
+
+void BM_DenseUpdateParallelViews(benchmark::State& state) {
+  int threads =
+      std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+  SyncEngineListeners listeners(static_cast<int>(state.range(0)), threads);
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    listeners.ApplyDenseUpdate();
+  }
+}
+BENCHMARK(BM_DenseUpdateParallelViews)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(500)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/listen_options.h"
+#include "Firestore/core/src/firebase/firestore/core/query_listener.h"
+#include "Firestore/core/src/firebase/firestore/core/view.h"
+#include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "Firestore/core/test/firebase/firestore/testutil/view_testing.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::DocumentKeySet;
+using model::MaybeDocument;
+
+using testutil::Doc;
+using testutil::Map;
+
+/**
+ * Measures the memory cost of raising a snapshot for a single modification to
+ * a large view, to a listener whose user callback holds on to the latest
+ * snapshot.
+ *
+ * Reports the allocations per snapshot and the bytes kept alive by the latest
+ * snapshot beyond what the view itself retains.
+ */
+void SnapshotMemory(benchmark::State& state, const ListenOptions& options) {
+  int size = static_cast<int>(state.range(0));
+  Query query = testutil::Query("collection");
+
+  std::vector<MaybeDocument> docs;
+  for (int i = 0; i < size; ++i) {
+    docs.push_back(Doc(absl::StrCat("collection/doc", i), 1, Map("value", i)));
+  }
+
+  View view(query, DocumentKeySet{});
+  absl::optional<ViewSnapshot> latest;
+  auto listener = QueryListener::Create(
+      query, options, [&](util::StatusOr<ViewSnapshot> snapshot) {
+        latest = std::move(snapshot).ValueOrDie();
+      });
+  listener->OnViewSnapshot(*testutil::ApplyChanges(&view, docs, {}));
+
+  int version = 2;
+  {
+    testutil::AllocationCounter allocations{state};
+    for (auto _ : state) {
+      MaybeDocument doc =
+          Doc("collection/doc0", version, Map("value", version));
+      ++version;
+      listener->OnViewSnapshot(*testutil::ApplyChanges(&view, {doc}, {}));
+    }
+  }
+
+  int64_t live_with_snapshots = testutil::GetAllocationStats().live_bytes;
+  latest.reset();
+  listener.reset();
+  int64_t live_without_snapshots = testutil::GetAllocationStats().live_bytes;
+
+  state.counters["retained_bytes"] = static_cast<double>(
+      live_with_snapshots - live_without_snapshots);
+}
+
+void BM_SnapshotMemory(benchmark::State& state) {
+  SnapshotMemory(state, ListenOptions::DefaultOptions());
+}
+BENCHMARK(BM_SnapshotMemory)->Arg(1000)->Arg(10000)->Arg(50000);
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
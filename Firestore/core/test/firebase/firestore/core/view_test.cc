@@ -28,6 +28,7 @@
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "Firestore/core/test/firebase/firestore/testutil/view_testing.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -41,6 +42,7 @@ using model::DocumentKeySet;
 using model::DocumentSet;
 using model::DocumentState;
 using model::FieldValue;
+using model::MaybeDocument;
 using model::ResourcePath;
 
 using testing::ElementsAre;
@@ -303,6 +305,64 @@ TEST(ViewTest, DoesntReportChangesForDocumentBeyondLimitOfQuery) {
   ASSERT_TRUE(snapshot.sync_state_changed());
 }
 
+TEST(ViewTest, KeepsOnlyTopDocumentsOfLargeBatchesForLimitQueries) {
+  using Type = DocumentViewChange::Type;
+  Query query = QueryForMessages().AddingOrderBy(OrderBy("num"));
+
+  std::vector<Document> docs;
+  for (int i = 0; i < 50; ++i) {
+    // Interleave low and high values so that the boundary keeps moving.
+    int num = i % 2 == 0 ? i : 100 - i;
+    docs.push_back(Doc(absl::StrCat("rooms/eros/messages/", 100 + i), 0,
+                       Map("num", num)));
+  }
+  std::vector<MaybeDocument> updates(docs.begin(), docs.end());
+
+  View first_view(query.WithLimitToFirst(3), DocumentKeySet{});
+  ViewSnapshot first =
+      ApplyChanges(&first_view, updates, absl::nullopt).value();
+  ASSERT_THAT(first.documents(), ElementsAre(docs[0], docs[2], docs[4]));
+  ASSERT_THAT(first.document_changes(),
+              ElementsAre(DocumentViewChange{docs[0], Type::Added},
+                          DocumentViewChange{docs[2], Type::Added},
+                          DocumentViewChange{docs[4], Type::Added}));
+
+  View last_view(query.WithLimitToLast(3), DocumentKeySet{});
+  ViewSnapshot last = ApplyChanges(&last_view, updates, absl::nullopt).value();
+  ASSERT_THAT(last.documents(), ElementsAre(docs[5], docs[3], docs[1]));
+  ASSERT_THAT(last.document_changes(),
+              ElementsAre(DocumentViewChange{docs[5], Type::Added},
+                          DocumentViewChange{docs[3], Type::Added},
+                          DocumentViewChange{docs[1], Type::Added}));
+}
+
+TEST(ViewTest, AddsDocumentsBeyondLimitWhenOthersAreRemovedInSameBatch) {
+  Query query =
+      QueryForMessages().AddingOrderBy(OrderBy("num")).WithLimitToFirst(2);
+  View view(query, DocumentKeySet{});
+
+  Document doc1 = Doc("rooms/eros/messages/1", 0, Map("num", 2));
+  Document doc2 = Doc("rooms/eros/messages/2", 0, Map("num", 3));
+  Document doc3 = Doc("rooms/eros/messages/3", 0, Map("num", 1));
+
+  // initial state
+  ApplyChanges(&view, {doc3}, absl::nullopt);
+
+  // doc1 fills the limit, and doc2 sorts after it, but deleting doc3 leaves
+  // room for both.
+  ViewDocumentChanges changes = view.ComputeDocumentChanges(
+      DocUpdates({doc1, doc2, DeletedDoc("rooms/eros/messages/3", 1)}));
+  ASSERT_FALSE(changes.needs_refill());
+
+  ViewSnapshot snapshot = view.ApplyChanges(changes).snapshot().value();
+  ASSERT_THAT(snapshot.documents(), ElementsAre(doc1, doc2));
+  ASSERT_THAT(
+      snapshot.document_changes(),
+      ElementsAre(DocumentViewChange{doc3, DocumentViewChange::Type::Removed},
+                  DocumentViewChange{doc1, DocumentViewChange::Type::Added},
+                  DocumentViewChange{doc2, DocumentViewChange::Type::Added}));
+}
+
 TEST(ViewTest, KeepsTrackOfLimboDocuments) {
   Query query = QueryForMessages();
   View view(query, DocumentKeySet{});
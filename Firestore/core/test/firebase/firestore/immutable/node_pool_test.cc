@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/node_pool.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+TEST(NodePoolTest, RoundsBlockSizesUp) {
+  NodePool pool{1};
+  EXPECT_EQ(NodePool::kAlignment, pool.block_size());
+
+  NodePool exact{NodePool::kAlignment * 2};
+  EXPECT_EQ(NodePool::kAlignment * 2, exact.block_size());
+}
+
+TEST(NodePoolTest, ReusesFreedBlocks) {
+  NodePool pool{64};
+  void* first = pool.Allocate();
+  EXPECT_EQ(0u, pool.free_blocks());
+
+  pool.Deallocate(first);
+  EXPECT_EQ(1u, pool.free_blocks());
+
+  void* second = pool.Allocate();
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(0u, pool.free_blocks());
+
+  pool.Deallocate(second);
+}
+
+TEST(NodePoolTest, BoundsFreeList) {
+  NodePool pool{32};
+
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < NodePool::kMaxFreeBlocks + 10; ++i) {
+    blocks.push_back(pool.Allocate());
+  }
+  for (void* block : blocks) {
+    pool.Deallocate(block);
+  }
+  // The shared list is bounded; the calling thread's cache may hold more.
+  EXPECT_GE(pool.free_blocks(), NodePool::kMaxFreeBlocks);
+  EXPECT_LE(pool.free_blocks(),
+            NodePool::kMaxFreeBlocks + NodePool::kThreadCacheSize);
+}
+
+TEST(NodePoolTest, SharesPoolsBetweenTypesOfTheSameSizeClass) {
+  EXPECT_EQ(&NodePool::ForSize<1>(), &NodePool::ForSize<2>());
+  EXPECT_NE(&NodePool::ForSize<1>(),
+            &NodePool::ForSize<NodePool::kAlignment + 1>());
+}
+
+TEST(NodePoolTest, AllocatesSharedObjects) {
+  struct Value {
+    int a;
+    double b;
+  };
+
+  auto value = std::allocate_shared<Value>(NodePoolAllocator<Value>{},
+                                           Value{1, 2.0});
+  EXPECT_EQ(1, value->a);
+  EXPECT_EQ(2.0, value->b);
+}
+
+TEST(NodePoolTest, DeallocatesAcrossThreads) {
+  NodePool pool{64};
+
+  std::vector<void*> blocks;
+  for (int i = 0; i < 100; ++i) {
+    blocks.push_back(pool.Allocate());
+  }
+
+  std::thread other{[&] {
+    for (void* block : blocks) {
+      pool.Deallocate(block);
+    }
+  }};
+  other.join();
+
+  EXPECT_EQ(100u, pool.free_blocks());
+  for (void*& block : blocks) {
+    block = pool.Allocate();
+  }
+  EXPECT_EQ(0u, pool.free_blocks());
+
+  for (void* block : blocks) {
+    pool.Deallocate(block);
+  }
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
+#include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace {
+
+using IntMap = SortedMap<int, int>;
+using IntSet = SortedSet<int>;
+
+std::vector<int> ShuffledSequence(int size) {
+  std::vector<int> result;
+  for (int i = 0; i < size; ++i) {
+    result.push_back(i);
+  }
+  util::SecureRandom rng;
+  std::shuffle(result.begin(), result.end(), rng);
+  return result;
+}
+
+IntMap ToMap(const std::vector<int>& values) {
+  IntMap result;
+  for (int value : values) {
+    result = result.insert(value, value);
+  }
+  return result;
+}
+
+void BM_SortedMapInsertSequential(benchmark::State& state) {
+  auto size = static_cast<int>(state.range(0));
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    IntMap map;
+    for (int i = 0; i < size; ++i) {
+      map = map.insert(i, i);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_SortedMapInsertSequential)->Range(1 << 4, 1 << 16);
+
+void BM_SortedMapInsertRandom(benchmark::State& state) {
+  std::vector<int> values = ShuffledSequence(static_cast<int>(state.range(0)));
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    IntMap map;
+    for (int value : values) {
+      map = map.insert(value, value);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_SortedMapInsertRandom)->Range(1 << 4, 1 << 16);
+
+void BM_SortedMapEraseRandom(benchmark::State& state) {
+  std::vector<int> values = ShuffledSequence(static_cast<int>(state.range(0)));
+  IntMap full = ToMap(values);
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    IntMap map = full;
+    for (int value : values) {
+      map = map.erase(value);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_SortedMapEraseRandom)->Range(1 << 4, 1 << 16);
+
+/**
+ * Measures the steady-state cost of replacing entries in a large map while
+ * older versions are discarded, which is the typical pattern when a cache is
+ * updated on the worker queue.
+ */
+void BM_SortedMapChurn(benchmark::State& state) {
+  auto size = static_cast<int>(state.range(0));
+  IntMap map = ToMap(ShuffledSequence(size));
+
+  int next = 0;
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    map = map.erase(next % size).insert(next % size, next);
+    ++next;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SortedMapChurn)->Range(1 << 6, 1 << 16);
+
+void BM_SortedSetInsert(benchmark::State& state) {
+  std::vector<int> values = ShuffledSequence(static_cast<int>(state.range(0)));
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    IntSet set;
+    for (int value : values) {
+      set = set.insert(value);
+    }
+    benchmark::DoNotOptimize(set);
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_SortedSetInsert)->Range(1 << 4, 1 << 16);
+
+}  // namespace
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
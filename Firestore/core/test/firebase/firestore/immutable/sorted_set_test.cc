@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
 
+#include <algorithm>
+#include <iterator>
 #include <random>
 #include <unordered_set>
 
@@ -154,6 +156,101 @@ TEST(SortedSetTest, ValuesIn) {
   ASSERT_SEQ_EQ(Seq(8, 14), set.values_in(7, 13));   // in between to in between
 }
 
+TEST(SortedSetTest, UnionWith) {
+  SortedSet<int> evens = ToSet(Sequence(0, 100, 2));
+  SortedSet<int> odds = ToSet(Sequence(1, 100, 2));
+  ASSERT_SEQ_EQ(Sequence(100), evens.union_with(odds));
+  ASSERT_SEQ_EQ(Sequence(100), odds.union_with(evens));
+
+  SortedSet<int> overlapping = ToSet(Sequence(50, 150));
+  ASSERT_SEQ_EQ(Sequence(150), ToSet(Sequence(100)).union_with(overlapping));
+
+  SortedSet<int> empty;
+  ASSERT_SEQ_EQ(Sequence(0, 100, 2), evens.union_with(empty));
+  ASSERT_SEQ_EQ(Sequence(0, 100, 2), empty.union_with(evens));
+}
+
+TEST(SortedSetTest, UnionWithSmallSet) {
+  SortedSet<int> large = ToSet(Sequence(0, 1000, 2));
+  SortedSet<int> small = ToSet(std::vector<int>{1, 500, 999});
+
+  std::vector<int> expected = Sequence(0, 1000, 2);
+  expected.push_back(1);
+  expected.push_back(999);
+  ASSERT_SEQ_EQ(Sorted(expected), large.union_with(small));
+  ASSERT_SEQ_EQ(Sorted(expected), small.union_with(large));
+}
+
+TEST(SortedSetTest, UnionWithSubsetReturnsSuperset) {
+  SortedSet<int> superset = ToSet(Sequence(kLargeNumber));
+  SortedSet<int> subset = ToSet(Sequence(0, kLargeNumber, 3));
+
+  SortedSet<int> result = superset.union_with(subset);
+  EXPECT_EQ(superset, result);
+  EXPECT_EQ(superset.begin(), result.begin());
+}
+
+TEST(SortedSetTest, IntersectionWith) {
+  SortedSet<int> evens = ToSet(Sequence(0, 1000, 2));
+  SortedSet<int> threes = ToSet(Sequence(0, 1000, 3));
+  ASSERT_SEQ_EQ(Sequence(0, 1000, 6), evens.intersection_with(threes));
+  ASSERT_SEQ_EQ(Sequence(0, 1000, 6), threes.intersection_with(evens));
+
+  SortedSet<int> odds = ToSet(Sequence(1, 1000, 2));
+  ASSERT_SEQ_EQ(Empty(), evens.intersection_with(odds));
+
+  SortedSet<int> empty;
+  ASSERT_SEQ_EQ(Empty(), evens.intersection_with(empty));
+  ASSERT_SEQ_EQ(Empty(), empty.intersection_with(evens));
+
+  SortedSet<int> small = ToSet(std::vector<int>{3, 4, 998, 2000});
+  ASSERT_SEQ_EQ((std::vector<int>{4, 998}), evens.intersection_with(small));
+  ASSERT_SEQ_EQ((std::vector<int>{4, 998}), small.intersection_with(evens));
+}
+
+TEST(SortedSetTest, DifferenceWith) {
+  SortedSet<int> all = ToSet(Sequence(1000));
+  SortedSet<int> evens = ToSet(Sequence(0, 1000, 2));
+  ASSERT_SEQ_EQ(Sequence(1, 1000, 2), all.difference_with(evens));
+  ASSERT_SEQ_EQ(Empty(), evens.difference_with(all));
+
+  SortedSet<int> small = ToSet(std::vector<int>{0, 1, 2, 3, 5000});
+  ASSERT_SEQ_EQ(Sequence(4, 1000), all.difference_with(small));
+  ASSERT_SEQ_EQ((std::vector<int>{5000}), small.difference_with(all));
+
+  SortedSet<int> empty;
+  ASSERT_SEQ_EQ(Sequence(1000), all.difference_with(empty));
+  ASSERT_SEQ_EQ(Empty(), empty.difference_with(all));
+}
+
+TEST(SortedSetTest, SetOperationsMatchStdAlgorithms) {
+  for (int i = 0; i < 20; ++i) {
+    std::vector<int> lhs_values = Sorted(Shuffled(Sequence(0, 3000, 1 + i % 4)));
+    lhs_values.resize(static_cast<size_t>(100 * i) % lhs_values.size());
+    std::vector<int> rhs_values = Sequence(i, 2000, 1 + i % 7);
+
+    SortedSet<int> lhs = ToSet(lhs_values);
+    SortedSet<int> rhs = ToSet(rhs_values);
+
+    std::vector<int> expected;
+    std::set_union(lhs_values.begin(), lhs_values.end(), rhs_values.begin(),
+                   rhs_values.end(), std::back_inserter(expected));
+    ASSERT_SEQ_EQ(expected, lhs.union_with(rhs));
+
+    expected.clear();
+    std::set_intersection(lhs_values.begin(), lhs_values.end(),
+                          rhs_values.begin(), rhs_values.end(),
+                          std::back_inserter(expected));
+    ASSERT_SEQ_EQ(expected, lhs.intersection_with(rhs));
+
+    expected.clear();
+    std::set_difference(lhs_values.begin(), lhs_values.end(),
+                        rhs_values.begin(), rhs_values.end(),
+                        std::back_inserter(expected));
+    ASSERT_SEQ_EQ(expected, lhs.difference_with(rhs));
+  }
+}
+
 TEST(SortedSetTest, HashesStdHashable) {
   SortedSet<int> set;
 
@@ -230,6 +230,59 @@ TEST(TreeSortedMap, InitializerIsSorted) {
   EXPECT_TRUE(std::is_sorted(map.begin(), map.end()));
 }
 
+/**
+ * Verifies the left-leaning red-black invariants of the subtree rooted at the
+ * given node, returning its black height.
+ */
+static int CheckInvariants(const IntMap::node_type& node) {
+  if (node.empty()) {
+    return 1;
+  }
+
+  EXPECT_FALSE(node.right().red()) << "Red link leans right at " << node.key();
+  if (node.red()) {
+    EXPECT_FALSE(node.left().red()) << "Red node has red child at "
+                                    << node.key();
+  }
+  EXPECT_EQ(node.left().size() + 1 + node.right().size(), node.size());
+
+  int left_height = CheckInvariants(node.left());
+  int right_height = CheckInvariants(node.right());
+  EXPECT_EQ(left_height, right_height) << "Unbalanced at " << node.key();
+  return left_height + (node.red() ? 0 : 1);
+}
+
+TEST(TreeSortedMap, CreateFromSortedIsValid) {
+  for (int size = 0; size <= 300; ++size) {
+    std::vector<std::pair<int, int>> entries = Pairs(Sequence(size));
+    IntMap map = IntMap::CreateFromSorted(entries.begin(), entries.end(), {});
+
+    ASSERT_EQ(static_cast<size_t>(size), map.size());
+    EXPECT_FALSE(map.root().red());
+    CheckInvariants(map.root());
+    ASSERT_SEQ_EQ(entries, map);
+  }
+}
+
+TEST(TreeSortedMap, CreateFromSortedSupportsMutation) {
+  std::vector<std::pair<int, int>> entries = Pairs(Sequence(0, 200, 2));
+  IntMap map = IntMap::CreateFromSorted(entries.begin(), entries.end(), {});
+
+  for (int i = 1; i < 200; i += 2) {
+    map = map.insert(i, i);
+  }
+  for (int i = 0; i < 200; i += 3) {
+    map = map.erase(i);
+  }
+  CheckInvariants(map.root());
+
+  std::vector<int> expected;
+  for (int i = 0; i < 200; ++i) {
+    if (i % 3 != 0) expected.push_back(i);
+  }
+  ASSERT_SEQ_EQ(Pairs(expected), map);
+}
+
 }  // namespace impl
 }  // namespace immutable
 }  // namespace firestore
@@ -423,6 +423,16 @@ TEST(RemoteDocumentReadTimeKeyTest, Description) {
       RemoteDocumentReadTimeKey("coll", 1000001, "doc"));
 }
 
+TEST(LevelDbMigrationProgressKeyTest, Ordering) {
+  ASSERT_LT(LevelDbMigrationProgressKey::Key(4),
+            LevelDbMigrationProgressKey::Key(6));
+}
+
+TEST(LevelDbMigrationProgressKeyTest, Description) {
+  AssertExpectedKeyDescription("[migration_progress: schema_version=6]",
+                               LevelDbMigrationProgressKey::Key(6));
+}
+
 #undef AssertExpectedKeyDescription
 
 }  // namespace local
@@ -263,6 +263,57 @@ TEST_F(LevelDbMigrationsTest, AddsSentinelRows) {
   }
 }
 
+TEST_F(LevelDbMigrationsTest, DefersSentinelRowsToChunks) {
+  LevelDbMigrations::RunMigrations(db_.get(), 3);
+  std::vector<DocumentKey> keys;
+  {
+    std::string empty_buffer;
+    LevelDbTransaction transaction(db_.get(), "Setup");
+    for (int i = 0; i < 10; i++) {
+      DocumentKey key = DocumentKey::FromSegments({"docs", std::to_string(i)});
+      transaction.Put(LevelDbRemoteDocumentKey::Key(key), empty_buffer);
+      keys.push_back(key);
+    }
+    transaction.Commit();
+  }
+
+  auto count_sentinel_rows = [&] {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+    std::string buffer;
+    int count = 0;
+    for (const DocumentKey& key : keys) {
+      if (transaction.Get(LevelDbDocumentTargetKey::SentinelKey(key), &buffer)
+              .ok()) {
+        count++;
+      }
+    }
+    return count;
+  };
+
+  LevelDbMigrations::RunBlockingMigrations(db_.get(), 4);
+  ASSERT_EQ(4, LevelDbMigrations::ReadSchemaVersion(db_.get()));
+  ASSERT_TRUE(LevelDbMigrations::HasDeferredMigrations(db_.get()));
+  ASSERT_EQ(0, count_sentinel_rows());
+
+  ASSERT_TRUE(LevelDbMigrations::RunDeferredMigrations(db_.get(), 3));
+  ASSERT_EQ(3, count_sentinel_rows());
+
+  // The remaining seven documents take three more chunks.
+  ASSERT_TRUE(LevelDbMigrations::RunDeferredMigrations(db_.get(), 3));
+  ASSERT_TRUE(LevelDbMigrations::RunDeferredMigrations(db_.get(), 3));
+  ASSERT_FALSE(LevelDbMigrations::RunDeferredMigrations(db_.get(), 3));
+  ASSERT_FALSE(LevelDbMigrations::HasDeferredMigrations(db_.get()));
+  ASSERT_EQ(10, count_sentinel_rows());
+}
+
+TEST_F(LevelDbMigrationsTest, DowngradeDiscardsDeferredMigrations) {
+  LevelDbMigrations::RunBlockingMigrations(db_.get());
+  ASSERT_TRUE(LevelDbMigrations::HasDeferredMigrations(db_.get()));
+
+  LevelDbMigrations::RunMigrations(db_.get(), 3);
+  ASSERT_FALSE(LevelDbMigrations::HasDeferredMigrations(db_.get()));
+}
+
 TEST_F(LevelDbMigrationsTest, RemovesMutationBatches) {
   std::string empty_buffer;
   DocumentKey test_write_foo = DocumentKey::FromPathString("docs/foo");
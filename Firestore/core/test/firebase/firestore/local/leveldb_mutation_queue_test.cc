@@ -157,6 +157,16 @@ TEST_F(LevelDbMutationQueueTest, LoadNextBatchIdOnlyFindsMutations) {
   ASSERT_EQ(LoadNextBatchIdFromDb(db_), 4);
 }
 
+TEST_F(LevelDbMutationQueueTest, LoadsNextBatchIdWhenFirstBatchIsAdded) {
+  // The queue has already started, but hasn't needed a batch ID yet.
+  SetDummyValueForKey(LevelDbMutationKey::Key("other", 6));
+
+  persistence_->Run("LoadsNextBatchIdWhenFirstBatchIsAdded", [&] {
+    ASSERT_EQ(AddMutationBatch().batch_id(), 7);
+    ASSERT_EQ(AddMutationBatch().batch_id(), 8);
+  });
+}
+
 TEST_F(LevelDbMutationQueueTest, EmptyProtoCanBeUpgraded) {
   // An empty protocol buffer serializes to a zero-length byte buffer.
   google_protobuf_Empty empty{};
@@ -0,0 +1,375 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/index_free_query_engine.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/local_store.h"
+#include "Firestore/core/src/firebase/firestore/local/local_write_result.h"
+#include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/query_result.h"
+#include "Firestore/core/src/firebase/firestore/local/target_data.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch_result.h"
+#include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
+#include "Firestore/core/test/firebase/firestore/remote/fake_target_metadata_provider.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using auth::User;
+using model::Document;
+using model::Mutation;
+using model::MutationBatch;
+using model::MutationBatchResult;
+using model::MutationResult;
+using model::ResourcePath;
+using model::TargetId;
+using remote::DocumentWatchChange;
+using remote::FakeTargetMetadataProvider;
+using remote::RemoteEvent;
+using remote::WatchChangeAggregator;
+
+using testutil::BenchmarkDocuments;
+using testutil::Filter;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::Query;
+
+/** The number of documents in the cache for query benchmarks. */
+constexpr int kCachedDocuments = 10000;
+
+enum class PersistenceType { Memory, LevelDb };
+
+/**
+ * Owns a started `LocalStore` over a fresh instance of the given persistence,
+ * with LRU garbage collection enabled regardless of the cache size.
+ */
+class LocalStoreHarness {
+ public:
+  explicit LocalStoreHarness(PersistenceType type)
+      : persistence_(MakePersistence(type)),
+        local_store_(persistence_.get(), &query_engine_,
+                     User::Unauthenticated()) {
+    local_store_.Start();
+  }
+
+  LocalStore* local_store() {
+    return &local_store_;
+  }
+
+  LruGarbageCollector* garbage_collector() {
+    return static_cast<LruDelegate*>(persistence_->reference_delegate())
+        ->garbage_collector();
+  }
+
+  /** Allocates a target for the given query and returns its ID. */
+  TargetId Listen(const core::Query& query) {
+    return local_store_.AllocateTarget(query.ToTarget()).target_id();
+  }
+
+  /**
+   * Applies a remote event adding all of the given documents, which must be in
+   * the same collection, to the given target.
+   */
+  void ApplyDocuments(const std::vector<Document>& docs,
+                      TargetId target_id) {
+    local_store_.ApplyRemoteEvent(AddedEvent(docs, target_id));
+  }
+
+  /** Returns a remote event adding the given documents to the given target. */
+  static RemoteEvent AddedEvent(const std::vector<Document>& docs,
+                                TargetId target_id) {
+    const ResourcePath& collection_path = docs[0].key().path().PopLast();
+    auto metadata_provider =
+        FakeTargetMetadataProvider::CreateEmptyResultProvider(collection_path,
+                                                              {target_id});
+    WatchChangeAggregator aggregator{&metadata_provider};
+    for (const Document& doc : docs) {
+      DocumentWatchChange change{{target_id}, {}, doc.key(), doc};
+      aggregator.HandleDocumentChange(change);
+    }
+    return aggregator.CreateRemoteEvent(docs[0].version());
+  }
+
+ private:
+  static std::unique_ptr<Persistence> MakePersistence(PersistenceType type) {
+    LruParams params = LruParams::WithCacheSize(0);
+    if (type == PersistenceType::Memory) {
+      return MemoryPersistenceWithLruGcForTesting(params);
+    }
+    return LevelDbPersistenceForTesting(params);
+  }
+
+  std::unique_ptr<Persistence> persistence_;
+  IndexFreeQueryEngine query_engine_;
+  LocalStore local_store_;
+};
+
+/** Applies a single remote event that adds or updates `range(0)` documents. */
+void BM_ApplyRemoteEvent(benchmark::State& state, PersistenceType type) {
+  int count = static_cast<int>(state.range(0));
+  LocalStoreHarness harness(type);
+  TargetId target_id = harness.Listen(Query("docs"));
+
+  int version = 1;
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    state.PauseTiming();
+    allocations.Pause();
+    RemoteEvent event = LocalStoreHarness::AddedEvent(
+        BenchmarkDocuments("docs", count, version++), target_id);
+    allocations.Resume();
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(harness.local_store()->ApplyRemoteEvent(event));
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_ApplyRemoteEvent, Memory, PersistenceType::Memory)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000);
+BENCHMARK_CAPTURE(BM_ApplyRemoteEvent, LevelDb, PersistenceType::LevelDb)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000);
+
+/**
+ * Executes `query` from scratch against a cache of `kCachedDocuments`
+ * documents, without previous results to start from.
+ */
+void ExecuteQuery(benchmark::State& state,
+                  PersistenceType type,
+                  const core::Query& query) {
+  LocalStoreHarness harness(type);
+  harness.ApplyDocuments(BenchmarkDocuments("docs", kCachedDocuments, 1),
+                         harness.Listen(Query("docs")));
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    QueryResult result = harness.local_store()->ExecuteQuery(
+        query, /* use_previous_results= */ false);
+    benchmark::DoNotOptimize(result.documents().size());
+  }
+  state.SetItemsProcessed(state.iterations() * kCachedDocuments);
+}
+
+/** Matches `range(0)` percent of the cached documents. */
+void BM_ExecuteQueryWithSelectivity(benchmark::State& state,
+                                    PersistenceType type) {
+  int percent = static_cast<int>(state.range(0));
+  ExecuteQuery(state, type,
+               Query("docs").AddingFilter(Filter("bucket", "<", percent)));
+}
+BENCHMARK_CAPTURE(BM_ExecuteQueryWithSelectivity,
+                  Memory,
+                  PersistenceType::Memory)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100);
+BENCHMARK_CAPTURE(BM_ExecuteQueryWithSelectivity,
+                  LevelDb,
+                  PersistenceType::LevelDb)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100);
+
+/** Returns the first `range(0)` of the cached documents ordered by value. */
+void BM_ExecuteQueryWithLimit(benchmark::State& state, PersistenceType type) {
+  ExecuteQuery(state, type,
+               Query("docs")
+                   .AddingOrderBy(OrderBy("value"))
+                   .WithLimitToFirst(static_cast<int>(state.range(0))));
+}
+BENCHMARK_CAPTURE(BM_ExecuteQueryWithLimit, Memory, PersistenceType::Memory)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000);
+BENCHMARK_CAPTURE(BM_ExecuteQueryWithLimit, LevelDb, PersistenceType::LevelDb)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000);
+
+/**
+ * Writes a batch of `range(0)` set mutations and acknowledges it, keeping the
+ * mutation queue short as a well-connected client would.
+ */
+void BM_WriteAndAcknowledge(benchmark::State& state, PersistenceType type) {
+  int count = static_cast<int>(state.range(0));
+  LocalStoreHarness harness(type);
+  LocalStore* local_store = harness.local_store();
+
+  int version = 1;
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    std::vector<Mutation> mutations;
+    for (int i = 0; i < count; ++i) {
+      mutations.push_back(testutil::SetMutation(
+          absl::StrCat("docs/doc", i),
+          Map("author", "me", "text", "Hello", "value", version)));
+    }
+    std::vector<Mutation> written = mutations;
+    LocalWriteResult result = local_store->WriteLocally(std::move(written));
+
+    MutationBatch batch(result.batch_id(), Timestamp::Now(), {},
+                        std::move(mutations));
+    model::SnapshotVersion commit_version = testutil::Version(version++);
+    std::vector<MutationResult> mutation_results(
+        count, MutationResult(commit_version, absl::nullopt));
+    benchmark::DoNotOptimize(local_store->AcknowledgeBatch(MutationBatchResult(
+        batch, commit_version, std::move(mutation_results), {})));
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_WriteAndAcknowledge, Memory, PersistenceType::Memory)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100);
+BENCHMARK_CAPTURE(BM_WriteAndAcknowledge, LevelDb, PersistenceType::LevelDb)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100);
+
+/**
+ * Collects garbage in a cache of `range(0)` inactive targets with 10 documents
+ * each, as after a session of browsing many screens.
+ */
+void BM_CollectGarbage(benchmark::State& state, PersistenceType type) {
+  constexpr int kDocumentsPerTarget = 10;
+  int targets = static_cast<int>(state.range(0));
+
+  std::unique_ptr<LocalStoreHarness> harness;
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    state.PauseTiming();
+    allocations.Pause();
+    harness.reset();
+    harness = absl::make_unique<LocalStoreHarness>(type);
+    for (int i = 0; i < targets; ++i) {
+      std::string collection = absl::StrCat("collection", i);
+      TargetId target_id = harness->Listen(Query(collection));
+      harness->ApplyDocuments(
+          BenchmarkDocuments(collection, kDocumentsPerTarget, i + 1),
+          target_id);
+      harness->local_store()->ReleaseTarget(target_id);
+    }
+    allocations.Resume();
+    state.ResumeTiming();
+
+    LruResults results =
+        harness->local_store()->CollectGarbage(harness->garbage_collector());
+    benchmark::DoNotOptimize(results.documents_removed);
+  }
+  state.SetItemsProcessed(state.iterations() * targets * kDocumentsPerTarget);
+}
+BENCHMARK_CAPTURE(BM_CollectGarbage, Memory, PersistenceType::Memory)
+    ->Arg(100)
+    ->Arg(1000);
+BENCHMARK_CAPTURE(BM_CollectGarbage, LevelDb, PersistenceType::LevelDb)
+    ->Arg(100)
+    ->Arg(1000);
+
+/**
+ * Measures a cold start against a persisted cache of `kCachedDocuments`
+ * documents that also holds pending writes from `range(0)` other users:
+ * opening the database, starting the local store and serving the first query
+ * from the cache.
+ */
+void BM_ColdStart(benchmark::State& state) {
+  constexpr int kBatchesPerUser = 10;
+  int other_users = static_cast<int>(state.range(0));
+  core::Query query = Query("docs").AddingFilter(Filter("bucket", "<", 1));
+
+  util::Path dir = LevelDbDir();
+  {
+    std::unique_ptr<LevelDbPersistence> persistence =
+        LevelDbPersistenceForTesting(dir);
+    IndexFreeQueryEngine query_engine;
+    for (int i = 0; i < other_users; ++i) {
+      LocalStore local_store(persistence.get(), &query_engine,
+                             User(absl::StrCat("user", i)));
+      local_store.Start();
+      for (int batch = 0; batch < kBatchesPerUser; ++batch) {
+        local_store.WriteLocally({testutil::SetMutation(
+            absl::StrCat("docs/pending", batch), Map("value", batch))});
+      }
+    }
+
+    LocalStore local_store(persistence.get(), &query_engine,
+                           User::Unauthenticated());
+    local_store.Start();
+    TargetId target_id =
+        local_store.AllocateTarget(Query("docs").ToTarget()).target_id();
+    local_store.ApplyRemoteEvent(LocalStoreHarness::AddedEvent(
+        BenchmarkDocuments("docs", kCachedDocuments, 1), target_id));
+    local_store.ReleaseTarget(target_id);
+    persistence->Shutdown();
+  }
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    std::unique_ptr<LevelDbPersistence> persistence =
+        LevelDbPersistenceForTesting(dir);
+    IndexFreeQueryEngine query_engine;
+    auto local_store = absl::make_unique<LocalStore>(
+        persistence.get(), &query_engine, User::Unauthenticated());
+    local_store->Start();
+    QueryResult result =
+        local_store->ExecuteQuery(query, /* use_previous_results= */ false);
+    benchmark::DoNotOptimize(result.documents().size());
+
+    state.PauseTiming();
+    allocations.Pause();
+    local_store.reset();
+    persistence->Shutdown();
+    persistence.reset();
+    allocations.Resume();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_ColdStart)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
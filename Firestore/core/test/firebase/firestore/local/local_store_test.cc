@@ -597,6 +597,36 @@ TEST_P(LocalStoreTest, HandlesPatchMutationThenDocumentThenAck) {
   FSTAssertContains(Doc("foo/bar", 2, Map("foo", "bar", "it", "base")));
 }
 
+TEST_P(LocalStoreTest, RecomputesLocalViewWhenBaseOrBatchesChange) {
+  core::Query query = Query("foo");
+  TargetId target_id = AllocateQuery(query);
+  ApplyRemoteEvent(
+      AddedRemoteEvent(Doc("foo/bar", 1, Map("it", "base")), {target_id}));
+
+  WriteMutation(testutil::PatchMutation("foo/bar", Map("foo", "bar"), {}));
+  FSTAssertContains(Doc("foo/bar", 1, Map("foo", "bar", "it", "base"),
+                        DocumentState::kLocalMutations));
+  // Reading again must produce the same view.
+  FSTAssertContains(Doc("foo/bar", 1, Map("foo", "bar", "it", "base"),
+                        DocumentState::kLocalMutations));
+
+  // A new remote version changes the base of the local view.
+  ApplyRemoteEvent(UpdateRemoteEvent(Doc("foo/bar", 2, Map("it", "changed")),
+                                     {target_id}, {}));
+  FSTAssertContains(Doc("foo/bar", 2, Map("foo", "bar", "it", "changed"),
+                        DocumentState::kLocalMutations));
+
+  // An additional batch changes the mutations applied on top of it.
+  WriteMutation(testutil::PatchMutation("foo/bar", Map("foo", "baz"), {}));
+  FSTAssertContains(Doc("foo/bar", 2, Map("foo", "baz", "it", "changed"),
+                        DocumentState::kLocalMutations));
+
+  // Rejecting the first batch leaves only the second one applied.
+  RejectMutation();
+  FSTAssertContains(Doc("foo/bar", 2, Map("foo", "baz", "it", "changed"),
+                        DocumentState::kLocalMutations));
+}
+
 TEST_P(LocalStoreTest, HandlesPatchMutationThenAckThenDocument) {
   WriteMutation(testutil::PatchMutation("foo/bar", Map("foo", "bar"), {}));
   FSTAssertRemoved("foo/bar");
@@ -1028,6 +1058,44 @@ TEST_P(LocalStoreTest, ReadsAllDocumentsForInitialCollectionQueries) {
   FSTAssertMutationsRead(/* by_key= */ 0, /* by_query= */ 1);
 }
 
+TEST_P(LocalStoreTest, ExecutesQueriesOverTheSameCollectionWithOneScan) {
+  core::Query query = Query("foo");
+  TargetId target_id = AllocateQuery(query);
+
+  ApplyRemoteEvent(UpdateRemoteEvent(Doc("foo/a", 10, Map("matches", true)),
+                                     {target_id}, {}));
+  ApplyRemoteEvent(UpdateRemoteEvent(Doc("foo/b", 20, Map("matches", false)),
+                                     {target_id}, {}));
+  WriteMutation(testutil::SetMutation("foo/c", Map("matches", true)));
+  WriteMutation(testutil::SetMutation("bar/a", Map("matches", true)));
+
+  core::Query matching =
+      Query("foo").AddingFilter(testutil::Filter("matches", "==", true));
+  core::Query limited = Query("foo").WithLimitToFirst(1);
+  core::Query other = Query("bar");
+
+  ResetPersistenceStats();
+
+  std::vector<core::Query> queries{matching, limited, query, other};
+  std::vector<QueryResult> results = local_store_.ExecuteQueries(queries);
+  ASSERT_EQ(queries.size(), results.size());
+
+  // One scan of "foo" and one of "bar".
+  FSTAssertRemoteDocumentsRead(/* by_key= */ 0, /* by_query= */ 2);
+  FSTAssertMutationsRead(/* by_key= */ 0, /* by_query= */ 2);
+
+  for (size_t i = 0; i != queries.size(); ++i) {
+    QueryResult expected = local_store_.ExecuteQuery(
+        queries[i], /* use_previous_results= */ false);
+    ASSERT_EQ(DocMapToArray(expected.documents()),
+              DocMapToArray(results[i].documents()));
+    ASSERT_EQ(expected.remote_keys(), results[i].remote_keys());
+  }
+
+  ASSERT_EQ(2u, results[0].documents().size());
+  ASSERT_EQ(3u, results[2].documents().size());
+}
+
 TEST_P(LocalStoreTest, PersistsResumeTokens) {
   // This test only works in the absence of the FSTEagerGarbageCollector.
   if (IsGcEager()) return;
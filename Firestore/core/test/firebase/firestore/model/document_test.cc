@@ -81,6 +81,22 @@ TEST(DocumentTest, Equality) {
   EXPECT_NE(doc, UnknownDocument(Key("same/path"), Version(1)));
 }
 
+TEST(DocumentTest, ComparesData) {
+  Document doc = Doc("some/path", 1, Map("a", 1, "b", Map("c", "d")));
+  EXPECT_TRUE(doc.HasEqualData(doc));
+  EXPECT_TRUE(doc.HasEqualData(
+      Doc("other/path", 2, Map("a", 1, "b", Map("c", "d")),
+          DocumentState::kLocalMutations)));
+  EXPECT_FALSE(doc.HasEqualData(Doc("some/path", 1, Map("a", 1))));
+  EXPECT_FALSE(
+      doc.HasEqualData(Doc("some/path", 1, Map("a", 1, "b", Map("c", "e")))));
+
+  // Comparing again uses the cached fingerprints, with the same results.
+  EXPECT_TRUE(doc.HasEqualData(doc));
+  EXPECT_FALSE(doc.HasEqualData(Doc("some/path", 1, Map("a", 2))));
+  EXPECT_EQ(doc, Doc("some/path", 1, Map("a", 1, "b", Map("c", "d"))));
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
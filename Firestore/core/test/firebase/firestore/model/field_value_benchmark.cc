@@ -19,8 +19,11 @@
 #include <limits>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/variant.h"
 #include "benchmark/benchmark.h"
 
@@ -47,6 +50,7 @@ void BM_FieldValueStringCopy(benchmark::State& state) {
   auto len = static_cast<size_t>(state.range(0));
   FieldValue str = FieldValue::FromString(RandomString(&rnd, len));
 
+  testutil::AllocationCounter allocations{state};
   for (auto _ : state) {
     FieldValue copy = str;
   }
@@ -69,6 +73,7 @@ void BM_FieldValueStringHash(benchmark::State& state) {
   auto len = static_cast<size_t>(state.range(0));
   FieldValue str = FieldValue::FromString(RandomString(&rnd, len));
 
+  testutil::AllocationCounter allocations{state};
   for (auto _ : state) {
     str.Hash();
   }
@@ -86,6 +91,7 @@ BENCHMARK(BM_FieldValueStringHash)
 
 void BM_FieldValueIntegerFill(benchmark::State& state) {
   std::vector<FieldValue> values;
+  testutil::AllocationCounter allocations{state};
   for (auto _ : state) {
     values.push_back(FieldValue::FromInteger(42));
   }
@@ -98,6 +104,7 @@ void BM_FieldValueStringFill(benchmark::State& state) {
   std::string str = RandomString(&rnd, len);
 
   std::vector<FieldValue> values;
+  testutil::AllocationCounter allocations{state};
   for (auto _ : state) {
     values.push_back(FieldValue::FromString(str));
   }
@@ -151,6 +158,7 @@ void BM_FieldValueCreation(benchmark::State& state) {
 
   std::vector<FieldValue> values;
   int i = 0;
+  testutil::AllocationCounter allocations{state};
   for (auto _ : state) {
     values.push_back(absl::visit(visitor, input[i]));
 
@@ -159,6 +167,28 @@ void BM_FieldValueCreation(benchmark::State& state) {
 }
 BENCHMARK(BM_FieldValueCreation);
 
+/**
+ * Sets a nested field in an object with `range(0)` top-level fields, as
+ * applying a patch to a document does.
+ */
+void BM_ObjectValueSet(benchmark::State& state) {
+  FieldValue::Map fields;
+  for (int i = 0; i < state.range(0); ++i) {
+    fields =
+        fields.insert(absl::StrCat("field", i), FieldValue::FromInteger(i));
+  }
+  ObjectValue object = ObjectValue::FromMap(fields);
+  FieldPath path = testutil::Field("nested.value");
+
+  int i = 0;
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    ObjectValue updated = object.Set(path, FieldValue::FromInteger(i++));
+    benchmark::DoNotOptimize(updated);
+  }
+}
+BENCHMARK(BM_ObjectValueSet)->Arg(10)->Arg(100)->Arg(1000);
+
 }  // namespace
 }  // namespace model
 }  // namespace firestore
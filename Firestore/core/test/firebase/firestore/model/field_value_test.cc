@@ -237,6 +237,93 @@ TEST_F(FieldValueTest, DeletesNestedKeys) {
   EXPECT_EQ(ObjectValue::Empty(), mod);
 }
 
+TEST_F(FieldValueTest, BuilderWithoutChangesReturnsBase) {
+  ObjectValue old = WrapObject("a", Map("b", 1));
+  ObjectValue built = ObjectValue::Builder(old).Build();
+  EXPECT_EQ(old, built);
+}
+
+TEST_F(FieldValueTest, BuilderSetsFields) {
+  ObjectValue old = WrapObject("a", "old", "b", Map("c", 1));
+  ObjectValue mod = ObjectValue::Builder(old)
+                        .Set(Field("a"), Value("mod"))
+                        .Set(Field("b.d"), Value(2))
+                        .Set(Field("e.f.g"), Value(3))
+                        .Build();
+
+  EXPECT_EQ(WrapObject("a", "old", "b", Map("c", 1)), old);
+  EXPECT_EQ(WrapObject("a", "mod", "b", Map("c", 1, "d", 2), "e",
+                       Map("f", Map("g", 3))),
+            mod);
+}
+
+TEST_F(FieldValueTest, BuilderDeletesFields) {
+  ObjectValue old = WrapObject("a", Map("b", 1, "c", Map("d", 2, "e", 3)));
+  ObjectValue mod = ObjectValue::Builder(old)
+                        .Delete(Field("a.c.d"))
+                        .Delete(Field("a.b"))
+                        .Delete(Field("missing"))
+                        .Delete(Field("a.b.c"))
+                        .Build();
+
+  EXPECT_EQ(WrapObject("a", Map("c", Map("e", 3))), mod);
+}
+
+TEST_F(FieldValueTest, BuilderAppliesOperationsInOrder) {
+  ObjectValue old = WrapObject("a", Map("b", 1), "c", 2);
+
+  // Overwriting an object with a primitive and then setting a nested field
+  // replaces the primitive with a new object.
+  ObjectValue mod = ObjectValue::Builder(old)
+                        .Set(Field("a"), Value(5))
+                        .Set(Field("a.d"), Value(6))
+                        .Build();
+  EXPECT_EQ(WrapObject("a", Map("d", 6), "c", 2), mod);
+
+  // Deleting a parent and then a nested field leaves the parent deleted.
+  mod = ObjectValue::Builder(old)
+            .Delete(Field("a"))
+            .Delete(Field("a.b"))
+            .Build();
+  EXPECT_EQ(WrapObject("c", 2), mod);
+
+  // Setting an object and then modifying it builds on the new object.
+  mod = ObjectValue::Builder(old)
+            .Set(Field("c"), WrapObject("x", 1))
+            .Set(Field("c.y"), Value(2))
+            .Delete(Field("c.x"))
+            .Build();
+  EXPECT_EQ(WrapObject("a", Map("b", 1), "c", Map("y", 2)), mod);
+
+  // Deleting through a primitive has no effect.
+  mod = ObjectValue::Builder(old).Delete(Field("c.d")).Build();
+  EXPECT_EQ(old, mod);
+}
+
+TEST_F(FieldValueTest, BuilderMatchesSequentialOperations) {
+  ObjectValue old =
+      WrapObject("a", Map("b", 1, "c", Map("d", 2)), "e", 3, "f", Map());
+  std::vector<std::pair<std::string, absl::optional<FieldValue>>> operations{
+      {"a.c.d", Value(4)}, {"a.b", nullopt},      {"e.g", Value(5)},
+      {"f.h.i", Value(6)}, {"a.c", nullopt},      {"a.c.j", Value(7)},
+      {"e", nullopt},      {"e.g.k", nullopt},    {"z", Value(8)},
+      {"f.h", Value(9)},   {"f.h.l", Value(10)},  {"a", nullopt},
+  };
+
+  ObjectValue::Builder builder(old);
+  ObjectValue expected = old;
+  for (const auto& operation : operations) {
+    if (operation.second) {
+      builder.Set(Field(operation.first), *operation.second);
+      expected = expected.Set(Field(operation.first), *operation.second);
+    } else {
+      builder.Delete(Field(operation.first));
+      expected = expected.Delete(Field(operation.first));
+    }
+    EXPECT_EQ(expected, builder.Build()) << "After " << operation.first;
+  }
+}
+
 #if defined(_WIN32)
 #define timegm _mkgmtime
 
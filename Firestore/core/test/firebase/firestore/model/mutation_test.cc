@@ -411,6 +411,58 @@ TEST(MutationTest, AppliesLocalArrayRemoveTransformWithNonPrimitiveElements) {
   TransformBaseDoc(base_data, transforms, expected);
 }
 
+TEST(MutationTest, AppliesLocalArrayUnionTransformToLargeArray) {
+  // Large enough to use the hashed implementation. The existing array contains
+  // duplicates, which union leaves alone.
+  FieldValue::Array existing;
+  for (int i = 0; i < 100; ++i) {
+    existing.push_back(Value(i % 50));
+  }
+  std::vector<FieldValue> elements;
+  for (int i = 120; i >= 0; i -= 3) {
+    elements.push_back(Value(i));
+    elements.push_back(Value(i));
+  }
+
+  FieldValue::Array expected = existing;
+  for (int i = 120; i >= 50; i -= 3) {
+    expected.push_back(Value(i));
+  }
+
+  TransformPairs transforms = {
+      {"array", ArrayTransform(TransformOperation::Type::ArrayUnion,
+                               std::move(elements))}};
+  TransformBaseDoc(Map("array", FieldValue::FromArray(existing)), transforms,
+                   Map("array", FieldValue::FromArray(expected)));
+}
+
+TEST(MutationTest, AppliesLocalArrayRemoveTransformToLargeArray) {
+  // Each listed element removes its first remaining occurrence, so listing 0
+  // twice removes both copies while 1 is only removed once.
+  FieldValue::Array existing;
+  for (int i = 0; i < 100; ++i) {
+    existing.push_back(Value(i % 50));
+  }
+  std::vector<FieldValue> elements = {Value(0), Value(1), Value(0)};
+  for (int i = 10; i < 60; ++i) {
+    elements.push_back(Value(i));
+  }
+
+  FieldValue::Array expected;
+  for (int i = 0; i < 100; ++i) {
+    int value = i % 50;
+    bool removed = i < 50 ? (value == 0 || value == 1 || value >= 10)
+                          : (value == 0);
+    if (!removed) expected.push_back(Value(value));
+  }
+
+  TransformPairs transforms = {
+      {"array", ArrayTransform(TransformOperation::Type::ArrayRemove,
+                               std::move(elements))}};
+  TransformBaseDoc(Map("array", FieldValue::FromArray(existing)), transforms,
+                   Map("array", FieldValue::FromArray(expected)));
+}
+
 TEST(MutationTest, AppliesServerAckedIncrementTransformToDocuments) {
   Document base_doc = Doc("collection/key", 0, Map("sum", 1));
 
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/transform_operation.h"
+
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/transform_mutation.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace {
+
+using Type = TransformOperation::Type;
+
+using testutil::Doc;
+using testutil::Map;
+using testutil::TransformMutation;
+using testutil::WrapObject;
+
+/** Returns an array of `size` distinct integers starting at `start`. */
+std::vector<FieldValue> Integers(int64_t start, int64_t size) {
+  std::vector<FieldValue> result;
+  result.reserve(static_cast<size_t>(size));
+  for (int64_t i = start; i < start + size; ++i) {
+    result.push_back(FieldValue::FromInteger(i));
+  }
+  return result;
+}
+
+/**
+ * Applies an array transform with `state.range(1)` elements, half of which are
+ * already present, to a document holding an array of `state.range(0)`
+ * elements.
+ */
+void ApplyArrayTransform(benchmark::State& state, Type type) {
+  int64_t array_size = state.range(0);
+  int64_t elements_size = state.range(1);
+
+  Document doc = Doc("collection/key", 0,
+                     Map("array", FieldValue::FromArray(Integers(
+                                      0, array_size))));
+  Mutation mutation = TransformMutation(
+      "collection/key",
+      {{"array", ArrayTransform(type, Integers(array_size - elements_size / 2,
+                                               elements_size))}});
+  Timestamp now = Timestamp::Now();
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    auto result = mutation.ApplyToLocalView(doc, doc, now);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * elements_size);
+}
+
+void BM_ArrayUnion(benchmark::State& state) {
+  ApplyArrayTransform(state, Type::ArrayUnion);
+}
+BENCHMARK(BM_ArrayUnion)
+    ->Args({10, 1})
+    ->Args({10, 10})
+    ->Args({1000, 10})
+    ->Args({1000, 1000})
+    ->Args({5000, 100})
+    ->Args({5000, 5000});
+
+void BM_ArrayRemove(benchmark::State& state) {
+  ApplyArrayTransform(state, Type::ArrayRemove);
+}
+BENCHMARK(BM_ArrayRemove)
+    ->Args({10, 1})
+    ->Args({10, 10})
+    ->Args({1000, 10})
+    ->Args({1000, 1000})
+    ->Args({5000, 100})
+    ->Args({5000, 5000});
+
+/** Unions arrays of maps, whose hashes and comparisons are more expensive. */
+void BM_ArrayUnionOfMaps(benchmark::State& state) {
+  int64_t size = state.range(0);
+
+  std::vector<FieldValue> existing;
+  std::vector<FieldValue> elements;
+  for (int64_t i = 0; i < size; ++i) {
+    existing.push_back(WrapObject("id", i, "name", "existing"));
+    elements.push_back(WrapObject("id", i, "name", i % 2 == 0 ? "existing" : "new"));
+  }
+
+  Document doc =
+      Doc("collection/key", 0, Map("array", FieldValue::FromArray(existing)));
+  Mutation mutation = TransformMutation(
+      "collection/key",
+      {{"array", ArrayTransform(Type::ArrayUnion, std::move(elements))}});
+  Timestamp now = Timestamp::Now();
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    auto result = mutation.ApplyToLocalView(doc, doc, now);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ArrayUnionOfMaps)->Arg(10)->Arg(100)->Arg(1000)->Arg(5000);
+
+}  // namespace
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
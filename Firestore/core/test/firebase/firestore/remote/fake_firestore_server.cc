@@ -0,0 +1,412 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/firebase/firestore/remote/fake_firestore_server.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <deque>
+#include <functional>
+#include <utility>
+
+#include "Firestore/Protos/cpp/google/firestore/v1/firestore.pb.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/test/firebase/firestore/util/grpc_stream_tester.h"
+#include "absl/strings/str_cat.h"
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server_builder.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+namespace v1 = google::firestore::v1;
+
+using util::ByteBufferToString;
+using util::MakeByteBuffer;
+
+constexpr char kListen[] = "/google.firestore.v1.Firestore/Listen";
+constexpr char kWrite[] = "/google.firestore.v1.Firestore/Write";
+constexpr char kCommit[] = "/google.firestore.v1.Firestore/Commit";
+constexpr char kBatchGet[] =
+    "/google.firestore.v1.Firestore/BatchGetDocuments";
+
+/**
+ * The object behind every completion queue tag: the callback to invoke with
+ * the `ok` result of the operation. Deleted once the callback has run.
+ */
+struct Tag {
+  std::function<void(bool)> callback;
+};
+
+void* MakeTag(std::function<void(bool)> callback) {
+  return new Tag{std::move(callback)};
+}
+
+void SetTimestamp(int64_t micros, google::protobuf::Timestamp* timestamp) {
+  timestamp->set_seconds(micros / 1000000);
+  timestamp->set_nanos(static_cast<int32_t>(micros % 1000000) * 1000);
+}
+
+template <typename Message>
+Message Parse(const grpc::ByteBuffer& buffer) {
+  Message message;
+  bool parsed = message.ParseFromString(ByteBufferToString(buffer));
+  HARD_ASSERT(parsed, "Fake Firestore server received a malformed request");
+  return message;
+}
+
+template <typename Message>
+grpc::ByteBuffer Serialize(const Message& message) {
+  return MakeByteBuffer(message.SerializeAsString());
+}
+
+}  // namespace
+
+/**
+ * A single RPC of any kind. Incoming messages are read one at a time and
+ * handed to the server; responses are queued and written one at a time. Once
+ * the client is done sending, the call finishes as soon as all responses have
+ * been written.
+ *
+ * All methods run with the server mutex held.
+ */
+class FakeFirestoreServer::Call {
+ public:
+  explicit Call(FakeFirestoreServer* server)
+      : server_{server}, stream_{&context_} {
+  }
+
+  grpc::GenericServerContext* context() {
+    return &context_;
+  }
+  grpc::GenericServerAsyncReaderWriter* stream() {
+    return &stream_;
+  }
+
+  /** The number of messages received so far. */
+  int messages_read() const {
+    return messages_read_;
+  }
+
+  void Start() {
+    const std::string& method = context_.method();
+    if (method == kListen) {
+      handler_ = &FakeFirestoreServer::HandleListen;
+    } else if (method == kWrite) {
+      handler_ = &FakeFirestoreServer::HandleWrite;
+    } else if (method == kCommit) {
+      handler_ = &FakeFirestoreServer::HandleCommit;
+    } else if (method == kBatchGet) {
+      handler_ = &FakeFirestoreServer::HandleBatchGet;
+    } else {
+      status_ = grpc::Status{grpc::StatusCode::UNIMPLEMENTED,
+                             absl::StrCat("Unsupported method ", method)};
+    }
+    Read();
+  }
+
+  void Write(grpc::ByteBuffer message) {
+    pending_writes_.push_back(std::move(message));
+    if (!writing_) WriteNext();
+  }
+
+ private:
+  void Read() {
+    if (server_->shutting_down_) return;
+
+    stream_.Read(&read_buffer_, MakeTag([this](bool ok) {
+                   if (!ok) {
+                     // The client is done sending, or the call was cancelled.
+                     reading_done_ = true;
+                     MaybeFinish();
+                     return;
+                   }
+                   ++messages_read_;
+                   if (handler_) (server_->*handler_)(this, read_buffer_);
+                   Read();
+                 }));
+  }
+
+  void WriteNext() {
+    if (pending_writes_.empty() || server_->shutting_down_) {
+      writing_ = false;
+      MaybeFinish();
+      return;
+    }
+
+    writing_ = true;
+    write_buffer_ = std::move(pending_writes_.front());
+    pending_writes_.pop_front();
+    stream_.Write(write_buffer_, MakeTag([this](bool ok) {
+                    // Responses to a cancelled call are dropped.
+                    if (!ok) pending_writes_.clear();
+                    WriteNext();
+                  }));
+  }
+
+  void MaybeFinish() {
+    if (!reading_done_ || writing_ || finishing_ || server_->shutting_down_) {
+      return;
+    }
+
+    finishing_ = true;
+    stream_.Finish(status_, MakeTag([this](bool) { server_->Delete(this); }));
+  }
+
+  using Handler = void (FakeFirestoreServer::*)(Call*,
+                                                const grpc::ByteBuffer&);
+
+  FakeFirestoreServer* server_ = nullptr;
+  grpc::GenericServerContext context_;
+  grpc::GenericServerAsyncReaderWriter stream_;
+  Handler handler_ = nullptr;
+  grpc::Status status_;
+
+  grpc::ByteBuffer read_buffer_;
+  int messages_read_ = 0;
+  bool reading_done_ = false;
+
+  std::deque<grpc::ByteBuffer> pending_writes_;
+  grpc::ByteBuffer write_buffer_;
+  bool writing_ = false;
+  bool finishing_ = false;
+};
+
+// MARK: - FakeFirestoreServer
+
+FakeFirestoreServer::FakeFirestoreServer() {
+  int port = 0;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort("localhost:0", grpc::InsecureServerCredentials(),
+                           &port);
+  builder.RegisterAsyncGenericService(&service_);
+  queue_ = builder.AddCompletionQueue();
+  server_ = builder.BuildAndStart();
+  HARD_ASSERT(server_ && port != 0, "Failed to start fake Firestore server");
+  host_ = absl::StrCat("localhost:", port);
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    RequestCall();
+  }
+  polling_thread_ = std::thread([this] { PollQueue(); });
+}
+
+FakeFirestoreServer::~FakeFirestoreServer() {
+  {
+    // Once this is set, no new operations are started, so none can be added
+    // to the completion queue after it's shut down.
+    std::lock_guard<std::mutex> lock{mutex_};
+    shutting_down_ = true;
+  }
+  server_->Shutdown(std::chrono::system_clock::now());
+  queue_->Shutdown();
+  polling_thread_.join();
+
+  // The queue has been drained, so no tags refer to the remaining calls.
+  for (Call* call : calls_) {
+    delete call;
+  }
+}
+
+void FakeFirestoreServer::set_initial_documents(int count) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  initial_documents_ = count;
+}
+
+void FakeFirestoreServer::set_updates(int batches, int documents_per_update) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  update_batches_ = batches;
+  documents_per_update_ = documents_per_update;
+}
+
+int64_t FakeFirestoreServer::acknowledged_writes() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return acknowledged_writes_;
+}
+
+void FakeFirestoreServer::RequestCall() {
+  if (shutting_down_) return;
+
+  auto call = new Call(this);
+  calls_.insert(call);
+  service_.RequestCall(call->context(), call->stream(), queue_.get(),
+                       queue_.get(), MakeTag([this, call](bool ok) {
+                         if (!ok) {
+                           // The server is shutting down.
+                           Delete(call);
+                           return;
+                         }
+                         RequestCall();
+                         call->Start();
+                       }));
+}
+
+void FakeFirestoreServer::PollQueue() {
+  void* raw_tag = nullptr;
+  bool ok = false;
+  while (queue_->Next(&raw_tag, &ok)) {
+    std::unique_ptr<Tag> tag{static_cast<Tag*>(raw_tag)};
+    std::lock_guard<std::mutex> lock{mutex_};
+    tag->callback(ok);
+  }
+}
+
+void FakeFirestoreServer::Delete(Call* call) {
+  calls_.erase(call);
+  delete call;
+}
+
+int64_t FakeFirestoreServer::NextVersion() {
+  return ++last_version_;
+}
+
+void FakeFirestoreServer::HandleListen(Call* call,
+                                       const grpc::ByteBuffer& message) {
+  auto request = Parse<v1::ListenRequest>(message);
+
+  if (request.has_remove_target()) {
+    v1::ListenResponse response;
+    v1::TargetChange* change = response.mutable_target_change();
+    change->set_target_change_type(v1::TargetChange::REMOVE);
+    change->add_target_ids(request.remove_target());
+    call->Write(Serialize(response));
+    return;
+  }
+  if (!request.has_add_target()) return;
+
+  const v1::Target& target = request.add_target();
+  int32_t target_id = target.target_id();
+
+  // The names of the documents in the target: the requested ones for document
+  // targets, and generated ones in the queried collection otherwise.
+  std::vector<std::string> names;
+  if (target.has_documents()) {
+    for (const std::string& name : target.documents().documents()) {
+      names.push_back(name);
+    }
+  } else {
+    const v1::Target::QueryTarget& query = target.query();
+    std::string collection_id =
+        query.structured_query().from_size() > 0
+            ? query.structured_query().from(0).collection_id()
+            : "docs";
+    for (int i = 0; i < initial_documents_; ++i) {
+      names.push_back(
+          absl::StrCat(query.parent(), "/", collection_id, "/doc", i));
+    }
+  }
+
+  auto write_target_change = [&](v1::TargetChange::TargetChangeType type,
+                                 bool global) {
+    v1::ListenResponse response;
+    v1::TargetChange* change = response.mutable_target_change();
+    change->set_target_change_type(type);
+    if (global) {
+      SetTimestamp(NextVersion(), change->mutable_read_time());
+    } else {
+      change->add_target_ids(target_id);
+    }
+    if (type == v1::TargetChange::CURRENT) {
+      change->set_resume_token(absl::StrCat("resume", last_version_));
+    }
+    call->Write(Serialize(response));
+  };
+
+  auto write_document = [&](const std::string& name, int64_t value) {
+    v1::ListenResponse response;
+    v1::DocumentChange* change = response.mutable_document_change();
+    change->add_target_ids(target_id);
+    v1::Document* document = change->mutable_document();
+    document->set_name(name);
+    (*document->mutable_fields())["value"].set_integer_value(value);
+    int64_t version = NextVersion();
+    SetTimestamp(version, document->mutable_create_time());
+    SetTimestamp(version, document->mutable_update_time());
+    call->Write(Serialize(response));
+  };
+
+  write_target_change(v1::TargetChange::ADD, /*global=*/false);
+  for (const std::string& name : names) {
+    write_document(name, 0);
+  }
+  write_target_change(v1::TargetChange::CURRENT, /*global=*/false);
+  write_target_change(v1::TargetChange::NO_CHANGE, /*global=*/true);
+
+  if (names.empty()) return;
+  size_t next = 0;
+  for (int batch = 1; batch <= update_batches_; ++batch) {
+    for (int i = 0; i < documents_per_update_; ++i) {
+      write_document(names[next], batch);
+      next = (next + 1) % names.size();
+    }
+    write_target_change(v1::TargetChange::NO_CHANGE, /*global=*/true);
+  }
+}
+
+void FakeFirestoreServer::HandleWrite(Call* call,
+                                      const grpc::ByteBuffer& message) {
+  auto request = Parse<v1::WriteRequest>(message);
+
+  v1::WriteResponse response;
+  response.set_stream_id("fake-stream");
+  response.set_stream_token(absl::StrCat("token", NextVersion()));
+
+  // The first request on a stream is the handshake, which carries no writes.
+  if (call->messages_read() > 1) {
+    int64_t version = NextVersion();
+    SetTimestamp(version, response.mutable_commit_time());
+    for (int i = 0; i < request.writes_size(); ++i) {
+      SetTimestamp(version,
+                   response.add_write_results()->mutable_update_time());
+    }
+    acknowledged_writes_ += request.writes_size();
+  }
+  call->Write(Serialize(response));
+}
+
+void FakeFirestoreServer::HandleCommit(Call* call,
+                                       const grpc::ByteBuffer& message) {
+  auto request = Parse<v1::CommitRequest>(message);
+
+  v1::CommitResponse response;
+  int64_t version = NextVersion();
+  SetTimestamp(version, response.mutable_commit_time());
+  for (int i = 0; i < request.writes_size(); ++i) {
+    SetTimestamp(version, response.add_write_results()->mutable_update_time());
+  }
+  acknowledged_writes_ += request.writes_size();
+  call->Write(Serialize(response));
+}
+
+void FakeFirestoreServer::HandleBatchGet(Call* call,
+                                         const grpc::ByteBuffer& message) {
+  auto request = Parse<v1::BatchGetDocumentsRequest>(message);
+
+  int64_t version = NextVersion();
+  for (const std::string& name : request.documents()) {
+    v1::BatchGetDocumentsResponse response;
+    response.set_missing(name);
+    SetTimestamp(version, response.mutable_read_time());
+    call->Write(Serialize(response));
+  }
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_REMOTE_FAKE_FIRESTORE_SERVER_H_
+#define FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_REMOTE_FAKE_FIRESTORE_SERVER_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "grpcpp/completion_queue.h"
+#include "grpcpp/generic/async_generic_service.h"
+#include "grpcpp/server.h"
+#include "grpcpp/support/byte_buffer.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * An in-process gRPC server that implements enough of the Firestore v1 API
+ * (`Listen`, `Write`, `Commit` and `BatchGetDocuments`) to drive a
+ * `FirestoreClient` over loopback, without network access or a real backend.
+ *
+ * The server does not store documents. Instead:
+ *
+ *   - every listen target receives `initial_documents` generated documents,
+ *     becomes current and is followed by a global snapshot, and then receives
+ *     `update_batches` batches that each modify `documents_per_update` of
+ *     those documents, each followed by its own global snapshot;
+ *   - every write, on the write stream or in a commit, is acknowledged
+ *     immediately;
+ *   - every document requested from `BatchGetDocuments` is reported missing.
+ *
+ * Versions are drawn from a single increasing clock, so snapshots are always
+ * consistent from the client's point of view. Configuration applies to
+ * targets added after it is set.
+ */
+class FakeFirestoreServer {
+ public:
+  /** Starts serving on an unused port on localhost. */
+  FakeFirestoreServer();
+
+  /** Cancels all active calls and stops serving. */
+  ~FakeFirestoreServer();
+
+  FakeFirestoreServer(const FakeFirestoreServer&) = delete;
+  FakeFirestoreServer& operator=(const FakeFirestoreServer&) = delete;
+
+  /**
+   * The "host:port" address of the server, suitable for a `DatabaseInfo` with
+   * SSL disabled.
+   */
+  const std::string& host() const {
+    return host_;
+  }
+
+  /** Sets the number of documents each new query target receives. */
+  void set_initial_documents(int count);
+
+  /**
+   * Sets the number of update batches each new target receives once current,
+   * and the number of documents each batch modifies.
+   */
+  void set_updates(int batches, int documents_per_update);
+
+  /** The number of writes acknowledged so far, by streams and commits. */
+  int64_t acknowledged_writes() const;
+
+ private:
+  class Call;
+
+  /** Accepts the next incoming call. */
+  void RequestCall();
+  void PollQueue();
+  void Delete(Call* call);
+
+  void HandleListen(Call* call, const grpc::ByteBuffer& message);
+  void HandleWrite(Call* call, const grpc::ByteBuffer& message);
+  void HandleCommit(Call* call, const grpc::ByteBuffer& message);
+  void HandleBatchGet(Call* call, const grpc::ByteBuffer& message);
+
+  /** Returns a version later than any previously returned one. */
+  int64_t NextVersion();
+
+  grpc::AsyncGenericService service_;
+  std::unique_ptr<grpc::ServerCompletionQueue> queue_;
+  std::unique_ptr<grpc::Server> server_;
+  std::thread polling_thread_;
+  std::string host_;
+
+  // Guards everything below. Completion queue events are handled with the
+  // mutex held, so calls only ever see a consistent configuration.
+  mutable std::mutex mutex_;
+  bool shutting_down_ = false;
+  std::set<Call*> calls_;
+
+  int initial_documents_ = 10;
+  int update_batches_ = 0;
+  int documents_per_update_ = 0;
+
+  int64_t last_version_ = 0;
+  int64_t acknowledged_writes_ = 0;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_REMOTE_FAKE_FIRESTORE_SERVER_H_
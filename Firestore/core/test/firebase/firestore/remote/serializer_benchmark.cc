@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/message.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using model::DatabaseId;
+using model::FieldValue;
+using model::MaybeDocument;
+using model::ObjectValue;
+using nanopb::ByteString;
+using nanopb::Message;
+using nanopb::StringReader;
+
+using testutil::Array;
+using testutil::Key;
+using testutil::Map;
+using testutil::Version;
+
+/**
+ * Returns the bytes of a `BatchGetDocumentsResponse` for a document with
+ * `groups` groups of fields, each shaped like a typical app document.
+ */
+ByteString EncodedDocument(const Serializer& serializer, int groups) {
+  FieldValue::Map fields;
+  for (int i = 0; i < groups; ++i) {
+    fields = fields.insert(
+        absl::StrCat("group", i),
+        FieldValue::FromMap(Map("author", absl::StrCat("user", i), "text",
+                                "The quick brown fox jumps over the lazy dog",
+                                "tags", Array("one", "two", "three"), "value",
+                                i, "meta", Map("likes", i * 10))));
+  }
+
+  Message<google_firestore_v1_BatchGetDocumentsResponse> response;
+  response->which_result =
+      google_firestore_v1_BatchGetDocumentsResponse_found_tag;
+  response->found = serializer.EncodeDocument(Key("docs/doc"),
+                                              ObjectValue::FromMap(fields));
+  response->found.has_update_time = true;
+  response->found.update_time = Serializer::EncodeVersion(Version(1));
+  return MakeByteString(response);
+}
+
+/** Parses and decodes a document, as handling a watch change or read does. */
+void BM_DecodeDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId("project", "database")};
+  ByteString bytes =
+      EncodedDocument(serializer, static_cast<int>(state.range(0)));
+
+  testutil::AllocationCounter allocations{state};
+  for (auto _ : state) {
+    StringReader reader{bytes};
+    auto response =
+        Message<google_firestore_v1_BatchGetDocumentsResponse>::TryParse(
+            &reader);
+    MaybeDocument document = serializer.DecodeMaybeDocument(&reader, *response);
+    HARD_ASSERT(reader.ok(), "Failed to decode: %s",
+                reader.status().ToString());
+    benchmark::DoNotOptimize(document);
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_DecodeDocument)->Arg(1)->Arg(10)->Arg(100);
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_tracking.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace firebase {
+namespace firestore {
+namespace testutil {
+
+namespace {
+
+// Every allocation is prefixed with its size so that the bytes still in use
+// can be tracked.
+constexpr std::size_t kHeaderSize = alignof(std::max_align_t);
+
+// Constant-initialized, so they're usable by allocations made during static
+// initialization.
+std::atomic<int64_t> allocation_count{0};
+std::atomic<int64_t> allocated_bytes{0};
+std::atomic<int64_t> live_bytes{0};
+
+/** Returns null on failure, like `malloc`. */
+void* Allocate(std::size_t size) {
+  void* block = nullptr;
+  while (!(block = std::malloc(size + kHeaderSize))) {
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) return nullptr;
+    handler();
+  }
+
+  *static_cast<std::size_t*>(block) = size;
+  auto signed_size = static_cast<int64_t>(size);
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(signed_size, std::memory_order_relaxed);
+  live_bytes.fetch_add(signed_size, std::memory_order_relaxed);
+  return static_cast<char*>(block) + kHeaderSize;
+}
+
+void Deallocate(void* pointer) {
+  if (!pointer) return;
+
+  void* block = static_cast<char*>(pointer) - kHeaderSize;
+  auto size = static_cast<int64_t>(*static_cast<std::size_t*>(block));
+  live_bytes.fetch_sub(size, std::memory_order_relaxed);
+  std::free(block);
+}
+
+void Subtract(AllocationStats* lhs, const AllocationStats& rhs) {
+  lhs->allocations -= rhs.allocations;
+  lhs->bytes -= rhs.bytes;
+}
+
+void Add(AllocationStats* lhs, const AllocationStats& rhs) {
+  lhs->allocations += rhs.allocations;
+  lhs->bytes += rhs.bytes;
+}
+
+}  // namespace
+
+AllocationStats GetAllocationStats() {
+  AllocationStats result;
+  result.allocations = allocation_count.load(std::memory_order_relaxed);
+  result.bytes = allocated_bytes.load(std::memory_order_relaxed);
+  result.live_bytes = live_bytes.load(std::memory_order_relaxed);
+  return result;
+}
+
+AllocationCounter::AllocationCounter(benchmark::State& state)
+    : state_(state), start_(GetAllocationStats()) {
+}
+
+AllocationCounter::~AllocationCounter() {
+  Pause();
+  state_.counters["allocs/iter"] = benchmark::Counter(
+      static_cast<double>(counted_.allocations),
+      benchmark::Counter::kAvgIterations);
+  state_.counters["bytes/iter"] = benchmark::Counter(
+      static_cast<double>(counted_.bytes), benchmark::Counter::kAvgIterations);
+}
+
+void AllocationCounter::Pause() {
+  if (paused_) return;
+
+  AllocationStats delta = GetAllocationStats();
+  Subtract(&delta, start_);
+  Add(&counted_, delta);
+  paused_ = true;
+}
+
+void AllocationCounter::Resume() {
+  if (!paused_) return;
+
+  start_ = GetAllocationStats();
+  paused_ = false;
+}
+
+}  // namespace testutil
+}  // namespace firestore
+}  // namespace firebase
+
+// Replacements for the global allocation functions. The remaining forms of
+// `operator new` and `operator delete`, such as sized deallocation, forward to
+// these by default.
+
+void* operator new(std::size_t size) {
+  void* result = firebase::firestore::testutil::Allocate(size);
+  if (!result) throw std::bad_alloc();
+  return result;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return firebase::firestore::testutil::Allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return firebase::firestore::testutil::Allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+  firebase::firestore::testutil::Deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+  firebase::firestore::testutil::Deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  firebase::firestore::testutil::Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+  firebase::firestore::testutil::Deallocate(pointer);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_ALLOCATION_TRACKING_H_
+#define FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_ALLOCATION_TRACKING_H_
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace testutil {
+
+/**
+ * Totals of heap allocations made through `operator new` by all threads
+ * since the process started, and the bytes still in use.
+ *
+ * Only available in binaries that link the allocation tracking library,
+ * which replaces the global `operator new` and `operator delete`. Intended for
+ * benchmarks and tests; never link it into the SDK itself.
+ */
+struct AllocationStats {
+  int64_t allocations = 0;
+  int64_t bytes = 0;
+  int64_t live_bytes = 0;
+};
+
+AllocationStats GetAllocationStats();
+
+/**
+ * Reports the heap allocations made while a benchmark runs as the counters
+ * "allocs/iter" and "bytes/iter", averaged over the iterations. Create it
+ * right before the benchmark loop, after any setup:
+ *
+ *     testutil::AllocationCounter allocations{state};
+ *     for (auto _ : state) {
+ *       ...
+ *     }
+ *
+ * Allocations by all threads are counted, including those of background
+ * threads the benchmark starts. Call `Pause` and `Resume` around work that
+ * should not be counted, typically along with `state.PauseTiming()` and
+ * `state.ResumeTiming()`.
+ */
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State& state);
+
+  /** Reports the counters. */
+  ~AllocationCounter();
+
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+  void Pause();
+  void Resume();
+
+ private:
+  benchmark::State& state_;
+  AllocationStats start_;
+  AllocationStats counted_;
+  bool paused_ = false;
+};
+
+}  // namespace testutil
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_ALLOCATION_TRACKING_H_
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/firebase/firestore/testutil/sync_engine_testing.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/auth/empty_credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/test/firebase/firestore/testutil/async_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+
+namespace firebase {
+namespace firestore {
+namespace testutil {
+
+using auth::EmptyCredentialsProvider;
+using auth::User;
+using core::DatabaseInfo;
+using core::ViewSnapshot;
+using local::MemoryPersistence;
+using model::DatabaseId;
+using model::DocumentKeySet;
+using model::MaybeDocument;
+using model::OnlineState;
+using model::TargetId;
+using remote::Datastore;
+using remote::RemoteEvent;
+using remote::TargetChange;
+using util::Status;
+
+SyncEngineTester::SyncEngineTester(size_t max_concurrent_limbo_resolutions)
+    : persistence_(MemoryPersistence::WithEagerGarbageCollector()),
+      local_store_(
+          persistence_.get(), &query_engine_, User::Unauthenticated()),
+      worker_queue_(AsyncQueueForTesting()),
+      datastore_(std::make_shared<Datastore>(
+          DatabaseInfo(DatabaseId("project"), "persistence", "host",
+                       /*ssl_enabled=*/false),
+          worker_queue_, std::make_shared<EmptyCredentialsProvider>())),
+      remote_store_(
+          &local_store_, datastore_, worker_queue_, [](OnlineState) {}),
+      sync_engine_(&local_store_,
+                   &remote_store_,
+                   User::Unauthenticated(),
+                   max_concurrent_limbo_resolutions) {
+  datastore_->Start();
+  remote_store_.set_sync_engine(&sync_engine_);
+  sync_engine_.SetCallback(this);
+  worker_queue_->EnqueueBlocking([&] { local_store_.Start(); });
+}
+
+SyncEngineTester::~SyncEngineTester() {
+  worker_queue_->EnqueueBlocking([&] { remote_store_.Shutdown(); });
+}
+
+TargetId SyncEngineTester::Listen(const core::Query& query) {
+  TargetId target_id = 0;
+  worker_queue_->EnqueueBlocking(
+      [&] { target_id = sync_engine_.Listen(query); });
+  return target_id;
+}
+
+void SyncEngineTester::ApplyRemoteEvent(const RemoteEvent& remote_event) {
+  worker_queue_->EnqueueBlocking(
+      [&] { sync_engine_.ApplyRemoteEvent(remote_event); });
+}
+
+void SyncEngineTester::ApplyTargetChange(
+    TargetId target_id,
+    int64_t version,
+    DocumentKeySet added,
+    DocumentKeySet removed,
+    const std::vector<MaybeDocument>& docs) {
+  RemoteEvent::TargetChangeMap target_changes;
+  target_changes[target_id] =
+      TargetChange({}, /*current=*/true, std::move(added), DocumentKeySet{},
+                   std::move(removed));
+  RemoteEvent::DocumentUpdateMap document_updates;
+  for (const MaybeDocument& doc : docs) {
+    document_updates[doc.key()] = doc;
+  }
+
+  ApplyRemoteEvent(RemoteEvent(Version(version), std::move(target_changes),
+                               RemoteEvent::TargetSet{},
+                               std::move(document_updates), DocumentKeySet{}));
+}
+
+void SyncEngineTester::HandleRejectedListen(TargetId target_id,
+                                            Status error) {
+  worker_queue_->EnqueueBlocking([&] {
+    sync_engine_.HandleRejectedListen(target_id, std::move(error));
+  });
+}
+
+std::vector<ViewSnapshot> SyncEngineTester::TakeSnapshots() {
+  std::vector<ViewSnapshot> result;
+  // Snapshots are only recorded on the worker queue.
+  worker_queue_->EnqueueBlocking([&] { result.swap(snapshots_); });
+  return result;
+}
+
+void SyncEngineTester::HandleOnlineStateChange(OnlineState) {
+}
+
+void SyncEngineTester::OnViewSnapshots(std::vector<ViewSnapshot>&& snapshots) {
+  for (ViewSnapshot& snapshot : snapshots) {
+    snapshots_.push_back(std::move(snapshot));
+  }
+}
+
+void SyncEngineTester::OnError(const core::Query&, const Status&) {
+}
+
+}  // namespace testutil
+}  // namespace firestore
+}  // namespace firebase
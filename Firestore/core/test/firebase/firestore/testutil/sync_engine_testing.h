@@ -0,0 +1,106 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_SYNC_ENGINE_TESTING_H_
+#define FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_SYNC_ENGINE_TESTING_H_
+
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/sync_engine.h"
+#include "Firestore/core/src/firebase/firestore/core/sync_engine_callback.h"
+#include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/local/index_free_query_engine.h"
+#include "Firestore/core/src/firebase/firestore/local/local_store.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
+#include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace util {
+class AsyncQueue;
+}  // namespace util
+
+namespace testutil {
+
+/**
+ * Drives a `SyncEngine` backed by a memory `LocalStore` with remote events, as
+ * `RemoteStore` would. The network is never enabled, so listens are only
+ * recorded by the remote store. Like in the client, the sync engine is only
+ * called on the worker queue.
+ */
+class SyncEngineTester : public core::SyncEngineCallback {
+ public:
+  explicit SyncEngineTester(size_t max_concurrent_limbo_resolutions =
+                                core::SyncEngine::
+                                    kDefaultMaxConcurrentLimboResolutions);
+  ~SyncEngineTester();
+
+  /**
+   * Returns the sync engine. Only call methods that don't have side effects
+   * directly; use the methods below to change its state.
+   */
+  core::SyncEngine* sync_engine() {
+    return &sync_engine_;
+  }
+
+  model::TargetId Listen(const core::Query& query);
+
+  void ApplyRemoteEvent(const remote::RemoteEvent& remote_event);
+
+  /**
+   * Applies a remote event that adds and removes the given documents from the
+   * results of `target_id` and marks it as current.
+   */
+  void ApplyTargetChange(model::TargetId target_id,
+                         int64_t version,
+                         model::DocumentKeySet added,
+                         model::DocumentKeySet removed,
+                         const std::vector<model::MaybeDocument>& docs = {});
+
+  void HandleRejectedListen(model::TargetId target_id, util::Status error);
+
+  /** Returns the snapshots raised since the last call, in order. */
+  std::vector<core::ViewSnapshot> TakeSnapshots();
+
+  // Implements `SyncEngineCallback`
+  void HandleOnlineStateChange(model::OnlineState online_state) override;
+  void OnViewSnapshots(std::vector<core::ViewSnapshot>&& snapshots) override;
+  void OnError(const core::Query& query, const util::Status& error) override;
+
+ private:
+  std::unique_ptr<local::MemoryPersistence> persistence_;
+  local::IndexFreeQueryEngine query_engine_;
+  local::LocalStore local_store_;
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+  std::shared_ptr<remote::Datastore> datastore_;
+  remote::RemoteStore remote_store_;
+  core::SyncEngine sync_engine_;
+
+  std::vector<core::ViewSnapshot> snapshots_;
+};
+
+}  // namespace testutil
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_SYNC_ENGINE_TESTING_H_
@@ -44,6 +44,7 @@
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 
 namespace firebase {
 namespace firestore {
@@ -200,6 +201,27 @@ model::UnknownDocument UnknownDoc(absl::string_view key, int64_t version) {
   return model::UnknownDocument(Key(key), Version(version));
 }
 
+int ScatteredIndex(int index, int count) {
+  return static_cast<int>((index * int64_t{7919}) % count);
+}
+
+std::vector<Document> BenchmarkDocuments(absl::string_view collection,
+                                         int count,
+                                         int64_t version) {
+  std::vector<Document> docs;
+  docs.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    int value = ScatteredIndex(i, count);
+    docs.push_back(
+        Doc(absl::StrCat(collection, "/doc", i), version,
+            Map("author", absl::StrCat("user", i % 50), "text",
+                "The quick brown fox jumps over the lazy dog", "tags",
+                Array("one", "two", "three"), "bucket", value % 100, "value",
+                value, "meta", Map("likes", i % 1000))));
+  }
+  return docs;
+}
+
 DocumentComparator DocComparator(absl::string_view field_path) {
   return Query("docs").AddingOrderBy(OrderBy(field_path)).Comparator();
 }
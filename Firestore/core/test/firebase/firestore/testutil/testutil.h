@@ -239,6 +239,22 @@ model::NoDocument DeletedDoc(model::DocumentKey key,
 /** A convenience method for creating unknown docs for tests. */
 model::UnknownDocument UnknownDoc(absl::string_view key, int64_t version);
 
+/**
+ * Maps each `index` in [0, count) to a distinct value in [0, count), in an
+ * order unrelated to the indexes, provided `count` is not a multiple of 7919.
+ */
+int ScatteredIndex(int index, int count);
+
+/**
+ * Returns `count` documents named "<collection>/doc<i>" at `version`, shaped
+ * like a typical app document, for benchmarks. Each has a `bucket` in
+ * [0, 100) and a `value` in [0, count), both spread evenly and unrelated to
+ * the order of the keys.
+ */
+std::vector<model::Document> BenchmarkDocuments(absl::string_view collection,
+                                                int count,
+                                                int64_t version = 1);
+
 /**
  * Creates a DocumentComparator that will compare Documents by the given
  * field_path string then by key.
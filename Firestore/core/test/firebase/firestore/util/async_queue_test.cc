@@ -18,9 +18,12 @@
 
 #include <chrono>  // NOLINT(build/c++11)
 #include <future>  // NOLINT(build/c++11)
+#include <map>
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
 #include "absl/memory/memory.h"
 #include "gtest/gtest.h"
 
@@ -31,6 +34,8 @@ namespace {
 
 using testutil::Expectation;
 
+using Priority = AsyncQueue::Priority;
+
 // In these generic tests the specific timer ids don't matter.
 const TimerId kTimerId1 = TimerId::ListenStreamConnectionBackoff;
 const TimerId kTimerId2 = TimerId::ListenStreamIdle;
@@ -211,6 +216,158 @@ TEST_P(AsyncQueueTest, CanScheduleOprationsWithRespectsToShutdownState) {
   EXPECT_EQ(steps, "124");
 }
 
+TEST_P(AsyncQueueTest, RunsHigherPriorityLanesFirstAndKeepsLanesInOrder) {
+  Expectation blocked;
+  std::promise<void> unblock;
+  std::shared_future<void> unblocked = unblock.get_future().share();
+  queue->Enqueue([&] {
+    blocked.Fulfill();
+    unblocked.wait();
+  });
+  Await(blocked);
+
+  Expectation ran;
+  std::string steps;
+  queue->Enqueue(Priority::Background, [&] { steps += "b1 "; });
+  queue->Enqueue([&] { steps += "n1 "; });
+  queue->Enqueue(Priority::Interactive, [&] { steps += "i1 "; });
+  queue->Enqueue([&] { steps += "n2 "; });
+  queue->Enqueue(Priority::Interactive, [&] { steps += "i2 "; });
+  queue->Enqueue(Priority::Background, [&] {
+    steps += "b2";
+    ran.Fulfill();
+  });
+  unblock.set_value();
+
+  Await(ran);
+  EXPECT_EQ(steps, "i1 i2 n1 n2 b1 b2");
+}
+
+TEST_P(AsyncQueueTest, BoundsStarvationOfLowerPriorityLanes) {
+  Expectation blocked;
+  std::promise<void> unblock;
+  std::shared_future<void> unblocked = unblock.get_future().share();
+  queue->Enqueue([&] {
+    blocked.Fulfill();
+    unblocked.wait();
+  });
+  Await(blocked);
+
+  const int count = AsyncQueue::kMaxSkippedOperations * 3;
+  Expectation ran;
+  std::vector<std::string> steps;
+  queue->Enqueue(Priority::Background, [&] { steps.push_back("b"); });
+  queue->Enqueue([&] { steps.push_back("n"); });
+  for (int i = 0; i < count; ++i) {
+    queue->Enqueue(Priority::Interactive, [&, i] {
+      steps.push_back("i");
+      if (i == count - 1) ran.Fulfill();
+    });
+  }
+  unblock.set_value();
+
+  Await(ran);
+  ASSERT_EQ(steps.size(), static_cast<size_t>(count + 2));
+
+  // Both lower lanes are passed over the maximum number of times. Normal then
+  // goes first, since it has the higher priority, and Background right after.
+  int bound = AsyncQueue::kMaxSkippedOperations;
+  EXPECT_EQ(steps[bound], "n");
+  EXPECT_EQ(steps[bound + 1], "b");
+  for (int i = 0; i < count + 2; ++i) {
+    if (i != bound && i != bound + 1) {
+      EXPECT_EQ(steps[i], "i");
+    }
+  }
+}
+
+TEST_P(AsyncQueueTest, PrioritizedOperationsRunBeforeShutdown) {
+  Expectation blocked;
+  std::promise<void> unblock;
+  std::shared_future<void> unblocked = unblock.get_future().share();
+  queue->Enqueue([&] {
+    blocked.Fulfill();
+    unblocked.wait();
+  });
+  Await(blocked);
+
+  Expectation ran;
+  std::string steps;
+  queue->Enqueue(Priority::Background, [&] { steps += '2'; });
+  queue->Enqueue(Priority::Interactive, [&] { steps += '1'; });
+  queue->EnqueueAndInitiateShutdown([&] { steps += '3'; });
+  queue->Enqueue(Priority::Interactive, [&] { steps += '4'; });
+  queue->EnqueueEvenAfterShutdown(ran.AsCallback());
+  unblock.set_value();
+
+  Await(ran);
+  EXPECT_EQ(steps, "123");
+}
+
+TEST_P(AsyncQueueTest, ProfilesOperationsByLabel) {
+  Metrics::Reset();
+  Metrics::SetEnabled(true);
+
+  Expectation blocked;
+  std::promise<void> unblock;
+  std::shared_future<void> unblocked = unblock.get_future().share();
+  queue->Enqueue([&] {
+    blocked.Fulfill();
+    unblocked.wait();
+  });
+  Await(blocked);
+
+  Expectation ran;
+  queue->Enqueue(Priority::Normal, "test.first", [] {});
+  queue->Enqueue(Priority::Normal, "test.first", [] {});
+  queue->Enqueue(Priority::Normal, "test.second", [&] {
+    queue->EnqueueAfterDelay(AsyncQueue::Milliseconds(1), kTimerId1,
+                             ran.AsCallback());
+  });
+  unblock.set_value();
+  Await(ran);
+  // Wait for the delayed operation to be recorded once it finishes.
+  queue->EnqueueBlocking([] {});
+
+  MetricsSnapshot snapshot = Metrics::Snapshot();
+  Metrics::SetEnabled(false);
+
+  std::map<std::string, HistogramSnapshot>& histograms = snapshot.histograms;
+  EXPECT_EQ(histograms["async_queue.test.first.wait"].count, 2);
+  EXPECT_EQ(histograms["async_queue.test.first.run"].count, 2);
+  EXPECT_EQ(histograms["async_queue.test.first.depth"].min, 1);
+  EXPECT_EQ(histograms["async_queue.test.first.depth"].max, 2);
+  EXPECT_EQ(histograms["async_queue.test.second.run"].count, 1);
+  EXPECT_EQ(histograms["async_queue.unlabeled.run"].count, 1);
+  HistogramSnapshot delayed_run =
+      histograms["async_queue.listen_stream_connection_backoff.run"];
+  EXPECT_EQ(delayed_run.count, 1);
+}
+
+TEST_P(AsyncQueueTest, DiscardedOperationsAreNotPending) {
+  Metrics::Reset();
+  Metrics::SetEnabled(true);
+
+  Expectation ran;
+  queue->Enqueue([&] {
+    DelayedOperation delayed_operation = queue->EnqueueAfterDelay(
+        AsyncQueue::Milliseconds(1), kTimerId1, [] {});
+    delayed_operation.Cancel();
+
+    queue->EnqueueAfterDelay(AsyncQueue::Milliseconds(1), kTimerId1,
+                             ran.AsCallback());
+  });
+  Await(ran);
+
+  MetricsSnapshot snapshot = Metrics::Snapshot();
+  Metrics::SetEnabled(false);
+
+  HistogramSnapshot depth =
+      snapshot.histograms["async_queue.listen_stream_connection_backoff.depth"];
+  EXPECT_EQ(depth.count, 2);
+  EXPECT_EQ(depth.max, 1);
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
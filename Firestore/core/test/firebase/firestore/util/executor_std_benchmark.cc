@@ -0,0 +1,143 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <future>  // NOLINT(build/c++11)
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+constexpr int kOperationsPerProducer = 10000;
+
+/**
+ * Runs `push` `kOperationsPerProducer` times on each of `producers` threads
+ * started at the same time, and waits for all of them to finish.
+ */
+template <typename Push>
+void RunProducers(int producers, const Push& push) {
+  std::promise<void> start;
+  std::shared_future<void> started = start.get_future().share();
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&push, started] {
+      started.wait();
+      for (int i = 0; i < kOperationsPerProducer; ++i) {
+        push(i);
+      }
+    });
+  }
+
+  start.set_value();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+void SetItemsProcessed(benchmark::State& state) {
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          kOperationsPerProducer);
+}
+
+/** Enqueues into the mutex-guarded schedule that `ExecutorStd` used to use. */
+void BM_SchedulePush(benchmark::State& state) {
+  int producers = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    async::Schedule<int> schedule;
+    RunProducers(producers, [&](int i) {
+      schedule.Push(i, async::Schedule<int>::TimePoint{});
+    });
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK(BM_SchedulePush)->Arg(1)->Arg(8)->UseRealTime();
+
+void BM_MpscQueuePush(benchmark::State& state) {
+  int producers = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    async::MpscQueue<int> queue;
+    RunProducers(producers, [&](int i) { queue.Push(i); });
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK(BM_MpscQueuePush)->Arg(1)->Arg(8)->UseRealTime();
+
+/**
+ * Measures end-to-end throughput of a serial executor fed by several threads,
+ * as `AsyncQueue` is.
+ */
+void BM_ExecutorStdExecute(benchmark::State& state) {
+  int producers = static_cast<int>(state.range(0));
+  ExecutorStd executor{/*threads=*/1};
+
+  for (auto _ : state) {
+    std::atomic<int> remaining{producers * kOperationsPerProducer};
+    std::promise<void> done;
+    RunProducers(producers, [&](int) {
+      executor.Execute([&] {
+        if (--remaining == 0) done.set_value();
+      });
+    });
+    done.get_future().wait();
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK(BM_ExecutorStdExecute)->Arg(1)->Arg(8)->UseRealTime();
+
+void BM_ExecutorStdSchedule(benchmark::State& state) {
+  int producers = static_cast<int>(state.range(0));
+  ExecutorStd executor{/*threads=*/1};
+
+  for (auto _ : state) {
+    std::vector<DelayedOperation> operations;
+    std::mutex mutex;
+    RunProducers(producers, [&](int i) {
+      DelayedOperation operation =
+          executor.Schedule(std::chrono::milliseconds(60000 + i),
+                            Executor::TaggedOperation{/*tag=*/1, [] {}});
+      // Cancel half of the operations, as the LRU GC and backoff timers do.
+      if (i % 2 == 0) {
+        operation.Cancel();
+      } else {
+        std::lock_guard<std::mutex> lock{mutex};
+        operations.push_back(std::move(operation));
+      }
+    });
+
+    state.PauseTiming();
+    for (DelayedOperation& operation : operations) {
+      operation.Cancel();
+    }
+    state.ResumeTiming();
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK(BM_ExecutorStdSchedule)->Arg(1)->Arg(8)->UseRealTime();
+
+}  // namespace
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
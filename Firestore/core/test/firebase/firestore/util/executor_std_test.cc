@@ -16,11 +16,15 @@
 
 #include "Firestore/core/test/firebase/firestore/util/executor_test.h"
 
+#include <algorithm>
 #include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <cstdlib>
 #include <future>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/executor_std.h"
 #include "Firestore/core/test/firebase/firestore/testutil/async_testing.h"
@@ -229,6 +233,210 @@ TEST_F(ScheduleTest, PopBlockingIsNotAffectedByIrrelevantRemovals) {
   Await(future);
 }
 
+// MpscQueue tests
+
+TEST(MpscQueueTest, PopsInPushOrder) {
+  async::MpscQueue<int> queue;
+  EXPECT_TRUE(queue.empty());
+
+  int value = 0;
+  EXPECT_FALSE(queue.Pop(&value));
+
+  queue.Push(1);
+  queue.Push(2);
+  queue.Push(3);
+  EXPECT_FALSE(queue.empty());
+
+  for (int expected : {1, 2, 3}) {
+    ASSERT_TRUE(queue.Pop(&value));
+    EXPECT_EQ(value, expected);
+  }
+  EXPECT_FALSE(queue.Pop(&value));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpscQueueTest, KeepsEachProducersOrder) {
+  constexpr int kProducers = 4;
+  constexpr int kValuesPerProducer = 10000;
+
+  async::MpscQueue<std::pair<int, int>> queue;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kValuesPerProducer; ++i) {
+        queue.Push({p, i});
+      }
+    });
+  }
+
+  std::vector<int> next(kProducers, 0);
+  int popped = 0;
+  std::pair<int, int> value;
+  while (popped < kProducers * kValuesPerProducer) {
+    if (!queue.Pop(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(value.second, next[value.first]);
+    ++next[value.first];
+    ++popped;
+  }
+
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+// TimerWheel tests
+
+class TimerWheelTest : public ::testing::Test {
+ public:
+  using Wheel = async::TimerWheel<int, int>;
+
+  Wheel::TimePoint At(int64_t ms) {
+    return Wheel::TimePoint{chr::milliseconds(ms)};
+  }
+
+  // Pops all entries that are due at `now`.
+  std::vector<int> PopAllDue(int64_t now) {
+    std::vector<int> result;
+    while (absl::optional<int> value = wheel.PopDue(At(now))) {
+      result.push_back(*value);
+    }
+    return result;
+  }
+
+  Wheel wheel;
+};
+
+TEST_F(TimerWheelTest, PopsEntriesWhenDue) {
+  wheel.Push(1, 1, At(10), At(0));
+  wheel.Push(2, 2, At(20), At(0));
+  EXPECT_EQ(wheel.size(), 2u);
+
+  EXPECT_EQ(PopAllDue(9), std::vector<int>{});
+  EXPECT_EQ(PopAllDue(10), std::vector<int>{1});
+  EXPECT_EQ(PopAllDue(19), std::vector<int>{});
+  EXPECT_EQ(PopAllDue(25), std::vector<int>{2});
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST_F(TimerWheelTest, Ordering) {
+  // Push values in a deliberately non-sorted order, with ties.
+  wheel.Push(1, 1, At(30), At(0));
+  wheel.Push(2, 2, At(10), At(0));
+  wheel.Push(3, 3, At(30), At(0));
+  wheel.Push(4, 4, At(5000), At(0));
+  wheel.Push(5, 5, At(10), At(0));
+
+  EXPECT_EQ(PopAllDue(10000), (std::vector<int>{2, 5, 1, 3, 4}));
+}
+
+TEST_F(TimerWheelTest, OverdueEntriesAreOrderedByDueTime) {
+  wheel.Push(1, 1, At(100), At(0));
+  EXPECT_EQ(PopAllDue(50), std::vector<int>{});
+
+  // Both are overdue by the time they are pushed.
+  wheel.Push(2, 2, At(40), At(60));
+  wheel.Push(3, 3, At(30), At(60));
+
+  EXPECT_EQ(PopAllDue(200), (std::vector<int>{3, 2, 1}));
+}
+
+TEST_F(TimerWheelTest, CascadesLongDelays) {
+  // Spread entries over several levels of the wheel.
+  std::vector<int64_t> delays = {1,    63,    64,     65,     4095,
+                                 4096, 4097,  100000, 262144, 300000,
+                                 5,    70000, 2,      999999};
+  for (size_t i = 0; i < delays.size(); ++i) {
+    wheel.Push(static_cast<int>(i), static_cast<int>(i), At(delays[i]), At(0));
+  }
+
+  std::vector<int> expected(delays.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    expected[i] = static_cast<int>(i);
+  }
+  std::sort(expected.begin(), expected.end(), [&](int lhs, int rhs) {
+    return delays[lhs] < delays[rhs];
+  });
+
+  // Advance in uneven steps, checking nothing expires early or late.
+  std::vector<int> actual;
+  for (int64_t now = 0; now <= 1000000; now += 37) {
+    for (int value : PopAllDue(now)) {
+      EXPECT_LE(delays[value], now);
+      EXPECT_GT(delays[value], now - 37);
+      actual.push_back(value);
+    }
+  }
+  EXPECT_EQ(actual, expected);
+}
+
+TEST_F(TimerWheelTest, Remove) {
+  wheel.Push(1, 1, At(10), At(0));
+  wheel.Push(2, 2, At(10), At(0));
+  wheel.Push(3, 3, At(100000), At(0));
+
+  EXPECT_EQ(wheel.Remove(2), absl::optional<int>{2});
+  EXPECT_EQ(wheel.Remove(2), absl::nullopt);
+  EXPECT_EQ(wheel.Remove(3), absl::optional<int>{3});
+  EXPECT_EQ(wheel.size(), 1u);
+
+  EXPECT_EQ(PopAllDue(200000), std::vector<int>{1});
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST_F(TimerWheelTest, NextDueIsALowerBound) {
+  EXPECT_EQ(wheel.NextDue(), absl::nullopt);
+
+  wheel.Push(1, 1, At(5000), At(0));
+  wheel.Push(2, 2, At(70), At(0));
+
+  absl::optional<Wheel::TimePoint> next = wheel.NextDue();
+  ASSERT_TRUE(next.has_value());
+  EXPECT_LE(*next, At(70));
+  EXPECT_GT(*next, At(0));
+
+  EXPECT_EQ(PopAllDue(70), std::vector<int>{2});
+  next = wheel.NextDue();
+  ASSERT_TRUE(next.has_value());
+  EXPECT_LE(*next, At(5000));
+  EXPECT_GT(*next, At(70));
+}
+
+TEST_F(TimerWheelTest, NextDueCoversSlotsCascadingNow) {
+  wheel.Push(1, 1, At(100), At(0));
+
+  // The wheel now stands at the start of the block holding the entry.
+  EXPECT_EQ(PopAllDue(63), std::vector<int>{});
+  absl::optional<Wheel::TimePoint> next = wheel.NextDue();
+  ASSERT_TRUE(next.has_value());
+  EXPECT_LE(*next, At(100));
+}
+
+TEST_F(TimerWheelTest, SkipsIdleTime) {
+  // Advancing one tick at a time would take days here.
+  int64_t far = int64_t{1} << 35;
+  wheel.Push(1, 1, At(far), At(0));
+  wheel.Push(2, 2, At(far + 1), At(0));
+
+  EXPECT_EQ(PopAllDue(far - 1), std::vector<int>{});
+  EXPECT_EQ(PopAllDue(far), std::vector<int>{1});
+  EXPECT_EQ(PopAllDue(2 * far), std::vector<int>{2});
+}
+
+TEST_F(TimerWheelTest, PopEarliestIgnoresDueTime) {
+  wheel.Push(1, 1, At(500), At(0));
+  wheel.Push(2, 2, At(100), At(0));
+
+  EXPECT_EQ(wheel.PopEarliest(), absl::optional<int>{2});
+  EXPECT_TRUE(wheel.Contains([](int v) { return v == 1; }));
+  EXPECT_FALSE(wheel.Contains([](int v) { return v == 2; }));
+  EXPECT_EQ(wheel.PopEarliest(), absl::optional<int>{1});
+  EXPECT_EQ(wheel.PopEarliest(), absl::nullopt);
+}
+
 // ExecutorStd tests
 
 namespace {
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+class MetricsTest : public testing::Test {
+ public:
+  MetricsTest() {
+    Metrics::Reset();
+    Metrics::SetEnabled(true);
+  }
+
+  ~MetricsTest() override {
+    Metrics::SetEnabled(false);
+    Metrics::Reset();
+  }
+};
+
+TEST_F(MetricsTest, CountersAccumulate) {
+  for (int i = 0; i < 3; ++i) {
+    METRICS_COUNTER_ADD("metrics_test.counter", 2);
+  }
+
+  MetricsSnapshot snapshot = Metrics::Snapshot();
+  EXPECT_EQ(snapshot.counters["metrics_test.counter"], 6);
+  EXPECT_EQ(Metrics::GetCounter("metrics_test.counter")->value(), 6);
+}
+
+TEST_F(MetricsTest, DisabledMetricsRecordNothing) {
+  Metrics::SetEnabled(false);
+
+  int evaluated = 0;
+  METRICS_COUNTER_ADD("metrics_test.disabled", ++evaluated);
+  METRICS_HISTOGRAM_RECORD("metrics_test.disabled", ++evaluated);
+
+  EXPECT_EQ(evaluated, 0);
+  MetricsSnapshot snapshot = Metrics::Snapshot();
+  EXPECT_EQ(snapshot.counters.count("metrics_test.disabled"), 0u);
+  EXPECT_EQ(snapshot.histograms.count("metrics_test.disabled"), 0u);
+}
+
+TEST_F(MetricsTest, HistogramTracksDistribution) {
+  for (int64_t value = 1; value <= 100; ++value) {
+    METRICS_HISTOGRAM_RECORD("metrics_test.histogram", value);
+  }
+
+  HistogramSnapshot histogram =
+      Metrics::Snapshot().histograms["metrics_test.histogram"];
+  EXPECT_EQ(histogram.count, 100);
+  EXPECT_EQ(histogram.sum, 5050);
+  EXPECT_EQ(histogram.min, 1);
+  EXPECT_EQ(histogram.max, 100);
+  EXPECT_DOUBLE_EQ(histogram.Mean(), 50.5);
+
+  // Percentiles are upper bounds, accurate to within a factor of two.
+  int64_t p50 = histogram.Percentile(50);
+  EXPECT_GE(p50, 50);
+  EXPECT_LT(p50, 100);
+  EXPECT_EQ(histogram.Percentile(100), 100);
+  EXPECT_EQ(histogram.Percentile(0), 1);
+}
+
+TEST_F(MetricsTest, EmptyHistogram) {
+  HistogramSnapshot histogram =
+      Metrics::GetHistogram("metrics_test.empty")->Snapshot();
+  EXPECT_EQ(histogram.count, 0);
+  EXPECT_EQ(histogram.min, 0);
+  EXPECT_EQ(histogram.max, 0);
+  EXPECT_EQ(histogram.Percentile(99), 0);
+  EXPECT_EQ(histogram.Mean(), 0);
+}
+
+TEST_F(MetricsTest, ResetKeepsMetricsRegistered) {
+  Counter* counter = Metrics::GetCounter("metrics_test.reset");
+  counter->Add(5);
+  METRICS_HISTOGRAM_RECORD("metrics_test.reset", 5);
+
+  Metrics::Reset();
+
+  EXPECT_EQ(Metrics::GetCounter("metrics_test.reset"), counter);
+  EXPECT_EQ(counter->value(), 0);
+  EXPECT_EQ(Metrics::Snapshot().histograms["metrics_test.reset"].count, 0);
+}
+
+TEST_F(MetricsTest, SnapshotToString) {
+  METRICS_COUNTER_ADD("metrics_test.to_string", 7);
+
+  std::string description = Metrics::Snapshot().ToString();
+  EXPECT_NE(description.find("metrics_test.to_string: 7\n"),
+            std::string::npos);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
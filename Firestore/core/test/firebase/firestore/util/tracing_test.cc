@@ -0,0 +1,120 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+int CountOccurrences(const std::string& haystack, const std::string& needle) {
+  int result = 0;
+  for (size_t pos = haystack.find(needle); pos != std::string::npos;
+       pos = haystack.find(needle, pos + 1)) {
+    ++result;
+  }
+  return result;
+}
+
+void TracedOperation() {
+  TRACE_SPAN("tracing_test.operation");
+}
+
+}  // namespace
+
+class TracingTest : public testing::Test {
+ public:
+  TracingTest() {
+    Metrics::Reset();
+  }
+
+  ~TracingTest() override {
+    Tracing::Stop();
+    Metrics::SetEnabled(false);
+    Metrics::Reset();
+  }
+};
+
+TEST_F(TracingTest, SpansRecordIntoHistograms) {
+  Metrics::SetEnabled(true);
+
+  TracedOperation();
+  TracedOperation();
+
+  HistogramSnapshot histogram =
+      Metrics::Snapshot().histograms["tracing_test.operation"];
+  EXPECT_EQ(histogram.count, 2);
+  EXPECT_GE(histogram.min, 0);
+}
+
+TEST_F(TracingTest, DisabledSpansRecordNothing) {
+  TracedOperation();
+
+  Metrics::SetEnabled(true);
+  EXPECT_EQ(Metrics::Snapshot().histograms["tracing_test.operation"].count, 0);
+}
+
+TEST_F(TracingTest, ExportsChromeTrace) {
+  Tracing::Start();
+  TracedOperation();
+  TRACE_COUNTER("tracing_test.depth", 3);
+  Tracing::Stop();
+
+  // Not recorded after stopping.
+  TracedOperation();
+
+  std::string trace = Tracing::ExportChromeTrace();
+  EXPECT_EQ(trace.find("{\"traceEvents\":["), 0u);
+  EXPECT_EQ(CountOccurrences(trace, "\"name\":\"tracing_test.operation\""), 1);
+  EXPECT_EQ(CountOccurrences(trace, "\"ph\":\"X\""), 1);
+  EXPECT_EQ(CountOccurrences(trace, "\"dur\":"), 1);
+  EXPECT_EQ(CountOccurrences(trace, "\"name\":\"tracing_test.depth\""), 1);
+  EXPECT_EQ(CountOccurrences(trace, "\"ph\":\"C\""), 1);
+  EXPECT_NE(trace.find("\"args\":{\"value\":3}"), std::string::npos);
+  EXPECT_NE(trace.find("\"dropped_events\":0"), std::string::npos);
+}
+
+TEST_F(TracingTest, DropsEventsBeyondLimit) {
+  Tracing::Start(2);
+  for (int i = 0; i < 5; ++i) {
+    TracedOperation();
+  }
+  Tracing::Stop();
+
+  std::string trace = Tracing::ExportChromeTrace();
+  EXPECT_EQ(CountOccurrences(trace, "\"ph\":\"X\""), 2);
+  EXPECT_NE(trace.find("\"dropped_events\":3"), std::string::npos);
+}
+
+TEST_F(TracingTest, StartDiscardsPreviousEvents) {
+  Tracing::Start();
+  TracedOperation();
+  Tracing::Start();
+  Tracing::Stop();
+
+  std::string trace = Tracing::ExportChromeTrace();
+  EXPECT_EQ(CountOccurrences(trace, "\"ph\":\"X\""), 0);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
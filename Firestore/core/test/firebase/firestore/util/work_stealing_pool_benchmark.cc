@@ -0,0 +1,94 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/background_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/work_stealing_pool.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+const char* kLabel = "com.google.firebase.firestore.benchmark";
+
+int Threads() {
+  unsigned int threads = std::thread::hardware_concurrency();
+  return threads == 0 ? 4 : static_cast<int>(threads);
+}
+
+/** A small task, comparable to decoding a small document. */
+uint64_t SmallTask(size_t i) {
+  uint64_t hash = i;
+  for (int round = 0; round < 16; ++round) {
+    hash = hash * 6364136223846793005u + 1442695040888963407u;
+  }
+  return hash;
+}
+
+void BM_BackgroundQueueClosurePerItem(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  std::unique_ptr<Executor> executor =
+      Executor::CreateConcurrent(kLabel, Threads());
+  std::vector<uint64_t> results(count);
+
+  for (auto _ : state) {
+    BackgroundQueue tasks(executor.get());
+    for (size_t i = 0; i != count; ++i) {
+      tasks.Execute([&results, i] { results[i] = SmallTask(i); });
+    }
+    tasks.AwaitAll();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BackgroundQueueClosurePerItem)->Arg(100000)->UseRealTime();
+
+void BM_WorkStealingPoolParallelFor(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  WorkStealingPool pool(kLabel, Threads());
+  std::vector<uint64_t> results(count);
+
+  for (auto _ : state) {
+    pool.ParallelFor(count,
+                     [&results](size_t i) { results[i] = SmallTask(i); });
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WorkStealingPoolParallelFor)->Arg(100000)->UseRealTime();
+
+void BM_WorkStealingPoolParallelMap(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  WorkStealingPool pool(kLabel, Threads());
+
+  for (auto _ : state) {
+    std::vector<uint64_t> results = pool.ParallelMap<uint64_t>(
+        count, [](size_t i) { return SmallTask(i); });
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WorkStealingPoolParallelMap)->Arg(100000)->UseRealTime();
+
+}  // namespace
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/work_stealing_pool.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <mutex>   // NOLINT(build/c++11)
+#include <set>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+const char* kLabel = "com.google.firebase.firestore.test";
+
+}  // namespace
+
+TEST(WorkStealingPoolTest, ParallelForRunsEachIndexOnce) {
+  WorkStealingPool pool{kLabel, 4};
+
+  for (size_t count : {0, 1, 2, 3, 4, 5, 17, 1000, 100000}) {
+    std::vector<std::atomic<int>> runs(count);
+    pool.ParallelFor(count, [&](size_t i) { ++runs[i]; });
+
+    for (size_t i = 0; i != count; ++i) {
+      ASSERT_EQ(runs[i].load(), 1) << "index " << i << " of " << count;
+    }
+  }
+}
+
+TEST(WorkStealingPoolTest, ParallelMapKeepsResultsInOrder) {
+  WorkStealingPool pool{kLabel, 4};
+
+  std::vector<std::string> results = pool.ParallelMap<std::string>(
+      1000, [](size_t i) { return std::to_string(i); });
+
+  ASSERT_EQ(results.size(), 1000u);
+  for (size_t i = 0; i != results.size(); ++i) {
+    EXPECT_EQ(results[i], std::to_string(i));
+  }
+}
+
+TEST(WorkStealingPoolTest, RunsOnTheCallingThreadWithASingleThread) {
+  WorkStealingPool pool{kLabel, 1};
+  std::thread::id caller = std::this_thread::get_id();
+
+  pool.ParallelFor(100, [&](size_t) {
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+  });
+}
+
+TEST(WorkStealingPoolTest, IdleThreadsStealFromBusyOnes) {
+  WorkStealingPool pool{kLabel, 2};
+
+  // All the slow items initially belong to the first thread, which can't get
+  // through them before the second one is done with its own range.
+  std::mutex mutex;
+  std::set<std::thread::id> slow_threads;
+  pool.ParallelFor(64, [&](size_t i) {
+    if (i < 32) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      std::lock_guard<std::mutex> lock{mutex};
+      slow_threads.insert(std::this_thread::get_id());
+    }
+  });
+
+  EXPECT_EQ(slow_threads.size(), 2u);
+}
+
+TEST(WorkStealingPoolTest, CanBeUsedFromSeveralThreads) {
+  WorkStealingPool pool{kLabel, 4};
+
+  std::atomic<int> total{0};
+  std::vector<std::thread> callers;
+  for (int c = 0; c < 4; ++c) {
+    callers.emplace_back([&] {
+      for (int loop = 0; loop < 10; ++loop) {
+        pool.ParallelFor(1000, [&](size_t) { ++total; });
+      }
+    });
+  }
+  for (std::thread& caller : callers) {
+    caller.join();
+  }
+
+  EXPECT_EQ(total.load(), 4 * 10 * 1000);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase